@@ -0,0 +1,82 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include "./libs/terminal.hpp"
+#include "./libs/arena.hpp"
+
+using namespace std::chrono;
+
+// Headless scaling benchmark: ticks/sec of the bot arena as snakes are added
+
+void usage(const char *name) {
+    printf("Usage: %s [--snakes=100,250,500,1000] [--rows=400] [--cols=800]\n", name);
+    printf("          [--ticks=500] [--threads=N] [--food=N] [--seed=N]\n");
+}
+
+std::vector<int> parseList(const char *text) {
+    std::vector<int> values;
+    while (*text) {
+        values.push_back(std::atoi(text));
+        const char *comma = std::strchr(text, ',');
+        if (!comma) break;
+        text = comma + 1;
+    }
+    return values;
+}
+
+int main(int argc, char **argv) {
+
+    std::vector<int> counts = parseList("100,250,500,1000");
+    int rows = 400;
+    int cols = 800;
+    int ticks = 500;
+    int threads = static_cast<int>(std::thread::hardware_concurrency());
+    int food = 0;
+    unsigned int seed = 42;
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        if (std::strncmp(arg, "--snakes=", 9) == 0) counts = parseList(arg + 9);
+        else if (std::strncmp(arg, "--rows=", 7) == 0) rows = std::atoi(arg + 7);
+        else if (std::strncmp(arg, "--cols=", 7) == 0) cols = std::atoi(arg + 7);
+        else if (std::strncmp(arg, "--ticks=", 8) == 0) ticks = std::atoi(arg + 8);
+        else if (std::strncmp(arg, "--threads=", 10) == 0) threads = std::atoi(arg + 10);
+        else if (std::strncmp(arg, "--food=", 7) == 0) food = std::atoi(arg + 7);
+        else if (std::strncmp(arg, "--seed=", 7) == 0) seed = std::strtoul(arg + 7, nullptr, 10);
+        else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (threads < 1) threads = 1;
+    if (rows < 8 || cols < 8 || ticks < 1) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    printf("Arena: %dx%d board, %d threads, %d ticks per run\n", rows, cols, threads, ticks);
+    printf("%8s %12s %10s %8s %8s\n", "snakes", "ticks/s", "us/tick", "alive", "food");
+
+    for (size_t c = 0; c < counts.size(); c++) {
+        int snakes = counts[c];
+        if (snakes < 1 || snakes > Grid::MAX_OWNERS) continue;
+
+        Arena arena(rows, cols, snakes, food > 0 ? food : snakes / 2 + 1, seed, threads);
+
+        steady_clock::time_point start = steady_clock::now();
+        for (int t = 0; t < ticks; t++) {
+            arena.tick();
+        }
+        double seconds = duration_cast<duration<double> >(steady_clock::now() - start).count();
+
+        printf("%8d %12.1f %10.2f %8d %8d\n", snakes, ticks / seconds,
+               seconds * 1e6 / ticks, arena.getMatch().getAlive(),
+               static_cast<int>(arena.getMatch().getFoods().size()));
+    }
+
+    return 0;
+}
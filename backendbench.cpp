@@ -0,0 +1,95 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include "./libs/backend.hpp"
+#include "./libs/matchview.hpp"
+
+using namespace std::chrono;
+
+#define MATCH_TICKS 1000
+
+// Renders the same scripted match on whichever backend this was built with
+
+void usage(const char *name) {
+    printf("Usage: %s [--frames=5000] [--rows=40] [--cols=120] [--players=4] [--seed=N] [--tty]\n", name);
+}
+
+// Turns are fixed by tick, so every backend draws the same frames: each
+// snake walks an 11x11 square next to its spawn point
+int scriptedTurn(unsigned long tick, int direction) {
+    if (tick % 11 != 10) return direction;
+    static const int clockwise[] = { 0, 0, LEFT, RIGHT, UP, DOWN };  // DOWN -> LEFT, UP -> RIGHT, ...
+    return clockwise[direction];
+}
+
+int main(int argc, char **argv) {
+
+    int frames = 5000;
+    int rows = 40;
+    int cols = 120;
+    int players = 4;
+    unsigned int seed = 42;
+    bool tty = false;
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        if (std::strncmp(arg, "--frames=", 9) == 0) frames = std::atoi(arg + 9);
+        else if (std::strncmp(arg, "--rows=", 7) == 0) rows = std::atoi(arg + 7);
+        else if (std::strncmp(arg, "--cols=", 7) == 0) cols = std::atoi(arg + 7);
+        else if (std::strncmp(arg, "--players=", 10) == 0) players = std::atoi(arg + 10);
+        else if (std::strncmp(arg, "--seed=", 7) == 0) seed = static_cast<unsigned int>(std::atoi(arg + 7));
+        else if (std::strcmp(arg, "--tty") == 0) tty = true;
+        else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (frames < 1 || rows < 8 || cols < 16 || players < 1 || players > MAX_PLAYERS) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    // Without --tty the frames still get encoded and written, just to /dev/null
+    FILE *out = tty ? stdout : fopen("/dev/null", "w");
+    if (out == nullptr || !Backend::open(rows + 1, cols, out)) {
+        fprintf(stderr, "cannot open the %s backend\n", Backend::name());
+        return 1;
+    }
+
+    Match match(rows, cols, players, 2, seed);
+    MatchView view(match);
+    int directions[MAX_PLAYERS] = { RIGHT, LEFT, RIGHT, LEFT };
+    unsigned long matches = 1;
+
+    view.drawBoard();
+    refresh();
+
+    steady_clock::time_point start = steady_clock::now();
+    for (int frame = 0; frame < frames; frame++) {
+        if (match.isOver() || match.getTick() >= MATCH_TICKS) {
+            // A fresh match repaints the whole board, like a new game does
+            match.reset(seed + static_cast<unsigned int>(matches++));
+            for (int p = 0; p < players; p++) directions[p] = p % 2 == 0 ? RIGHT : LEFT;
+            clear();
+            view.drawBoard();
+        } else {
+            for (int p = 0; p < players; p++) {
+                directions[p] = scriptedTurn(match.getTick(), directions[p]);
+                match.setDirection(p, directions[p]);
+            }
+            match.step();
+            view.drawDirty();
+        }
+        refresh();
+    }
+    double seconds = duration<double>(steady_clock::now() - start).count();
+
+    Backend::stop();
+    if (!tty) fclose(out);
+
+    printf("%-9s %d frames, %lu matches on %dx%d: %.0f ns/frame, %.0f frames/s\n",
+           Backend::name(), frames, matches, rows, cols,
+           seconds * 1e9 / frames, frames / seconds);
+    return 0;
+}
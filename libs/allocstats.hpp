@@ -0,0 +1,128 @@
+#ifndef ALLOCSTATS_H_
+#define ALLOCSTATS_H_
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <atomic>
+#include <new>
+
+/**
+ * Heap allocation accounting, compiled in with -DTSNAKE_ALLOC_STATS
+ * (make allocstats).
+ *
+ * The global operator new and delete are replaced by versions that count
+ * every allocation and its size, and AllocScope charges the allocations
+ * made inside a block to one phase: a game tick, a screen refresh or a
+ * menu frame. Without the define the scopes are empty and nothing is
+ * replaced.
+ *
+ * The replacements are ordinary (non-inline) definitions, so this header
+ * belongs in one translation unit per binary, as every header here does.
+ */
+
+enum AllocPhaseId {
+    ALLOC_TICK,     // a game tick, its refresh included
+    ALLOC_REFRESH,  // one screen flush
+    ALLOC_MENU,     // one menu frame: draw, refresh and input
+    ALLOC_PHASES
+};
+
+struct AllocCount {
+    unsigned long allocations;
+    unsigned long long bytes;
+};
+
+/**
+ * @brief Allocations charged to one phase over all of its runs
+ */
+struct AllocPhase {
+    unsigned long runs;
+    unsigned long allocations;
+    unsigned long long bytes;
+    unsigned long worstRun;     // most allocations in a single run
+};
+
+#ifdef TSNAKE_ALLOC_STATS
+
+static std::atomic<unsigned long> g_alloc_allocations(0);
+static std::atomic<unsigned long long> g_alloc_bytes(0);
+static AllocPhase g_alloc_phases[ALLOC_PHASES];
+
+void *operator new(size_t size) {
+    g_alloc_allocations.fetch_add(1, std::memory_order_relaxed);
+    g_alloc_bytes.fetch_add(size, std::memory_order_relaxed);
+    void *p = std::malloc(size ? size : 1);
+    if (p == nullptr) throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void *p) noexcept {
+    std::free(p);
+}
+
+inline AllocCount alloc_count() {
+    AllocCount count;
+    count.allocations = g_alloc_allocations.load(std::memory_order_relaxed);
+    count.bytes = g_alloc_bytes.load(std::memory_order_relaxed);
+    return count;
+}
+
+class AllocScope {
+
+    AllocPhaseId phase;
+    AllocCount start;
+
+public:
+
+    explicit AllocScope(AllocPhaseId phase) : phase(phase), start(alloc_count()) {}
+
+    ~AllocScope() {
+        AllocCount end = alloc_count();
+        AllocPhase &p = g_alloc_phases[phase];
+        unsigned long allocations = end.allocations - start.allocations;
+        p.runs++;
+        p.allocations += allocations;
+        p.bytes += end.bytes - start.bytes;
+        if (allocations > p.worstRun) p.worstRun = allocations;
+    }
+
+    AllocScope(const AllocScope &) = delete;
+    AllocScope &operator=(const AllocScope &) = delete;
+};
+
+inline const AllocPhase &alloc_phase(AllocPhaseId phase) {
+    return g_alloc_phases[phase];
+}
+
+inline void alloc_reset_phases() {
+    std::memset(g_alloc_phases, 0, sizeof(g_alloc_phases));
+}
+
+/**
+ * @brief Allocations and bytes per run of every phase that ran
+ */
+inline void alloc_report(FILE *out) {
+    static const char *names[ALLOC_PHASES] = { "tick", "refresh", "menu" };
+
+    AllocCount total = alloc_count();
+    fprintf(out, "heap: %lu allocations, %llu bytes in total\n", total.allocations, total.bytes);
+    fprintf(out, "%-8s %8s %12s %12s %12s %12s\n", "phase", "runs", "allocs", "allocs/run", "bytes/run", "worst run");
+    for (int i = 0; i < ALLOC_PHASES; i++) {
+        const AllocPhase &p = g_alloc_phases[i];
+        if (p.runs == 0) continue;
+        fprintf(out, "%-8s %8lu %12lu %12.3f %12.1f %12lu\n", names[i], p.runs, p.allocations,
+                static_cast<double>(p.allocations) / p.runs, static_cast<double>(p.bytes) / p.runs, p.worstRun);
+    }
+}
+
+#else
+
+class AllocScope {
+public:
+    explicit AllocScope(AllocPhaseId) {}
+};
+
+#endif
+
+#endif
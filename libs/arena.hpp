@@ -0,0 +1,160 @@
+#ifndef ARENA_H_
+#define ARENA_H_
+
+#include <vector>
+#include <cstdlib>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "common.hpp"
+#include "match.hpp"
+
+/**
+ * Hundreds of bot snakes competing on one large Match.
+ *
+ * A tick runs in two phases. The decide phase lets every bot pick a turn
+ * from a read-only view of the board; bots are split into contiguous
+ * slices and handled by a pool of worker threads. The resolve phase then
+ * feeds the decisions to Match::step() on the calling thread, in player
+ * order, so the result is identical for any number of threads. Dead bots
+ * are respawned right after the step to keep the population constant.
+ */
+class Arena {
+
+    Match match;
+    std::vector<int> decisions;
+
+    int threads;
+    std::vector<std::thread> workers;
+    std::mutex lock;
+    std::condition_variable wake;
+    std::condition_variable done;
+    unsigned long generation;
+    int remaining;
+    bool stopping;
+
+    static int distance(const Point &a, const Point &b) {
+        return std::abs(a.getX() - b.getX()) + std::abs(a.getY() - b.getY());
+    }
+
+    static Point next(const Point &head, int direction) {
+        switch (direction) {
+            case UP: return Point(head.getX() - 1, head.getY());
+            case DOWN: return Point(head.getX() + 1, head.getY());
+            case LEFT: return Point(head.getX(), head.getY() - 1);
+            default: return Point(head.getX(), head.getY() + 1);
+        }
+    }
+
+    /**
+     * @brief Greedy bot: head for the nearest food through a free cell
+     */
+    int decide(int player) const {
+        const Body &snake = match.getSnake(player);
+        const Grid &grid = match.getGrid();
+        Point head = snake.getHead();
+
+        Point target;
+        bool hasTarget = match.getFoodIndex().nearest(head, target);
+
+        static const int order[4] = { UP, RIGHT, DOWN, LEFT };
+        int best = ERR;
+        int bestScore = 0x7FFFFFFF;
+        for (int k = 0; k < 4; k++) {
+            int direction = order[k];
+            if (direction == snake.getDisableDirection()) continue;
+
+            Point p = next(head, direction);
+            unsigned short owner = grid.get(p);
+            if (owner != Grid::EMPTY && owner != Grid::FOOD) continue;
+
+            // Prefer keeping the current heading when distances tie
+            int score = hasTarget ? distance(p, target) * 2 : 0;
+            if (direction != snake.getDirection()) score++;
+            if (score < bestScore) {
+                bestScore = score;
+                best = direction;
+            }
+        }
+        return best;
+    }
+
+    void decideSlice(int slice) {
+        int players = match.getPlayers();
+        int begin = static_cast<int>(static_cast<long>(players) * slice / threads);
+        int end = static_cast<int>(static_cast<long>(players) * (slice + 1) / threads);
+        for (int i = begin; i < end; i++) {
+            decisions[i] = match.isAlive(i) ? decide(i) : ERR;
+        }
+    }
+
+    void workerLoop(int slice) {
+        unsigned long seen = 0;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> guard(lock);
+                wake.wait(guard, [&] { return stopping || generation != seen; });
+                if (stopping) return;
+                seen = generation;
+            }
+
+            decideSlice(slice);
+
+            std::lock_guard<std::mutex> guard(lock);
+            if (--remaining == 0) done.notify_one();
+        }
+    }
+
+public:
+
+    Arena(int rows, int cols, int bots, int foodCount, unsigned int seed, int threads)
+        : match(rows, cols, bots, 1, seed, foodCount), decisions(bots, ERR),
+          threads(threads < 1 ? 1 : threads), generation(0), remaining(0), stopping(false) {
+
+        // Slice 0 runs on the calling thread
+        for (int t = 1; t < this->threads; t++) {
+            workers.push_back(std::thread(&Arena::workerLoop, this, t));
+        }
+    }
+
+    ~Arena() {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (size_t i = 0; i < workers.size(); i++) {
+            workers[i].join();
+        }
+    }
+
+    void tick() {
+        // Decide: parallel, read-only
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            remaining = threads - 1;
+            generation++;
+        }
+        wake.notify_all();
+        decideSlice(0);
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            done.wait(guard, [&] { return remaining == 0; });
+        }
+
+        // Resolve: sequential, deterministic
+        for (int i = 0; i < match.getPlayers(); i++) {
+            if (decisions[i] != ERR) match.setDirection(i, decisions[i]);
+        }
+        match.step();
+
+        for (int i = 0; i < match.getPlayers(); i++) {
+            if (!match.isAlive(i)) match.respawn(i);
+        }
+    }
+
+    const Match &getMatch() const { return match; }
+    int getThreads() const { return threads; }
+};
+
+#endif
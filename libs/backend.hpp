@@ -0,0 +1,192 @@
+#ifndef BACKEND_H_
+#define BACKEND_H_
+
+#include <cstdio>
+#include <cstdlib>
+
+/**
+ * Build-time choice of the screen backend.
+ *
+ * The game draws through the curses API (mvaddch, attron, mvprintw,
+ * refresh, getch, ...). Which implementation answers those calls is fixed
+ * when compiling:
+ *
+ *   default                    terminal.hpp, ANSI sequences on stdout
+ *   -DTSNAKE_BACKEND_NCURSES   the system ncursesw library
+ *   -DTSNAKE_BACKEND_HEADLESS  terminal.hpp without a TTY, output discarded
+ *
+ * Every drawing call binds statically to the chosen implementation, so
+ * nothing on the per-cell path goes through a virtual call. `Backend` is
+ * the policy class of the selected backend and covers what the curses API
+ * does not: starting and stopping the screen (also from a crash handler),
+ * opening it on an arbitrary output for benchmarks, wiping the terminal
+ * between games and the size of the last frame in bytes and cells.
+ *
+ * BACKEND_FRAME_HOOKS is 1 when refresh() frames can be observed
+ * (spectators, recording), which needs terminal.hpp.
+ */
+
+#if defined(TSNAKE_BACKEND_NCURSES)
+
+#define NCURSES_NOMACROS
+#include <ncurses.h>
+#include <cstring>
+
+#define BACKEND_FRAME_HOOKS 0
+
+// The color pairs terminal.hpp hard-codes in attron()
+inline void initColorPairs() {
+    init_pair(1, COLOR_CYAN, -1);
+    init_pair(2, COLOR_GREEN, -1);
+    init_pair(3, COLOR_GREEN, -1);
+    init_pair(4, COLOR_RED, -1);
+    init_pair(5, COLOR_YELLOW, -1);
+    init_pair(6, COLOR_MAGENTA, -1);
+    init_pair(7, COLOR_RED, -1);
+    init_pair(8, COLOR_WHITE, COLOR_BLUE);
+}
+
+struct CursesBackend {
+
+    static const char *name() { return "ncurses"; }
+
+    static void start() {
+        initscr();
+        start_color();
+        use_default_colors();
+        initColorPairs();
+    }
+
+    /**
+     * @brief Opens a screen of a fixed size writing to `out`
+     */
+    static bool open(int lines, int cols, FILE *out) {
+        const char *term = getenv("TERM");
+        if (newterm(term != nullptr && *term ? term : "xterm-256color", out, stdin) == nullptr) return false;
+        resizeterm(lines, cols);
+        start_color();
+        use_default_colors();
+        initColorPairs();
+        curs_set(0);
+        return true;
+    }
+
+    static void stop() {
+        endwin();
+    }
+
+    // From a fatal signal handler; endwin() is the best ncurses offers
+    static void emergencyStop() {
+        endwin();
+    }
+
+    // ncurses does not say what it wrote
+    static size_t lastFrameBytes() {
+        return 0;
+    }
+
+    static size_t lastFrameCells() {
+        return 0;
+    }
+
+    static void fullClear() {
+        clear();
+        refresh();
+    }
+};
+
+typedef CursesBackend Backend;
+
+#else
+
+#include "terminal.hpp"
+
+#define BACKEND_FRAME_HOOKS 1
+
+struct AnsiBackend {
+
+    static const char *name() { return "ansi"; }
+
+    static void start() {
+        initscr();
+    }
+
+    static bool open(int lines, int cols, FILE *out) {
+        static FdSink sink(fileno(out));
+        set_render_sink(&sink);
+        initscr(lines, cols);
+        curs_set(0);
+        return true;
+    }
+
+    static void stop() {
+        endwin();
+        set_render_sink(nullptr);
+    }
+
+    static void emergencyStop() {
+        restore_terminal_from_signal();
+    }
+
+    static size_t lastFrameBytes() {
+        return frame_bytes();
+    }
+
+    static size_t lastFrameCells() {
+        return frame_cells();
+    }
+
+    static void fullClear() {
+        full_clear_screen();
+    }
+};
+
+struct HeadlessBackend {
+
+    static const char *name() { return "headless"; }
+
+    static NullSink &sink() {
+        static NullSink null;
+        return null;
+    }
+
+    // No terminal to ask: a fixed 80x24 screen, keys still come from stdin
+    static void start() {
+        open(24, 80, stdout);
+    }
+
+    static bool open(int lines, int cols, FILE *) {
+        set_render_sink(&sink());
+        initscr(lines, cols);
+        return true;
+    }
+
+    static void stop() {
+        cleanup_screen();
+        set_render_sink(nullptr);
+    }
+
+    static void emergencyStop() {}
+
+    static size_t lastFrameBytes() {
+        return frame_bytes();
+    }
+
+    static size_t lastFrameCells() {
+        return frame_cells();
+    }
+
+    static void fullClear() {
+        full_clear_screen();
+    }
+};
+
+#if defined(TSNAKE_BACKEND_HEADLESS)
+typedef HeadlessBackend Backend;
+#else
+typedef AnsiBackend Backend;
+#endif
+
+#endif
+
+#endif
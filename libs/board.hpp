@@ -2,6 +2,9 @@
 #define BOARD_H_ 
 
 #include <string>
+#include "trace.hpp"
+#include "perfcounters.hpp"
+#include "allocstats.hpp"
 
 using namespace std;
 
@@ -45,6 +48,10 @@ class Board {
         printw(" 3 ");
         attroff(COLOR_PAIR(COLOR_SNAKE_HEAD));
 
+        drawHighscore();
+    }
+
+    void drawHighscore() {
         // Highscore section (right aligned)
         attron(COLOR_PAIR(COLOR_HIGHSCORE) | A_BOLD);
         mvprintw(0, COLS - 20, " HIGHSCORE ");
@@ -82,6 +89,8 @@ class Board {
 
 public:
 
+    enum { HUD_COLUMN = 32 };   // status bar space after the size section
+
     Board(int initialHighscore = 0) { 
 
         score = 0;
@@ -101,7 +110,27 @@ public:
         attroff(COLOR_PAIR(COLOR_HIGHSCORE));
     }
 
+    /**
+     * @brief Shows `text` in the status bar from HUD_COLUMN on, over the highscore; null brings the highscore back
+     */
+    void setPrintHud(const char *text) {
+        // Only cells whose character changes reach the next frame
+        attron(COLOR_PAIR(COLOR_STATUS_BG) | A_BOLD);
+        for (int j = HUD_COLUMN; j < COLS; j++) {
+            mvaddch(0, j, ' ');
+        }
+        if (text != nullptr && COLS > HUD_COLUMN) {
+            mvprintw(0, HUD_COLUMN, "%.*s", COLS - HUD_COLUMN, text);
+        }
+        attroff(COLOR_PAIR(COLOR_STATUS_BG) | A_BOLD);
+
+        if (text == nullptr) drawHighscore();
+    }
+
     void update() {
+        TRACE_SCOPE("refresh");
+        PerfScope perf(PERF_REFRESH);
+        AllocScope alloc(ALLOC_REFRESH);
         refresh();
     }
 
@@ -186,27 +215,29 @@ public:
         }
 
         // Game Over text (ASCII art style)
-        string gameOver[5];
-        gameOver[0] = " ####   ###  #   # ####";
-        gameOver[1] = "#      #   # ## ## #   ";
-        gameOver[2] = "#  ## ##### # # # ###  ";
-        gameOver[3] = "#   # #   # #   # #    ";
-        gameOver[4] = " ###  #   # #   # #### ";
-
-        string overText[5];
-        overText[0] = " ###  #   # #### ####";
-        overText[1] = "#   # #   # #    #   #";
-        overText[2] = "#   #  # #  ###  ####";
-        overText[3] = "#   #  # #  #    #  #";
-        overText[4] = " ###    #   #### #   #";
+        static const char *const gameOver[5] = {
+            " ####   ###  #   # ####",
+            "#      #   # ## ## #   ",
+            "#  ## ##### # # # ###  ",
+            "#   # #   # #   # #    ",
+            " ###  #   # #   # #### "
+        };
+
+        static const char *const overText[5] = {
+            " ###  #   # #### ####",
+            "#   # #   # #    #   #",
+            "#   #  # #  ###  ####",
+            "#   #  # #  #    #  #",
+            " ###    #   #### #   #"
+        };
 
         int textStartY = startY + 2;
         int textStartX = startX + 3;
 
         attron(COLOR_PAIR(COLOR_GAMEOVER) | A_BOLD);
         for (int i = 0; i < 5; i++) {
-            mvprintw(textStartY + i, textStartX, "%s", gameOver[i].c_str());
-            mvprintw(textStartY + i, textStartX + 25, "%s", overText[i].c_str());
+            mvprintw(textStartY + i, textStartX, "%s", gameOver[i]);
+            mvprintw(textStartY + i, textStartX + 25, "%s", overText[i]);
         }
 
         // Final score display
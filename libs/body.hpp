@@ -1,42 +1,169 @@
 #ifndef BODY_H_
 #define BODY_H_
 
-#include <list>
+#include <vector>
 #include "point.hpp"
 #include "common.hpp"
+#include "inputlatency.hpp"
 
 using namespace std;
 
+/**
+ * Snake segments, head first, in a power-of-two ring of points.
+ *
+ * Moving pushes a head and pops the tail without touching the heap; the
+ * ring only grows (doubling) when the snake gets longer than it has ever
+ * been, so a game settles into zero allocations per move. The ring can
+ * also start in a buffer owned by someone else, such as a GameArena, and
+ * only moves to the heap if it outgrows it. Copies always own their ring.
+ */
+class Segments {
+
+	vector<Point> owned;	// the ring, unless it lives in an outside buffer
+	Point *points;
+	int mask;
+	int first;	// index of the head
+	int count;
+
+	void grow() {
+		vector<Point> bigger((mask + 1) * 2);
+		for (int i = 0; i < count; i++) bigger[i] = points[(first + i) & mask];
+		owned.swap(bigger);
+		points = owned.data();
+		mask = static_cast<int>(owned.size()) - 1;
+		first = 0;
+	}
+
+	static int roundUp(int capacity) {
+		int size = MIN_CAPACITY;
+		while (size < capacity) size <<= 1;
+		return size;
+	}
+
+public:
+
+	class const_iterator {
+		const Segments *segments;
+		int index;
+	public:
+		const_iterator(const Segments *segments, int index) : segments(segments), index(index) {}
+		const Point &operator*() const { return segments->at(index); }
+		const Point *operator->() const { return &segments->at(index); }
+		const_iterator &operator++() { index++; return *this; }
+		bool operator==(const const_iterator &other) const { return index == other.index; }
+		bool operator!=(const const_iterator &other) const { return index != other.index; }
+	};
+
+	enum { MIN_CAPACITY = 16 };
+
+	explicit Segments(int capacity = MIN_CAPACITY)
+		: owned(roundUp(capacity)), points(owned.data()), mask(static_cast<int>(owned.size()) - 1), first(0), count(0) {}
+
+	/**
+	 * @brief Ring in `storage`, which must hold a power of two points and outlive it
+	 */
+	Segments(Point *storage, int capacity) : points(storage), mask(capacity - 1), first(0), count(0) {}
+
+	Segments(const Segments &other)
+		: owned(other.capacity()), points(owned.data()), mask(other.mask), first(0), count(other.count) {
+		for (int i = 0; i < count; i++) points[i] = other.at(i);
+	}
+
+	Segments &operator=(const Segments &other) {
+		if (this != &other) {
+			if (capacity() < other.count) {
+				vector<Point>(other.capacity()).swap(owned);
+				points = owned.data();
+				mask = other.mask;
+			}
+			for (int i = 0; i < other.count; i++) points[i] = other.at(i);
+			first = 0;
+			count = other.count;
+		}
+		return *this;
+	}
+
+	void push_front(const Point &p) {
+		if (count == mask + 1) grow();
+		first = (first - 1) & mask;
+		points[first] = p;
+		count++;
+	}
+
+	void pop_back() { count--; }
+
+	const Point &front() const { return points[first]; }
+	const Point &back() const { return points[(first + count - 1) & mask]; }
+
+	// i-th segment from the head
+	const Point &at(int i) const { return points[(first + i) & mask]; }
+
+	int size() const { return count; }
+	bool empty() const { return count == 0; }
+	int capacity() const { return mask + 1; }
+	void clear() { count = 0; }
+
+	const_iterator begin() const { return const_iterator(this, 0); }
+	const_iterator end() const { return const_iterator(this, count); }
+};
+
 class Body{
 
 private:
 
-	list<Point> *body;
+	Segments body;
 	int direction;
 	int disableDirection;
 
-public:
+	void start() {
 
-	Body() {
+		body.push_front(Point(5,5));
+		body.push_front(Point(5,6));
+		body.push_front(Point(5,7)); // Head start position
+
+		direction = ERR;
+		disableDirection = 0;
+		this->validateDirection(RIGHT); // Starting moving to the right
+	}
 
-		body = new list<Point>(); // Create a empty list of Points
+public:
 
-    	body->push_front(Point(5,5));
-    	body->push_front(Point(5,6));
-    	body->push_front(Point(5,7)); // Head start position
+	Body() {
+		start();
+	}
 
-    	this->validateDirection(RIGHT); // Starting moving to the right
+	/**
+	 * @brief Starting snake whose segments live in `storage` (see Segments)
+	 */
+	Body(Point *storage, int capacity) : body(storage, capacity) {
+		start();
 	}
 
-	~Body() {
+	Body(const Point &head, int direction, int length) : body(length) {
+
+		// Lay the segments out behind the head, opposite to the direction
+		int dx = 0, dy = 0;
+		switch (direction) {
+			case UP: dx = 1; break;
+			case DOWN: dx = -1; break;
+			case LEFT: dy = 1; break;
+			case RIGHT: dy = -1; break;
+		}
+		for (int i = length - 1; i >= 0; i--) {
+			body.push_front(Point(head.getX() + dx * i, head.getY() + dy * i));
+		}
 
-		if(!body->empty())
-			body->clear();
-		delete body;
+		this->direction = ERR;
+		disableDirection = 0;
+		this->validateDirection(direction);
 	}
 
 	void validateDirection(int direction) {
 		if (direction != ERR && direction != disableDirection && direction >= 2 && direction <= 5) {
+			// A turn, not the first direction of a new snake
+			if (g_input_latency != nullptr && this->direction != ERR && direction != this->direction) {
+				g_input_latency->turned(tick_now());
+			}
 			this->direction = direction;
 
 			// Set disable direction
@@ -66,13 +193,15 @@ public:
 
 	int getDisableDirection() const { return disableDirection; }
 
-	Point getHead() const { return body->front(); }
-	void setHead(const Point &p) { body->push_front(p); }
+	Point getHead() const { return body.front(); }
+	void setHead(const Point &p) { body.push_front(p); }
 
-	Point getTail() const { return body->back(); }
-	void removeTail() { body->pop_back(); }
+	Point getTail() const { return body.back(); }
+	void removeTail() { body.pop_back(); }
 	
-	int getSize() const { return body->size(); }
+	int getSize() const { return body.size(); }
+
+	const Segments &getSegments() const { return body; }
 
 };
 
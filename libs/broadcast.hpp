@@ -0,0 +1,357 @@
+#ifndef BROADCAST_H_
+#define BROADCAST_H_
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include "terminal.hpp"
+
+typedef std::shared_ptr<const std::string> SharedFrame;
+
+/**
+ * Streams the game screen to spectators over TCP or a Unix socket.
+ *
+ * Any terminal can watch with `nc HOST PORT` or `socat - UNIX:PATH`. The
+ * game thread hands every refreshed frame over as is: the bytes refresh()
+ * already encoded for the local terminal are copied once into a shared,
+ * refcounted buffer and every viewer queues a pointer to it. A background
+ * thread owns the sockets and writes each viewer's queue with writev, so
+ * the tick only pays for that copy and a wakeup no matter how many people
+ * are watching.
+ *
+ * A viewer starts with a keyframe (the whole screen) and then follows the
+ * deltas. A viewer whose queue grows past MAX_QUEUED bytes loses its queued
+ * deltas and waits for the next keyframe instead of holding the game back.
+ * Keyframes are encoded by the game thread, once, when someone asks for one.
+ */
+class Broadcaster {
+
+    enum { MAX_QUEUED = 256 * 1024, MAX_IOV = 64, TAG_LISTEN = -1, TAG_WAKE = -2 };
+
+    struct Viewer {
+        int fd;
+        std::deque<SharedFrame> queue;
+        size_t offset;   // bytes of queue.front() already sent
+        size_t queued;
+        bool needsKeyframe;
+        bool wantWrite;
+    };
+
+    struct Published {
+        SharedFrame frame;
+        bool keyframe;
+    };
+
+    int listenFd;
+    int wakeFd;
+    int epfd;
+    std::string unixPath;
+
+    // Game thread -> writer thread handoff
+    std::mutex lock;
+    std::vector<Published> published;
+    std::atomic<bool> keyframeWanted;
+    std::atomic<bool> running;
+    std::thread writer;
+
+    // Writer thread only
+    std::vector<Viewer *> viewers;
+
+    std::atomic<int> viewerCount;
+    std::atomic<unsigned long> framesOut;
+    std::atomic<unsigned long> drops;
+
+    void watch(int fd, long long tag, unsigned int events, int op) {
+        epoll_event ev;
+        std::memset(&ev, 0, sizeof(ev));
+        ev.events = events;
+        ev.data.u64 = static_cast<unsigned long long>(tag);
+        epoll_ctl(epfd, op, fd, &ev);
+    }
+
+    void acceptAll() {
+        for (;;) {
+            int fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK);
+            if (fd < 0) return;
+
+            Viewer *viewer = new Viewer();
+            viewer->fd = fd;
+            viewer->offset = 0;
+            viewer->queued = 0;
+            viewer->needsKeyframe = true;
+            viewer->wantWrite = false;
+
+            size_t slot = 0;
+            while (slot < viewers.size() && viewers[slot] != nullptr) slot++;
+            if (slot == viewers.size()) viewers.push_back(nullptr);
+            viewers[slot] = viewer;
+
+            watch(fd, static_cast<long long>(slot), EPOLLIN, EPOLL_CTL_ADD);
+            viewerCount.fetch_add(1, std::memory_order_relaxed);
+            keyframeWanted.store(true, std::memory_order_relaxed);
+        }
+    }
+
+    void drop(size_t slot) {
+        Viewer *viewer = viewers[slot];
+        epoll_ctl(epfd, EPOLL_CTL_DEL, viewer->fd, nullptr);
+        close(viewer->fd);
+        delete viewer;
+        viewers[slot] = nullptr;
+        viewerCount.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    // Writes as much of the queue as the socket takes; false on a dead socket
+    bool flush(size_t slot) {
+        Viewer *viewer = viewers[slot];
+        while (!viewer->queue.empty()) {
+            iovec iov[MAX_IOV];
+            int count = 0;
+            for (size_t i = 0; i < viewer->queue.size() && count < MAX_IOV; i++, count++) {
+                const std::string &frame = *viewer->queue[i];
+                size_t skip = i == 0 ? viewer->offset : 0;
+                iov[count].iov_base = const_cast<char *>(frame.data() + skip);
+                iov[count].iov_len = frame.size() - skip;
+            }
+
+            ssize_t n = writev(viewer->fd, iov, count);
+            if (n < 0) {
+                if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+                return false;
+            }
+
+            size_t sent = static_cast<size_t>(n);
+            viewer->queued -= sent;
+            while (sent > 0) {
+                size_t left = viewer->queue.front()->size() - viewer->offset;
+                if (sent < left) {
+                    viewer->offset += sent;
+                    break;
+                }
+                sent -= left;
+                viewer->offset = 0;
+                viewer->queue.pop_front();
+            }
+        }
+
+        bool pending = !viewer->queue.empty();
+        if (pending != viewer->wantWrite) {
+            viewer->wantWrite = pending;
+            watch(viewer->fd, static_cast<long long>(slot),
+                  pending ? EPOLLIN | EPOLLOUT : static_cast<unsigned int>(EPOLLIN), EPOLL_CTL_MOD);
+        }
+        return true;
+    }
+
+    void enqueue(Viewer *viewer, const Published &item) {
+        if (viewer->needsKeyframe) {
+            if (!item.keyframe) return;
+            viewer->needsKeyframe = false;
+        } else if (item.keyframe) {
+            // Asked for by someone else; the deltas already keep this viewer in sync
+            return;
+        } else if (viewer->queued + item.frame->size() > MAX_QUEUED) {
+            // Too far behind: keep the frame being written, forget the rest
+            while (viewer->queue.size() > (viewer->offset > 0 ? 1u : 0u)) {
+                viewer->queued -= viewer->queue.back()->size();
+                viewer->queue.pop_back();
+            }
+            viewer->needsKeyframe = true;
+            keyframeWanted.store(true, std::memory_order_relaxed);
+            drops.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        viewer->queue.push_back(item.frame);
+        viewer->queued += item.frame->size();
+    }
+
+    void distribute() {
+        std::vector<Published> batch;
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            batch.swap(published);
+        }
+
+        for (size_t i = 0; i < batch.size(); i++) {
+            for (size_t slot = 0; slot < viewers.size(); slot++) {
+                if (viewers[slot] != nullptr) enqueue(viewers[slot], batch[i]);
+            }
+            framesOut.fetch_add(1, std::memory_order_relaxed);
+        }
+        for (size_t slot = 0; slot < viewers.size(); slot++) {
+            if (viewers[slot] != nullptr && !viewers[slot]->wantWrite && !flush(slot)) drop(slot);
+        }
+    }
+
+    void run() {
+        epoll_event events[64];
+        while (running.load(std::memory_order_relaxed)) {
+            int n = epoll_wait(epfd, events, 64, 200);
+            for (int i = 0; i < n; i++) {
+                long long tag = static_cast<long long>(events[i].data.u64);
+
+                if (tag == TAG_LISTEN) {
+                    acceptAll();
+                } else if (tag == TAG_WAKE) {
+                    unsigned long long value;
+                    if (read(wakeFd, &value, sizeof(value)) < 0) continue;
+                    distribute();
+                } else {
+                    size_t slot = static_cast<size_t>(tag);
+                    if (slot >= viewers.size() || viewers[slot] == nullptr) continue;
+
+                    // Viewers have nothing to say; input only tells us they left
+                    if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+                        char scratch[256];
+                        ssize_t got = recv(viewers[slot]->fd, scratch, sizeof(scratch), 0);
+                        if (got == 0 || (got < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+                            drop(slot);
+                            continue;
+                        }
+                    }
+                    if ((events[i].events & EPOLLOUT) && !flush(slot)) drop(slot);
+                }
+            }
+        }
+    }
+
+    void publish(const char *bytes, size_t length, bool keyframe) {
+        Published item;
+        item.frame = std::make_shared<const std::string>(bytes, length);
+        item.keyframe = keyframe;
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            published.push_back(item);
+        }
+        unsigned long long one = 1;
+        if (write(wakeFd, &one, sizeof(one)) < 0) return;
+    }
+
+    static void onFrame(const char *bytes, size_t length, const int * /* cells */, int count, void *context) {
+        Broadcaster *self = static_cast<Broadcaster *>(context);
+        if (count > 0) self->frame(bytes, length);
+        if (self->keyframeWanted.load(std::memory_order_relaxed)) self->keyframe();
+    }
+
+    Broadcaster(const Broadcaster &);
+    Broadcaster &operator=(const Broadcaster &);
+
+public:
+
+    Broadcaster()
+        : listenFd(-1), wakeFd(-1), epfd(-1), keyframeWanted(false), running(false),
+          viewerCount(0), framesOut(0), drops(0) {}
+
+    ~Broadcaster() {
+        stop();
+        if (!unixPath.empty()) unlink(unixPath.c_str());
+    }
+
+    /**
+     * @brief Listens on "tcp:PORT" or "unix:PATH" and starts the writer thread
+     */
+    bool open(const char *spec) {
+        if (std::strncmp(spec, "tcp:", 4) == 0) {
+            listenFd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+            if (listenFd < 0) return false;
+            int one = 1;
+            setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+            sockaddr_in addr;
+            std::memset(&addr, 0, sizeof(addr));
+            addr.sin_family = AF_INET;
+            addr.sin_addr.s_addr = htonl(INADDR_ANY);
+            addr.sin_port = htons(static_cast<unsigned short>(std::atoi(spec + 4)));
+            if (bind(listenFd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0) return false;
+        } else if (std::strncmp(spec, "unix:", 5) == 0) {
+            sockaddr_un addr;
+            std::memset(&addr, 0, sizeof(addr));
+            addr.sun_family = AF_UNIX;
+            if (std::strlen(spec + 5) >= sizeof(addr.sun_path)) return false;
+            std::strcpy(addr.sun_path, spec + 5);
+
+            listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0);
+            if (listenFd < 0) return false;
+            unlink(addr.sun_path);
+            if (bind(listenFd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0) return false;
+            unixPath = addr.sun_path;
+        } else {
+            return false;
+        }
+
+        if (::listen(listenFd, 128) != 0) return false;
+        epfd = epoll_create1(0);
+        wakeFd = eventfd(0, EFD_NONBLOCK);
+        if (epfd < 0 || wakeFd < 0) return false;
+
+        watch(listenFd, TAG_LISTEN, EPOLLIN, EPOLL_CTL_ADD);
+        watch(wakeFd, TAG_WAKE, EPOLLIN, EPOLL_CTL_ADD);
+        running = true;
+        writer = std::thread(&Broadcaster::run, this);
+        return true;
+    }
+
+    /**
+     * @brief Feeds every refresh() of this process to the viewers
+     */
+    bool attach() {
+        return add_frame_listener(onFrame, this);
+    }
+
+    void stop() {
+        remove_frame_listener(onFrame, this);
+        if (running.exchange(false)) {
+            unsigned long long one = 1;
+            if (write(wakeFd, &one, sizeof(one)) < 0) {}
+            writer.join();
+        }
+        for (size_t slot = 0; slot < viewers.size(); slot++) {
+            if (viewers[slot] != nullptr) drop(slot);
+        }
+        if (wakeFd >= 0) close(wakeFd);
+        if (epfd >= 0) close(epfd);
+        if (listenFd >= 0) close(listenFd);
+        wakeFd = epfd = listenFd = -1;
+    }
+
+    /**
+     * @brief Queues a delta for every viewer that is in sync
+     */
+    void frame(const char *bytes, size_t length) {
+        if (viewerCount.load(std::memory_order_relaxed) == 0) return;
+        publish(bytes, length, false);
+    }
+
+    /**
+     * @brief Encodes the current screen for viewers waiting on a keyframe
+     */
+    void keyframe() {
+        keyframeWanted.store(false, std::memory_order_relaxed);
+        std::string full;
+        encode_keyframe(full);
+        publish(full.data(), full.size(), true);
+    }
+
+    bool isKeyframeWanted() const { return keyframeWanted.load(std::memory_order_relaxed); }
+    int getViewers() const { return viewerCount.load(std::memory_order_relaxed); }
+    unsigned long getFramesOut() const { return framesOut.load(std::memory_order_relaxed); }
+    unsigned long getDrops() const { return drops.load(std::memory_order_relaxed); }
+};
+
+#endif
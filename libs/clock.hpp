@@ -19,9 +19,15 @@ public:
     last = now;
   }
 
+  // Milliseconds since the last reset, with the fraction kept
   double getTimestamp() {
     now = steady_clock::now();
-    return duration_cast<milliseconds>(now - last).count();
+    return duration<double, std::milli>(now - last).count();
+  }
+
+  // Nanoseconds from the last reset to the last getTimestamp()
+  long long getNanoseconds() const {
+    return duration_cast<nanoseconds>(now - last).count();
   }
 
   void reset() {
@@ -0,0 +1,296 @@
+#ifndef FLIGHTRECORDER_H_
+#define FLIGHTRECORDER_H_
+
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+/**
+ * The last ticks of a game, kept in memory for post-mortems.
+ *
+ * Every tick fills one fixed-size record in a ring: the key read, the
+ * direction, head and food positions, score, length, timing and the bytes
+ * flushed, a dozen stores with no allocation or lock. Nothing is written
+ * out until one of these happens:
+ *
+ *   SIGUSR2                      a dump, and the game carries on
+ *   SIGSEGV, SIGBUS, SIGFPE,     the terminal is restored, the dump is
+ *   SIGILL, SIGABRT              written, and the signal kills the process
+ *   an unexplained game over     a death the board reports but the snake
+ *                                and walls do not account for
+ *
+ * Dumps are appended to one text file, each headed by its reason. They are
+ * written with open() and write() only, so the signal handlers can do it
+ * even when the game is stuck or the heap is broken. The file is private
+ * to the player (0600) and never reached through a symbolic link; by
+ * default it lives under the player's own state directory.
+ */
+
+enum FlightEvent {
+    FLIGHT_MOVE,
+    FLIGHT_EAT,
+    FLIGHT_DEATH
+};
+
+struct FlightRecord {
+    unsigned int tick;
+    short key;              // key read this tick, -1 for none
+    char direction;
+    char event;             // FlightEvent
+    short headX, headY;
+    short foodX, foodY;
+    int score;
+    int length;
+    int lateUs;             // start after the tick deadline
+    int tickUs;             // whole tick, frame flush included
+    unsigned int bytes;     // frame bytes flushed
+    long long startNs;      // monotonic
+};
+
+/**
+ * @brief Text buffer for dumps that needs no heap and no stdio
+ */
+class FlightWriter {
+
+    int fd;
+    int length;
+    char buffer[4096];
+
+public:
+
+    explicit FlightWriter(int fd) : fd(fd), length(0) {}
+
+    ~FlightWriter() {
+        flush();
+    }
+
+    void flush() {
+        int done = 0;
+        while (done < length) {
+            ssize_t n = ::write(fd, buffer + done, static_cast<size_t>(length - done));
+            if (n <= 0) break;
+            done += static_cast<int>(n);
+        }
+        length = 0;
+    }
+
+    FlightWriter &put(const char *text) {
+        while (*text) {
+            if (length == static_cast<int>(sizeof(buffer))) flush();
+            buffer[length++] = *text++;
+        }
+        return *this;
+    }
+
+    FlightWriter &put(long long value) {
+        char digits[24];
+        int n = 0;
+        bool negative = value < 0;
+        unsigned long long magnitude = negative ? 0ULL - static_cast<unsigned long long>(value)
+                                                : static_cast<unsigned long long>(value);
+        do {
+            digits[n++] = static_cast<char>('0' + magnitude % 10);
+            magnitude /= 10;
+        } while (magnitude > 0);
+        if (negative) digits[n++] = '-';
+
+        char text[24];
+        for (int i = 0; i < n; i++) text[i] = digits[n - 1 - i];
+        text[n] = '\0';
+        return put(text);
+    }
+};
+
+class FlightRecorder {
+
+public:
+
+    enum { CAPACITY = 1024 };   // ticks kept; a power of two
+
+private:
+
+    FlightRecord records[CAPACITY];
+    volatile unsigned long committed;
+
+public:
+
+    FlightRecorder() : committed(0) {
+        std::memset(records, 0, sizeof(records));
+    }
+
+    void clear() { committed = 0; }
+
+    /**
+     * @brief The record of the current tick, to fill and then commit()
+     */
+    FlightRecord &slot() { return records[committed & (CAPACITY - 1)]; }
+
+    void commit() { committed = committed + 1; }
+
+    unsigned long getCount() const { return committed; }
+    unsigned long size() const { return committed < CAPACITY ? committed : static_cast<unsigned long>(CAPACITY); }
+
+    /**
+     * @brief Kept record `i`, oldest first
+     */
+    const FlightRecord &at(unsigned long i) const {
+        return records[(committed - size() + i) & (CAPACITY - 1)];
+    }
+
+    /**
+     * @brief Writes every kept record to `fd` under a `reason` header
+     */
+    void dump(int fd, const char *reason) const {
+        // Indexed by DOWN=2, UP=3, LEFT=4, RIGHT=5 from common.hpp
+        static const char *directions[] = { "-", "-", "D", "U", "L", "R" };
+        static const char *events[] = { "move", "eat", "death" };
+
+        // Records taken at the start: a dump from a signal handler may
+        // interrupt the tick that is filling the next slot
+        unsigned long total = committed;
+        unsigned long count = total < CAPACITY ? total : static_cast<unsigned long>(CAPACITY);
+        unsigned long first = total - count;
+
+        FlightWriter out(fd);
+        out.put("# tsnake flight recorder: ").put(reason).put("\n");
+        out.put("# last ").put(static_cast<long long>(count)).put(" of ")
+           .put(static_cast<long long>(total)).put(" ticks, oldest first\n");
+        out.put("tick key dir event head food score length late_us tick_us bytes start_ns\n");
+        for (unsigned long i = 0; i < count; i++) {
+            const FlightRecord &r = records[(first + i) & (CAPACITY - 1)];
+            int d = r.direction >= 0 && r.direction <= 5 ? r.direction : 0;
+            out.put(static_cast<long long>(r.tick)).put(" ").put(static_cast<long long>(r.key)).put(" ")
+               .put(directions[d]).put(" ").put(events[r.event >= 0 && r.event <= FLIGHT_DEATH ? r.event : 0]).put(" ")
+               .put(static_cast<long long>(r.headX)).put(",").put(static_cast<long long>(r.headY)).put(" ")
+               .put(static_cast<long long>(r.foodX)).put(",").put(static_cast<long long>(r.foodY)).put(" ")
+               .put(static_cast<long long>(r.score)).put(" ").put(static_cast<long long>(r.length)).put(" ")
+               .put(static_cast<long long>(r.lateUs)).put(" ").put(static_cast<long long>(r.tickUs)).put(" ")
+               .put(static_cast<long long>(r.bytes)).put(" ").put(r.startNs).put("\n");
+        }
+        out.put("\n");
+    }
+
+    /**
+     * @brief Appends a dump to the file at `path`; false when it cannot be opened
+     *
+     * With `create` the file must not exist yet.
+     */
+    bool dump(const char *path, const char *reason, bool create = false) const {
+        int flags = O_WRONLY | O_CREAT | O_APPEND | O_NOFOLLOW | O_CLOEXEC | (create ? O_EXCL : 0);
+        int fd = ::open(path, flags, 0600);
+        if (fd < 0) return false;
+        dump(fd, reason);
+        ::close(fd);
+        return true;
+    }
+};
+
+// Set while a game records; dumps go to g_flight_path
+static FlightRecorder *g_flight_recorder = nullptr;
+static char g_flight_path[256];
+static void (*g_flight_restore)() = nullptr;
+
+// The path was made up for this run: the first dump creates the file
+static volatile sig_atomic_t g_flight_fresh = 0;
+
+/**
+ * @brief Dumps the recorder outside of a signal, e.g. on an odd game over
+ */
+inline bool flight_dump(const char *reason) {
+    if (g_flight_recorder == nullptr || !g_flight_recorder->dump(g_flight_path, reason, g_flight_fresh != 0)) {
+        return false;
+    }
+    g_flight_fresh = 0;
+    return true;
+}
+
+/**
+ * @brief Default dump file for this process, under $XDG_STATE_HOME/tsnake
+ * or ~/.local/state/tsnake (made 0700 when missing); empty without either
+ */
+inline std::string flight_default_path() {
+    const char *state = std::getenv("XDG_STATE_HOME");
+    const char *home = std::getenv("HOME");
+    std::string dir;
+    if (state != nullptr && state[0] == '/') dir = state;
+    else if (home != nullptr && home[0] == '/') dir = std::string(home) + "/.local/state";
+    else return std::string();
+    dir += "/tsnake";
+
+    for (size_t slash = dir.find('/', 1); ; slash = dir.find('/', slash + 1)) {
+        std::string part = dir.substr(0, slash);
+        if (mkdir(part.c_str(), 0700) != 0 && errno != EEXIST) return std::string();
+        if (slash == std::string::npos) break;
+    }
+    return dir + "/flight-" + std::to_string(getpid()) + ".log";
+}
+
+inline void flight_signal(int sig) {
+    const char *reason = "signal";
+    switch (sig) {
+        case SIGUSR2: reason = "SIGUSR2"; break;
+        case SIGSEGV: reason = "SIGSEGV"; break;
+        case SIGBUS: reason = "SIGBUS"; break;
+        case SIGFPE: reason = "SIGFPE"; break;
+        case SIGILL: reason = "SIGILL"; break;
+        case SIGABRT: reason = "SIGABRT"; break;
+    }
+
+    if (sig == SIGUSR2) {
+        flight_dump(reason);
+        return;
+    }
+
+    // Fatal: give the shell its terminal back before anything else
+    if (g_flight_restore != nullptr) g_flight_restore();
+    bool written = flight_dump(reason);
+    {
+        FlightWriter err(STDERR_FILENO);
+        err.put("tsnake: ").put(reason);
+        if (written) err.put(", last ticks written to ").put(g_flight_path);
+        err.put("\n");
+    }
+    // The handler was reset on entry: this ends the process as the signal would have
+    raise(sig);
+}
+
+/**
+ * @brief Sends SIGUSR2 and fatal signals to the recorder, dumping to `path`
+ *
+ * `restore` puts the terminal back from a signal handler, or is null.
+ * `fresh` paths are created by the first dump, which fails if one exists.
+ */
+inline void flight_install(FlightRecorder *recorder, const char *path, void (*restore)(), bool fresh = false) {
+    static const int fatal[] = { SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT };
+    // A stack overflow leaves no stack to run the handler on
+    static char alternate[1 << 16];
+
+    g_flight_recorder = recorder;
+    g_flight_restore = restore;
+    g_flight_fresh = fresh ? 1 : 0;
+    std::strncpy(g_flight_path, path, sizeof(g_flight_path) - 1);
+    g_flight_path[sizeof(g_flight_path) - 1] = '\0';
+
+    stack_t stack;
+    stack.ss_sp = alternate;
+    stack.ss_size = sizeof(alternate);
+    stack.ss_flags = 0;
+    sigaltstack(&stack, nullptr);
+
+    struct sigaction action;
+    std::memset(&action, 0, sizeof(action));
+    action.sa_handler = flight_signal;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    sigaction(SIGUSR2, &action, nullptr);
+
+    action.sa_flags = SA_RESETHAND | SA_ONSTACK;
+    for (size_t i = 0; i < sizeof(fatal) / sizeof(fatal[0]); i++) sigaction(fatal[i], &action, nullptr);
+}
+
+#endif
@@ -2,51 +2,132 @@
 #define GAME_H_
 
 #include "common.hpp"
-#include "clock.hpp"
+#include "scheduler.hpp"
+#include "trace.hpp"
+#include "perfcounters.hpp"
+#include "allocstats.hpp"
+#include "tickstats.hpp"
+#include "flightrecorder.hpp"
+#include "log.hpp"
 
 #include "point.hpp"
 #include "food.hpp"
 #include "body.hpp"
 #include "board.hpp"
+#include "perfhud.hpp"
+#include "gamearena.hpp"
+#include "backend.hpp"
 
 
 class Game{
 
+    GameArena *arena;
+    GameArena *ownArena;    // when no arena was handed in
+    GameArena::Mark round;  // where this round's objects start
     Board *board;
     Body *body;
     Food *food;
-    Clock clock;
     int level;
     char keyStroke;
+    TickScheduler schedule;
+    TickConfig config;
+    PerfHud hud;
 
-public:
+    // Longest possible snake, rounded up to the ring's power of two
+    static int segmentCapacity(int lines, int cols) {
+        int capacity = Segments::MIN_CAPACITY;
+        while (capacity < lines * cols) capacity <<= 1;
+        return capacity;
+    }
+
+    // The walls or the snake's own body are where a game can end
+    bool deathExplained(const Point &head) const {
+        if (head.getX() <= 1 || head.getX() >= LINES - 1 || head.getY() <= 0 || head.getY() >= COLS - 1) return true;
+        const Segments &segments = body->getSegments();
+        for (Segments::const_iterator it = segments.begin(); it != segments.end(); ++it) {
+            if (it->getX() == head.getX() && it->getY() == head.getY()) return true;
+        }
+        return false;
+    }
 
-    Game(int level) {
+    void record(FlightEvent event, const Point &head, long long lateness, long long started) {
+        FlightRecord &r = g_flight_recorder->slot();
+        r.tick = static_cast<unsigned int>(schedule.getTicks());
+        r.key = keyStroke;
+        r.direction = static_cast<char>(body->getDirection());
+        r.event = static_cast<char>(event);
+        r.headX = static_cast<short>(head.getX());
+        r.headY = static_cast<short>(head.getY());
+        r.foodX = static_cast<short>(food->getX());
+        r.foodY = static_cast<short>(food->getY());
+        r.score = board->getScore();
+        r.length = body->getSize();
+        r.lateUs = static_cast<int>(lateness / 1000);
+        r.tickUs = static_cast<int>((TickScheduler::now() - started) / 1000);
+        r.bytes = static_cast<unsigned int>(Backend::lastFrameBytes());
+        r.startNs = started;
+        g_flight_recorder->commit();
+    }
+
+    void setup() {
+
+        round = arena->mark();
+        int capacity = segmentCapacity(LINES, COLS);
 
-        board = new Board();
-        body = new Body();
-        food = new Food();
+        schedule.setRate(config.rate > 0 ? config.rate : tick_rate_for_level(level));
+        schedule.configure(config);
+        schedule.restart();
 
-        this->level = level;
+        board = arena->make<Board>();
+        body = arena->make<Body>(arena->makeArray<Point>(capacity), capacity);
+        food = arena->make<Food>();
 
         // get first food point of the game!
         this->validateFood();
-        
+
         // print Score, Size and Food initial position
         board->setPrintScore(level);
         board->setPrintSize(*body);
         board->setPrintFood(*food);
-    
+
+        LOG_INFO("game_start", "difficulty", level, "rate_mhz", schedule.getRate() * 1000, "rows", LINES, "cols", COLS);
+    }
+
+public:
+
+    /**
+     * @brief Arena size for a game (and the Game itself) on a lines x cols screen
+     */
+    static size_t arenaBytes(int lines, int cols) {
+        // Each object also takes a cleanup record and up to 64 bytes of alignment
+        size_t objects = sizeof(Game) + sizeof(Board) + sizeof(Body) + sizeof(Food) + 4 * 128;
+        return objects + sizeof(Point) * segmentCapacity(lines, cols);
+    }
+
+    /**
+     * @brief A game whose Board, Body and Food come from `arena`
+     */
+    Game(int level, GameArena &arena, const TickConfig &config = TickConfig())
+        : arena(&arena), ownArena(nullptr), level(level), config(config) {
+        setup();
+    }
+
+    Game(int level) : ownArena(new GameArena(arenaBytes(LINES, COLS))), level(level) {
+        arena = ownArena;
+        setup();
     }
 
     ~Game() { 
         // Don't call endwin() here - it's called in main.cpp only
-        if (board) delete board;
-        if (body) delete body;
-        if (food) delete food;
+        arena->rewind(round);
+        delete ownArena;
     }
 
+    Game(const Game &) = delete;
+    Game &operator=(const Game &) = delete;
+
     void validateFood() {
+       TRACE_SCOPE("food");
        food->getFood();
         if (board->getChar(*food) == '@') { // food born inside snake
             validateFood();
@@ -55,63 +136,125 @@ public:
 
     void reset() {
 
-        delete board;
-        delete body;
-        delete food;
+        // Board, Body and Food go in one step and reuse the same space
+        arena->rewind(round);
 
         clear();
 
-        board = new Board();
-        body = new Body();
-        food = new Food();
-
-        // get first food point of the game!
-        this->validateFood();
+        setup();
+    }
 
-        // print Score, Size and Food initial position
-        board->setPrintScore(level);
-        board->setPrintSize(*body);
-        board->setPrintFood(*food);
+    /**
+     * @brief Sleeps until the next tick is due; isGameOver() then runs it
+     */
+    void waitForTick() const {
+        schedule.wait();
     }
 
+    const TickScheduler &getScheduler() const { return schedule; }
+
     bool isGameOver() {
 
-        if(clock.getTimestamp() >= DELAY) {
+        unsigned long long missed = schedule.getMissed();
+        long long lateness;
 
-            keyStroke = getch();
-            body->validateDirection(keyStroke);
+        if(schedule.poll(lateness)) {
 
-            Point newHead = body->investigatePosition();
-            char ch = board->getChar(newHead);
+            if (g_tick_stats != nullptr) g_tick_stats->beginTick(lateness, schedule.getMissed() - missed);
+            if (schedule.getMissed() != missed) {
+                LOG_WARN("deadline_missed", "tick", schedule.getTicks(), "missed", schedule.getMissed() - missed,
+                         "late_us", lateness / 1000, "dropped", schedule.getDropped());
+            }
+            bool timed = g_flight_recorder != nullptr || hud.isVisible();
+            long long started = timed ? TickScheduler::now() : 0;
+
+            TRACE_SCOPE("tick");
+            PerfScope perf(PERF_TICK);
+            AllocScope alloc(ALLOC_TICK);
+
+            {
+                TRACE_SCOPE("input");
+                keyStroke = getch();
+            }
+            if (keyStroke == PerfHud::KEY) {
+                hud.toggle(*board, TickScheduler::now());
+            } else {
+                TRACE_SCOPE("direction");
+                body->validateDirection(keyStroke);
+            }
+            LOG_DEBUG("tick", "tick", schedule.getTicks(), "key", keyStroke, "late_us", lateness / 1000);
+
+            Point newHead;
+            char ch;
+            {
+                TRACE_SCOPE("collision");
+                newHead = body->investigatePosition();
+                ch = board->getChar(newHead);
+            }
+
+            bool over = false;
+            FlightEvent event = FLIGHT_MOVE;
 
             if (ch == '@' || ch == '-' || ch == '|') { // Snake cant move!
                 
+                TRACE_SCOPE("draw");
                 board->printGameOver();
-                board->update();
-                return true;
+                over = true;
+                event = FLIGHT_DEATH;
             
             } else if (ch == 'f') { // Snake can eat and move!
             
               this->validateFood();
+              event = FLIGHT_EAT;
+              if (config.speedup > 0) schedule.setRate(schedule.getRate() * (1 + config.speedup / 100));
 
+              TRACE_SCOPE("draw");
               body->setHead(newHead);
               board->setPrintSnake(*body);
 
               board->setPrintFood(*food);
               board->setPrintScore(level);
               board->setPrintSize(*body);
-              
-              board->update();
+              LOG_DEBUG("food_eaten", "score", board->getScore(), "length", body->getSize(),
+                        "rate_mhz", schedule.getRate() * 1000);
             
             } else { //Snake can move!
 
+              TRACE_SCOPE("draw");
               body->setHead(newHead);
               board->setPrintSnake(*body);
               body->removeTail();
-              board->update();
             }
 
-            clock.reset();
+            if (hud.isVisible()) hud.draw(*board, TickScheduler::now());
+            long long drawn = hud.isVisible() ? TickScheduler::now() : 0;
+
+            if (g_tick_stats != nullptr) g_tick_stats->endCompute();
+            board->update();
+            tick_stats_end_tick();
+
+            // Not the tick that showed the HUD: it started untimed
+            if (hud.isVisible() && started != 0) {
+                long long done = TickScheduler::now();
+                hud.record(done - started, done - drawn, Backend::lastFrameBytes(), Backend::lastFrameCells());
+            }
+
+            if (g_flight_recorder != nullptr) {
+                record(event, newHead, lateness, started);
+                if (over && !deathExplained(newHead)) {
+                    char reason[96];
+                    snprintf(reason, sizeof(reason), "abnormal game over: '%c' at %d,%d is neither wall nor snake",
+                             ch, newHead.getX(), newHead.getY());
+                    flight_dump(reason);
+                    LOG_ERROR("abnormal_game_over", "x", newHead.getX(), "y", newHead.getY(), "char", ch);
+                }
+            }
+
+            if (over) {
+                LOG_INFO("game_over", "score", board->getScore(), "length", body->getSize(),
+                         "ticks", schedule.getTicks(), "missed", schedule.getMissed());
+                return true;
+            }
         }
 
         return false;
@@ -0,0 +1,128 @@
+#ifndef GAMEARENA_H_
+#define GAMEARENA_H_
+
+#include <cstdlib>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+/**
+ * Monotonic buffer for everything one game owns.
+ *
+ * Objects are bump-allocated back to back from a single block that is
+ * sized up front (see Game::arenaBytes), so a game's hot objects sit next
+ * to each other and making them never calls the heap. Nothing is freed
+ * one by one: rewind() runs the destructors of everything made after a
+ * mark, newest first, and moves the bump pointer back in one step, which
+ * is how a game ends or restarts.
+ *
+ * Each make() also places a small cleanup record in the buffer, chaining
+ * the destructors to run. Running out of space throws std::bad_alloc, as
+ * operator new would; a correctly sized arena never does.
+ */
+class GameArena {
+
+    struct Cleanup {
+        void (*destroy)(void *);
+        void *object;
+        Cleanup *previous;
+    };
+
+    char *buffer;
+    size_t capacity;
+    size_t used;
+    Cleanup *top;   // most recent object with a destructor
+
+    template <typename T>
+    static void destroyObject(void *object) {
+        static_cast<T *>(object)->~T();
+    }
+
+public:
+
+    // Mark() is the empty arena
+    struct Mark {
+        size_t used;
+    };
+
+    explicit GameArena(size_t bytes) : buffer(nullptr), capacity(bytes), used(0), top(nullptr) {
+        buffer = static_cast<char *>(std::malloc(bytes ? bytes : 1));
+        if (buffer == nullptr) throw std::bad_alloc();
+    }
+
+    ~GameArena() {
+        rewind(Mark());
+        std::free(buffer);
+    }
+
+    GameArena(const GameArena &) = delete;
+    GameArena &operator=(const GameArena &) = delete;
+
+    void *allocate(size_t size, size_t alignment) {
+        size_t start = (used + alignment - 1) & ~(alignment - 1);
+        if (start > capacity || size > capacity - start) throw std::bad_alloc();
+        used = start + size;
+        return buffer + start;
+    }
+
+    /**
+     * @brief Constructs a T in the arena; its destructor runs on rewind
+     */
+    template <typename T, typename... Args>
+    T *make(Args &&... args) {
+        Mark before = mark();
+        // Linked before T is built, so whatever its constructor makes here is
+        // chained after it and the chain stays in address order
+        Cleanup *cleanup = static_cast<Cleanup *>(allocate(sizeof(Cleanup), alignof(Cleanup)));
+        cleanup->destroy = nullptr;
+        cleanup->object = nullptr;
+        cleanup->previous = top;
+        top = cleanup;
+        T *object;
+        try {
+            object = new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+        } catch (...) {
+            rewind(before);
+            throw;
+        }
+        cleanup->destroy = &GameArena::destroyObject<T>;
+        cleanup->object = object;
+        return object;
+    }
+
+    /**
+     * @brief Default-constructed array of a trivially destructible type
+     */
+    template <typename T>
+    T *makeArray(size_t count) {
+        static_assert(std::is_trivially_destructible<T>::value, "arrays get no cleanup record");
+        T *items = static_cast<T *>(allocate(sizeof(T) * count, alignof(T)));
+        for (size_t i = 0; i < count; i++) new (items + i) T();
+        return items;
+    }
+
+    Mark mark() const {
+        Mark m;
+        m.used = used;
+        return m;
+    }
+
+    /**
+     * @brief Destroys everything made after `m`, newest first, and frees its space
+     *
+     * Safe to call again from one of those destructors with a later mark.
+     */
+    void rewind(const Mark &m) {
+        while (top != nullptr && reinterpret_cast<char *>(top) >= buffer + m.used) {
+            Cleanup *cleanup = top;
+            top = cleanup->previous;
+            if (cleanup->destroy != nullptr) cleanup->destroy(cleanup->object);
+        }
+        if (m.used < used) used = m.used;
+    }
+
+    size_t getUsed() const { return used; }
+    size_t getCapacity() const { return capacity; }
+};
+
+#endif
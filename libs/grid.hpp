@@ -0,0 +1,68 @@
+#ifndef GRID_H_
+#define GRID_H_
+
+#include <vector>
+#include <algorithm>
+#include "point.hpp"
+
+/**
+ * Occupancy grid shared by every snake on a board.
+ *
+ * Each cell stores who owns it: nothing, a wall, a food item or the id of
+ * the snake whose segment sits there (1-based). Any collision question is a
+ * single array lookup, independent of snake length or snake count.
+ */
+class Grid {
+
+    int rows;
+    int cols;
+    std::vector<unsigned short> cells;
+
+public:
+
+    enum { EMPTY = 0, FOOD = 0xFFFE, WALL = 0xFFFF, MAX_OWNERS = 0xFFFD };
+
+    Grid(int rows, int cols) : rows(rows), cols(cols), cells(rows * cols, static_cast<unsigned short>(EMPTY)) {
+        clear();
+    }
+
+    /**
+     * @brief Empties the board, keeping only the surrounding wall
+     */
+    void clear() {
+        std::fill(cells.begin(), cells.end(), static_cast<unsigned short>(EMPTY));
+
+        // The outermost ring is the arena wall
+        for (int j = 0; j < cols; j++) {
+            cells[j] = WALL;
+            cells[(rows - 1) * cols + j] = WALL;
+        }
+        for (int i = 0; i < rows; i++) {
+            cells[i * cols] = WALL;
+            cells[i * cols + cols - 1] = WALL;
+        }
+    }
+
+    int getRows() const { return rows; }
+    int getCols() const { return cols; }
+
+    bool inside(const Point &p) const {
+        return p.getX() >= 0 && p.getX() < rows && p.getY() >= 0 && p.getY() < cols;
+    }
+
+    int index(const Point &p) const { return p.getX() * cols + p.getY(); }
+
+    unsigned short get(const Point &p) const {
+        return inside(p) ? cells[index(p)] : static_cast<unsigned short>(WALL);
+    }
+
+    void set(const Point &p, unsigned short owner) { cells[index(p)] = owner; }
+
+    static bool isSnake(unsigned short owner) {
+        return owner != EMPTY && owner != FOOD && owner != WALL;
+    }
+
+    const std::vector<unsigned short> &getCells() const { return cells; }
+};
+
+#endif
@@ -0,0 +1,121 @@
+#ifndef INPUTLATENCY_H_
+#define INPUTLATENCY_H_
+
+#include <cstdio>
+#include "tickstats.hpp"
+
+/**
+ * Key-to-photon latency, stage by stage (--input-latency).
+ *
+ * A key is stamped when handle_special_keys() reads it, then followed to
+ * the turn Body::validateDirection() applies and to the refresh() that
+ * puts the moved head on screen:
+ *
+ *   queued   last read that found no key -> this key read; an upper bound
+ *            on how long it sat in the terminal's input buffer
+ *   turn     read -> new direction applied
+ *   render   turn -> frame encoded
+ *   flush    encoded -> frame written to the terminal
+ *   total    read -> written
+ *
+ * What the terminal emulator and the display add after the write is out
+ * of reach. One key is followed at a time, from its read to the next
+ * frame; a key that does not change the direction (a reverse, the same
+ * direction, any other key, menus included) is only counted. Each stage
+ * goes into a LatencyHistogram and the report prints their percentiles,
+ * which shows whether the tick rate, queued input or rendering dominates.
+ */
+
+enum LatencyStage {
+    LATENCY_QUEUED,
+    LATENCY_TURN,
+    LATENCY_RENDER,
+    LATENCY_FLUSH,
+    LATENCY_TOTAL,
+    LATENCY_STAGES
+};
+
+class InputLatency {
+
+    long long emptyAt;      // last read that found no key, 0 before the first
+    long long readAt;       // key being followed, 0 when none
+    long long turnAt;
+    long long renderAt;
+
+public:
+
+    LatencyHistogram stages[LATENCY_STAGES];
+    unsigned long long keys;
+    unsigned long long turns;
+
+    InputLatency() {
+        clear();
+    }
+
+    void clear() {
+        for (int i = 0; i < LATENCY_STAGES; i++) stages[i].clear();
+        emptyAt = readAt = turnAt = renderAt = 0;
+        keys = turns = 0;
+    }
+
+    void noKey(long long now) {
+        emptyAt = now;
+    }
+
+    void keyRead(long long now) {
+        keys++;
+        if (readAt != 0) return;
+        readAt = now;
+        if (emptyAt != 0) stages[LATENCY_QUEUED].record(now - emptyAt);
+    }
+
+    /**
+     * @brief A snake changed direction; ignored unless a key is being followed
+     */
+    void turned(long long now) {
+        if (readAt != 0 && turnAt == 0) turnAt = now;
+    }
+
+    void rendered(long long now) {
+        if (turnAt != 0) renderAt = now;
+    }
+
+    /**
+     * @brief A frame is out: the followed key's stages are recorded, or it is dropped if it turned nothing
+     */
+    void flushed(long long now) {
+        if (readAt == 0) return;
+        if (turnAt != 0 && renderAt != 0) {
+            stages[LATENCY_TURN].record(turnAt - readAt);
+            stages[LATENCY_RENDER].record(renderAt - turnAt);
+            stages[LATENCY_FLUSH].record(now - renderAt);
+            stages[LATENCY_TOTAL].record(now - readAt);
+            turns++;
+        }
+        readAt = turnAt = renderAt = 0;
+    }
+
+    /**
+     * @brief Percentiles of every stage, in microseconds
+     */
+    void report(FILE *out) const {
+        static const char *names[LATENCY_STAGES] = { "queued", "turn", "render", "flush", "total" };
+
+        fprintf(out, "%-9s %8s %10s %10s %10s %10s %10s %10s %10s\n",
+                "key us", "count", "min", "p50", "p90", "p99", "p99.9", "max", "mean");
+        for (int i = 0; i < LATENCY_STAGES; i++) {
+            const LatencyHistogram &h = stages[i];
+            fprintf(out, "%-9s %8llu %10.3f %10.3f %10.3f %10.3f %10.3f %10.3f %10.3f\n",
+                    names[i], h.getCount(), h.getMin() / 1000.0, h.percentile(50) / 1000.0,
+                    h.percentile(90) / 1000.0, h.percentile(99) / 1000.0, h.percentile(99.9) / 1000.0,
+                    h.getMax() / 1000.0, h.getMean() / 1000.0);
+        }
+        fprintf(out, "%llu keys read, %llu turned the snake\n", keys, turns);
+        fflush(out);
+    }
+};
+
+// Set while --input-latency is measuring
+static InputLatency *g_input_latency = nullptr;
+
+#endif
@@ -0,0 +1,267 @@
+#ifndef LOG_H_
+#define LOG_H_
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <ctime>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Structured logging to a file, off the game thread (--log=FILE).
+ *
+ *     LOG_INFO("game_over", "score", score, "length", length);
+ *
+ * An entry is an event name and up to LOG_MAX_FIELDS integer fields, with
+ * names and event given as string literals. The game thread copies them,
+ * with a timestamp, into a fixed-size slot of a single-producer /
+ * single-consumer ring and moves on; a background thread formats the
+ * slots as logfmt lines and writes them to the file:
+ *
+ *     ts=12.083411 level=info event=game_over score=14 length=9
+ *
+ * Nothing goes to stdout or stderr, which belong to the screen. When the
+ * ring is full the entry is dropped and the writer later notes how many
+ * were lost. Only the game thread may log.
+ *
+ * Levels below TSNAKE_LOG_LEVEL (info by default; make debug passes
+ * debug) are removed at compile time, arguments included, so LOG_DEBUG
+ * can stay in hot paths. Entries that are compiled in cost a pointer test
+ * when no log is open.
+ */
+
+#define LOG_LEVEL_DEBUG 0
+#define LOG_LEVEL_INFO 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_ERROR 3
+
+#ifndef TSNAKE_LOG_LEVEL
+#define TSNAKE_LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+#define LOG_MAX_FIELDS 4
+
+#define TSNAKE_LOG(level, ...) \
+    do { if ((level) >= TSNAKE_LOG_LEVEL) log_write((level), __VA_ARGS__); } while (0)
+
+#define LOG_DEBUG(...) TSNAKE_LOG(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#define LOG_INFO(...) TSNAKE_LOG(LOG_LEVEL_INFO, __VA_ARGS__)
+#define LOG_WARN(...) TSNAKE_LOG(LOG_LEVEL_WARN, __VA_ARGS__)
+#define LOG_ERROR(...) TSNAKE_LOG(LOG_LEVEL_ERROR, __VA_ARGS__)
+
+struct LogField {
+    const char *name;
+    long long value;
+};
+
+struct LogRecord {
+    long long ns;           // since the Logger was made
+    int level;
+    int count;              // fields used
+    const char *event;
+    LogField fields[LOG_MAX_FIELDS];
+};
+
+// Fields are integers; rates and other doubles are rounded
+inline long long log_value(double value) { return std::llround(value); }
+
+template <typename Value>
+inline long long log_value(Value value) { return static_cast<long long>(value); }
+
+inline void log_fields(LogRecord &, int) {}
+
+template <typename Value, typename... Rest>
+inline void log_fields(LogRecord &record, int i, const char *name, Value value, Rest... rest) {
+    record.fields[i].name = name;
+    record.fields[i].value = log_value(value);
+    log_fields(record, i + 1, rest...);
+}
+
+class Logger {
+
+    enum { POLL_MS = 20 };
+
+    std::vector<LogRecord> ring;
+    size_t mask;
+    std::atomic<size_t> head;   // written by the game thread
+    std::atomic<size_t> tail;   // written by the writer thread
+
+    int fd;
+    std::chrono::steady_clock::time_point start;
+    std::atomic<bool> running;
+    std::thread writer;
+
+    std::atomic<unsigned long> drops;
+    unsigned long dropsReported;
+
+    bool writeAll(const std::string &lines) {
+        size_t done = 0;
+        while (done < lines.size()) {
+            ssize_t n = ::write(fd, lines.data() + done, lines.size() - done);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            done += static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    static void appendLine(std::string &lines, const LogRecord &record) {
+        static const char *levels[] = { "debug", "info", "warn", "error" };
+
+        char text[64];
+        snprintf(text, sizeof(text), "ts=%lld.%06lld level=%s event=", record.ns / 1000000000LL,
+                 record.ns % 1000000000LL / 1000, levels[record.level & 3]);
+        lines += text;
+        lines += record.event;
+        for (int i = 0; i < record.count; i++) {
+            snprintf(text, sizeof(text), "=%lld", record.fields[i].value);
+            lines += ' ';
+            lines += record.fields[i].name;
+            lines += text;
+        }
+        lines += '\n';
+    }
+
+    // Formats every record the game thread has published
+    void drain(std::string &lines) {
+        size_t at = tail.load(std::memory_order_relaxed);
+        size_t end = head.load(std::memory_order_acquire);
+        for (; at < end; at++) appendLine(lines, ring[at & mask]);
+        tail.store(at, std::memory_order_release);
+
+        unsigned long lost = drops.load(std::memory_order_relaxed);
+        if (lost != dropsReported) {
+            LogRecord note;
+            note.ns = elapsed();
+            note.level = LOG_LEVEL_WARN;
+            note.count = 1;
+            note.event = "log_dropped";
+            note.fields[0].name = "count";
+            note.fields[0].value = static_cast<long long>(lost - dropsReported);
+            appendLine(lines, note);
+            dropsReported = lost;
+        }
+    }
+
+    void run() {
+        std::string lines;
+        while (running.load(std::memory_order_relaxed)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(POLL_MS));
+            lines.clear();
+            drain(lines);
+            if (!lines.empty()) writeAll(lines);
+        }
+        lines.clear();
+        drain(lines);
+        writeAll(lines);
+    }
+
+    Logger(const Logger &);
+    Logger &operator=(const Logger &);
+
+public:
+
+    /**
+     * @param capacity entries the ring holds, rounded up to a power of two
+     */
+    Logger(size_t capacity = 4096)
+        : head(0), tail(0), fd(-1), start(std::chrono::steady_clock::now()), running(false),
+          drops(0), dropsReported(0) {
+        size_t size = 16;
+        while (size < capacity) size <<= 1;
+        ring.resize(size);
+        mask = size - 1;
+    }
+
+    ~Logger() {
+        stop();
+    }
+
+    /**
+     * @brief Appends to the file at `path` and starts the writer
+     */
+    bool open(const char *path) {
+        fd = ::open(path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        if (fd < 0) return false;
+
+        LogRecord first;
+        first.ns = elapsed();
+        first.level = LOG_LEVEL_INFO;
+        first.event = "log_open";
+        first.count = 2;
+        log_fields(first, 0, "pid", getpid(), "unix_time", std::time(nullptr));
+        std::string line;
+        appendLine(line, first);
+        if (!writeAll(line)) return false;
+
+        running = true;
+        writer = std::thread(&Logger::run, this);
+        return true;
+    }
+
+    /**
+     * @brief Writes whatever is queued and closes the file
+     */
+    void stop() {
+        if (running.exchange(false)) writer.join();
+        if (fd >= 0) ::close(fd);
+        fd = -1;
+    }
+
+    long long elapsed() const {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    /**
+     * @brief The slot for the next entry, or null when the ring is full
+     */
+    LogRecord *claim() {
+        size_t at = head.load(std::memory_order_relaxed);
+        if (at - tail.load(std::memory_order_acquire) == ring.size()) {
+            drops.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        return &ring[at & mask];
+    }
+
+    /**
+     * @brief Hands the claimed slot to the writer
+     */
+    void publish() {
+        head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    unsigned long getDrops() const { return drops.load(std::memory_order_relaxed); }
+};
+
+// Set while --log is writing
+static Logger *g_logger = nullptr;
+
+/**
+ * @brief Queues one entry: an event literal, then name, value pairs
+ */
+template <typename... Fields>
+inline void log_write(int level, const char *event, Fields... fields) {
+    static_assert(sizeof...(Fields) % 2 == 0, "log fields come in name, value pairs");
+    static_assert(sizeof...(Fields) / 2 <= LOG_MAX_FIELDS, "too many log fields");
+
+    if (__builtin_expect(g_logger == nullptr, 1)) return;
+    LogRecord *record = g_logger->claim();
+    if (record == nullptr) return;
+    record->ns = g_logger->elapsed();
+    record->level = level;
+    record->count = static_cast<int>(sizeof...(Fields) / 2);
+    record->event = event;
+    log_fields(*record, 0, fields...);
+    g_logger->publish();
+}
+
+#endif
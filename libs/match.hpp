@@ -0,0 +1,343 @@
+#ifndef MATCH_H_
+#define MATCH_H_
+
+#include <vector>
+#include <random>
+#include "backend.hpp"
+#include "common.hpp"
+#include "point.hpp"
+#include "body.hpp"
+#include "grid.hpp"
+#include "spatial.hpp"
+
+/**
+ * Headless simulation of one or more snakes sharing a single board.
+ *
+ * All snakes move at the same time: every new head is checked against the
+ * board as it was before the tick, so the outcome never depends on the
+ * order players are stored in. The rules follow Game::isGameOver(): walls
+ * and any snake segment (tails included) kill, food grows the snake and
+ * adds the level to its score. Two heads landing on the same cell kill
+ * both snakes.
+ *
+ * The cells touched by the last step() are kept in getDirty() so a
+ * renderer only has to redraw a handful of cells per snake. Food cells are
+ * also kept in a FoodIndex for bots that need nearest-food queries.
+ */
+class Match {
+
+    enum Fate { MOVE, EAT, DIE };
+
+    Grid grid;
+    FoodIndex foodIndex;
+    std::mt19937 rng;
+    int level;
+    int foodCount;
+    unsigned long tick;
+
+    std::vector<Body> snakes;
+    std::vector<char> alive;
+    std::vector<int> scores;
+    std::vector<int> pending;
+    std::vector<int> growth;
+    std::vector<Point> foods;
+    std::vector<Point> dirty;
+
+    // Scratch space reused by every step()
+    std::vector<Point> heads;
+    std::vector<char> fates;
+    std::vector<unsigned short> claims;
+
+    Point spawnPoint(int player, int players, int &direction) const {
+        int rows = grid.getRows();
+        int cols = grid.getCols();
+        int row = (player + 1) * rows / (players + 1);
+        if (row < 2) row = 2;
+        if (row > rows - 3) row = rows - 3;
+
+        if (player % 2 == 0) {
+            direction = RIGHT;
+            return Point(row, 4);
+        }
+        direction = LEFT;
+        return Point(row, cols - 5);
+    }
+
+    // Crowded boards: pick a random free 3-cell run heading right
+    bool randomSpawnPoint(Point &head) {
+        std::uniform_int_distribution<int> xValue(1, grid.getRows() - 2);
+        std::uniform_int_distribution<int> yValue(3, grid.getCols() - 3);
+
+        for (int attempt = 0; attempt < 256; attempt++) {
+            Point p(xValue(rng), yValue(rng));
+            if (grid.get(p) == Grid::EMPTY &&
+                grid.get(Point(p.getX(), p.getY() - 1)) == Grid::EMPTY &&
+                grid.get(Point(p.getX(), p.getY() - 2)) == Grid::EMPTY &&
+                grid.get(Point(p.getX(), p.getY() + 1)) == Grid::EMPTY) {
+                head = p;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void occupy(int player) {
+        const Segments &segments = snakes[player].getSegments();
+        for (Segments::const_iterator it = segments.begin(); it != segments.end(); ++it) {
+            grid.set(*it, static_cast<unsigned short>(player + 1));
+            dirty.push_back(*it);
+        }
+    }
+
+    void placeFood() {
+        int rows = grid.getRows();
+        int cols = grid.getCols();
+        std::uniform_int_distribution<int> xValue(1, rows - 2);
+        std::uniform_int_distribution<int> yValue(1, cols - 2);
+
+        for (int attempt = 0; attempt < 64; attempt++) {
+            Point p(xValue(rng), yValue(rng));
+            if (grid.get(p) == Grid::EMPTY) {
+                addFood(p);
+                return;
+            }
+        }
+
+        // Crowded board: walk from a random cell until a free one shows up
+        const std::vector<unsigned short> &cells = grid.getCells();
+        int total = rows * cols;
+        int start = xValue(rng) * cols + yValue(rng);
+        for (int k = 0; k < total; k++) {
+            int idx = (start + k) % total;
+            if (cells[idx] == Grid::EMPTY) {
+                addFood(Point(idx / cols, idx % cols));
+                return;
+            }
+        }
+    }
+
+    void addFood(const Point &p) {
+        grid.set(p, Grid::FOOD);
+        foods.push_back(p);
+        foodIndex.insert(p);
+        dirty.push_back(p);
+    }
+
+    void removeFood(const Point &p) {
+        foodIndex.remove(p);
+        for (size_t i = 0; i < foods.size(); i++) {
+            if (foods[i].getX() == p.getX() && foods[i].getY() == p.getY()) {
+                foods[i] = foods.back();
+                foods.pop_back();
+                return;
+            }
+        }
+    }
+
+    void kill(int player) {
+        const Segments &segments = snakes[player].getSegments();
+        for (Segments::const_iterator it = segments.begin(); it != segments.end(); ++it) {
+            grid.set(*it, Grid::EMPTY);
+            dirty.push_back(*it);
+        }
+        alive[player] = 0;
+    }
+
+public:
+
+    Match(int rows, int cols, int players, int level, unsigned int seed, int foodCount = 1)
+        : grid(rows, cols), foodIndex(rows, cols), rng(seed), level(level), foodCount(foodCount), tick(0),
+          snakes(players), alive(players, 1), scores(players, 0), pending(players, ERR),
+          growth(players, 0), heads(players), fates(players), claims(rows * cols, 0) {
+
+        reset(seed);
+    }
+
+    /**
+     * @brief Starts the match over in place, reusing all storage
+     */
+    void reset(unsigned int seed) {
+        rng.seed(seed);
+        tick = 0;
+        grid.clear();
+        foods.clear();
+        foodIndex.clear();
+
+        int players = getPlayers();
+        for (int i = 0; i < players; i++) {
+            int direction = RIGHT;
+            Point head;
+            alive[i] = 1;
+            if (players <= 4) {
+                head = spawnPoint(i, players, direction);
+            } else if (!randomSpawnPoint(head)) {
+                alive[i] = 0;
+            }
+            snakes[i] = Body(head, direction, 3);
+            if (alive[i]) occupy(i);
+
+            scores[i] = 0;
+            pending[i] = ERR;
+            growth[i] = 0;
+        }
+
+        for (int k = 0; k < foodCount; k++) {
+            placeFood();
+        }
+        dirty.clear();
+    }
+
+    /**
+     * @brief Brings a dead snake back at a random free spot with score 0
+     * @return false when no free spot was found
+     */
+    bool respawn(int player) {
+        if (alive[player]) return true;
+
+        Point head;
+        if (!randomSpawnPoint(head)) return false;
+
+        snakes[player] = Body(head, RIGHT, 3);
+        scores[player] = 0;
+        pending[player] = ERR;
+        growth[player] = 0;
+        alive[player] = 1;
+        occupy(player);
+        return true;
+    }
+
+    /**
+     * @brief Queues a turn for the next step(); only the latest one counts
+     */
+    void setDirection(int player, int direction) {
+        if (player >= 0 && player < static_cast<int>(snakes.size())) {
+            pending[player] = direction;
+        }
+    }
+
+    /**
+     * @brief Keeps the tail of a snake in place for its next `segments` moves
+     */
+    void grow(int player, int segments) {
+        if (player >= 0 && player < static_cast<int>(snakes.size()) && segments > 0) {
+            growth[player] += segments;
+        }
+    }
+
+    /**
+     * @brief Advances every live snake by one cell
+     * @return number of snakes still alive
+     */
+    int step() {
+        dirty.clear();
+        int players = static_cast<int>(snakes.size());
+
+        // Phase 1: each snake looks at the board as it was before the tick
+        for (int i = 0; i < players; i++) {
+            if (!alive[i]) continue;
+
+            snakes[i].validateDirection(pending[i]);
+            pending[i] = ERR;
+
+            heads[i] = snakes[i].investigatePosition();
+            unsigned short owner = grid.get(heads[i]);
+            if (owner == Grid::EMPTY) fates[i] = MOVE;
+            else if (owner == Grid::FOOD) fates[i] = EAT;
+            else fates[i] = DIE;
+        }
+
+        // Phase 2: heads entering the same cell kill each other
+        for (int i = 0; i < players; i++) {
+            if (!alive[i] || fates[i] == DIE) continue;
+            int idx = grid.index(heads[i]);
+            if (claims[idx] == 0) {
+                claims[idx] = static_cast<unsigned short>(i + 1);
+            } else {
+                fates[i] = DIE;
+                fates[claims[idx] - 1] = DIE;
+            }
+        }
+        for (int i = 0; i < players; i++) {
+            if (alive[i] && grid.inside(heads[i])) claims[grid.index(heads[i])] = 0;
+        }
+
+        // Phase 3: apply the outcome in player order
+        int eaten = 0;
+        for (int i = 0; i < players; i++) {
+            if (alive[i] && fates[i] == DIE) kill(i);
+        }
+        for (int i = 0; i < players; i++) {
+            if (!alive[i]) continue;
+
+            dirty.push_back(snakes[i].getHead());
+            snakes[i].setHead(heads[i]);
+            dirty.push_back(heads[i]);
+
+            if (fates[i] == EAT) {
+                removeFood(heads[i]);
+                scores[i] += level;
+                eaten++;
+            } else if (growth[i] > 0) {
+                growth[i]--;
+            } else {
+                Point tail = snakes[i].getTail();
+                grid.set(tail, Grid::EMPTY);
+                dirty.push_back(tail);
+                snakes[i].removeTail();
+            }
+            grid.set(heads[i], static_cast<unsigned short>(i + 1));
+        }
+
+        for (int k = 0; k < eaten; k++) {
+            placeFood();
+        }
+
+        tick++;
+        return getAlive();
+    }
+
+    int getAlive() const {
+        int count = 0;
+        for (size_t i = 0; i < alive.size(); i++) count += alive[i];
+        return count;
+    }
+
+    bool isOver() const {
+        return snakes.size() > 1 ? getAlive() <= 1 : getAlive() == 0;
+    }
+
+    /**
+     * @brief FNV-1a hash of everything that decides future ticks
+     */
+    unsigned int checksum() const {
+        unsigned int hash = 2166136261u;
+        const std::vector<unsigned short> &cells = grid.getCells();
+        for (size_t i = 0; i < cells.size(); i++) {
+            hash = (hash ^ (cells[i] & 0xFF)) * 16777619u;
+            hash = (hash ^ (cells[i] >> 8)) * 16777619u;
+        }
+        for (size_t i = 0; i < snakes.size(); i++) {
+            hash = (hash ^ static_cast<unsigned int>(scores[i])) * 16777619u;
+            hash = (hash ^ static_cast<unsigned int>(alive[i])) * 16777619u;
+            hash = (hash ^ static_cast<unsigned int>(growth[i])) * 16777619u;
+            hash = (hash ^ static_cast<unsigned int>(snakes[i].getDirection())) * 16777619u;
+            hash = (hash ^ static_cast<unsigned int>(grid.index(snakes[i].getHead()))) * 16777619u;
+        }
+        return (hash ^ static_cast<unsigned int>(tick)) * 16777619u;
+    }
+
+    int getPlayers() const { return static_cast<int>(snakes.size()); }
+    int getLevel() const { return level; }
+    unsigned long getTick() const { return tick; }
+
+    bool isAlive(int player) const { return alive[player] != 0; }
+    int getScore(int player) const { return scores[player]; }
+    const Body &getSnake(int player) const { return snakes[player]; }
+
+    const Grid &getGrid() const { return grid; }
+    const std::vector<Point> &getFoods() const { return foods; }
+    const FoodIndex &getFoodIndex() const { return foodIndex; }
+    const std::vector<Point> &getDirty() const { return dirty; }
+};
+
+#endif
@@ -0,0 +1,173 @@
+#ifndef MATCHVIEW_H_
+#define MATCHVIEW_H_
+
+#include <vector>
+#include "backend.hpp"
+#include "match.hpp"
+#include "board.hpp"
+
+#define MAX_PLAYERS 4
+
+/**
+ * Draws a Match into the screen buffer.
+ *
+ * Match coordinates start right below the status bar. drawBoard() paints
+ * every cell and is meant for the first frame (or after the match state
+ * jumped, e.g. a netplay rollback); drawDirty() repaints only the cells the
+ * last step touched.
+ */
+class MatchView {
+
+    const Match &match;
+    std::vector<int> shownScores;
+    std::vector<char> shownAlive;
+
+    bool statusChanged() const {
+        for (int i = 0; i < match.getPlayers(); i++) {
+            if (shownScores[i] != match.getScore(i) || shownAlive[i] != match.isAlive(i)) return true;
+        }
+        return false;
+    }
+
+public:
+
+    MatchView(const Match &match)
+        : match(match), shownScores(match.getPlayers(), -1), shownAlive(match.getPlayers(), 0) {}
+
+    static int playerColor(int player) {
+        static const int colors[MAX_PLAYERS] = { COLOR_SNAKE_HEAD, COLOR_SCORE, COLOR_HIGHSCORE, COLOR_BORDER };
+        return colors[player % MAX_PLAYERS];
+    }
+
+    void drawCell(const Point &p) {
+        const Grid &grid = match.getGrid();
+        int row = p.getX();
+        int col = p.getY();
+        int y = row + 1;
+        unsigned short owner = grid.get(p);
+
+        if (owner == Grid::WALL) {
+            bool top = row == 0, bottom = row == grid.getRows() - 1;
+            bool left = col == 0, right = col == grid.getCols() - 1;
+            chtype ch = ACS_VLINE;
+            if (top && left) ch = ACS_ULCORNER;
+            else if (top && right) ch = ACS_URCORNER;
+            else if (bottom && left) ch = ACS_LLCORNER;
+            else if (bottom && right) ch = ACS_LRCORNER;
+            else if (top || bottom) ch = ACS_HLINE;
+
+            attron(COLOR_PAIR(COLOR_BORDER) | A_BOLD);
+            mvaddch(y, col, ch);
+            attroff(COLOR_PAIR(COLOR_BORDER) | A_BOLD);
+        } else if (owner == Grid::FOOD) {
+            attron(COLOR_PAIR(COLOR_FOOD) | A_BOLD);
+            mvaddch(y, col, ACS_DIAMOND);
+            attroff(COLOR_PAIR(COLOR_FOOD) | A_BOLD);
+        } else if (owner == Grid::EMPTY) {
+            mvaddch(y, col, ' ');
+        } else {
+            int player = owner - 1;
+            Point head = match.getSnake(player).getHead();
+            bool isHead = head.getX() == row && head.getY() == col;
+
+            attron(COLOR_PAIR(playerColor(player)) | (isHead ? A_BOLD : 0));
+            mvaddch(y, col, isHead ? 'O' : 'o');
+            attroff(COLOR_PAIR(playerColor(player)) | A_BOLD);
+        }
+    }
+
+    void drawBoard() {
+        const Grid &grid = match.getGrid();
+        for (int i = 0; i < grid.getRows(); i++) {
+            for (int j = 0; j < grid.getCols(); j++) {
+                drawCell(Point(i, j));
+            }
+        }
+        drawStatusBar();
+    }
+
+    void drawDirty() {
+        const std::vector<Point> &dirty = match.getDirty();
+        for (size_t i = 0; i < dirty.size(); i++) {
+            drawCell(dirty[i]);
+        }
+        if (statusChanged()) {
+            drawStatusBar();
+        }
+    }
+
+    void drawStatusBar() {
+        attron(COLOR_PAIR(COLOR_STATUS_BG) | A_BOLD);
+        for (int j = 0; j < COLS; j++) {
+            mvaddch(0, j, ' ');
+        }
+        attroff(COLOR_PAIR(COLOR_STATUS_BG) | A_BOLD);
+
+        for (int i = 0; i < match.getPlayers(); i++) {
+            attron(COLOR_PAIR(playerColor(i)) | A_BOLD);
+            mvprintw(0, 2 + i * 16, " P%d %c %d ", i + 1, match.isAlive(i) ? ' ' : 'x', match.getScore(i));
+            attroff(COLOR_PAIR(playerColor(i)) | A_BOLD);
+
+            shownScores[i] = match.getScore(i);
+            shownAlive[i] = match.isAlive(i);
+        }
+    }
+
+    void printGameOver(const char *prompt) {
+        int boxWidth = 40;
+        int boxHeight = 9 + match.getPlayers();
+        int startY = (LINES / 2) - (boxHeight / 2);
+        int startX = (COLS / 2) - (boxWidth / 2);
+
+        attron(COLOR_PAIR(COLOR_GAMEOVER));
+        for (int i = 0; i < boxHeight; i++) {
+            for (int j = 0; j < boxWidth; j++) {
+                mvaddch(startY + i, startX + j, ' ');
+            }
+        }
+
+        attron(COLOR_PAIR(COLOR_GAMEOVER) | A_BOLD);
+        mvaddch(startY, startX, ACS_ULCORNER);
+        mvaddch(startY, startX + boxWidth - 1, ACS_URCORNER);
+        mvaddch(startY + boxHeight - 1, startX, ACS_LLCORNER);
+        mvaddch(startY + boxHeight - 1, startX + boxWidth - 1, ACS_LRCORNER);
+        for (int j = 1; j < boxWidth - 1; j++) {
+            mvaddch(startY, startX + j, ACS_HLINE);
+            mvaddch(startY + boxHeight - 1, startX + j, ACS_HLINE);
+        }
+        for (int i = 1; i < boxHeight - 1; i++) {
+            mvaddch(startY + i, startX, ACS_VLINE);
+            mvaddch(startY + i, startX + boxWidth - 1, ACS_VLINE);
+        }
+
+        mvprintw(startY + 2, startX + (boxWidth / 2) - 5, "GAME OVER");
+
+        int winner = -1;
+        for (int i = 0; i < match.getPlayers(); i++) {
+            if (match.isAlive(i)) winner = i;
+        }
+        attroff(COLOR_PAIR(COLOR_GAMEOVER));
+
+        if (winner >= 0) {
+            attron(COLOR_PAIR(playerColor(winner)) | A_BOLD);
+            mvprintw(startY + 4, startX + (boxWidth / 2) - 7, "PLAYER %d WINS!", winner + 1);
+            attroff(COLOR_PAIR(playerColor(winner)) | A_BOLD);
+        } else {
+            attron(COLOR_PAIR(COLOR_SCORE) | A_BOLD);
+            mvprintw(startY + 4, startX + (boxWidth / 2) - 2, "DRAW");
+            attroff(COLOR_PAIR(COLOR_SCORE) | A_BOLD);
+        }
+
+        for (int i = 0; i < match.getPlayers(); i++) {
+            attron(COLOR_PAIR(playerColor(i)));
+            mvprintw(startY + 6 + i, startX + (boxWidth / 2) - 8, "PLAYER %d: %d", i + 1, match.getScore(i));
+            attroff(COLOR_PAIR(playerColor(i)));
+        }
+
+        attron(COLOR_PAIR(COLOR_BORDER));
+        mvprintw(startY + boxHeight - 2, startX + (boxWidth / 2) - static_cast<int>(std::strlen(prompt)) / 2, "%s", prompt);
+        attroff(COLOR_PAIR(COLOR_BORDER));
+    }
+};
+
+#endif
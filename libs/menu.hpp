@@ -4,13 +4,15 @@
 #include <string>
 #include <vector>
 #include "common.hpp"
-#include "terminal.hpp"
+#include "backend.hpp"
+#include "allocstats.hpp"
 
 class Menu {
 
 private:
     int selectedOption;
     int difficultyLevel;
+    int playerCount;
     int animationFrame;
     std::vector<std::string> menuOptions;
     std::vector<std::string> difficultyOptions;
@@ -19,18 +21,19 @@ private:
         // Animated color effect for the logo
         int colorShift = animationFrame % 3;
         
-        std::vector<std::string> logo = {
+        static const char *const logo[] = {
             "  ___  _  _   _   _  _____",
             " / __|| \\| | /_\\ | |/ / __|",
             " \\__ \\| .` |/ _ \\| ' <| _|",
             " |___/|_|\\_/_/ \\_\\_|\\_\\___|"
         };
+        const size_t logoLines = sizeof(logo) / sizeof(logo[0]);
 
         int logoWidth = 28;
         int logoStartX = startX - (logoWidth / 2);
 
         // Draw each line with animated colors
-        for (size_t i = 0; i < logo.size(); i++) {
+        for (size_t i = 0; i < logoLines; i++) {
             int colorPair = ((static_cast<int>(i) + colorShift) % 3) + 1;
             if (colorPair == 1) {
                 attron(COLOR_PAIR(1) | A_BOLD);  // Cyan
@@ -39,7 +42,7 @@ private:
             } else {
                 attron(COLOR_PAIR(5) | A_BOLD);  // Yellow
             }
-            mvprintw(startY + static_cast<int>(i), logoStartX, "%s", logo[i].c_str());
+            mvprintw(startY + static_cast<int>(i), logoStartX, "%s", logo[i]);
             attroff(COLOR_PAIR(1) | A_BOLD);
             attroff(COLOR_PAIR(2) | A_BOLD);
             attroff(COLOR_PAIR(5) | A_BOLD);
@@ -76,8 +79,8 @@ private:
     }
 
 public:
-    Menu() : selectedOption(0), difficultyLevel(1), animationFrame(0) {
-        menuOptions = {"Start Game", "Settings", "Exit"};
+    Menu() : selectedOption(0), difficultyLevel(1), playerCount(2), animationFrame(0) {
+        menuOptions = {"Start Game", "Multiplayer", "Settings", "Exit"};
         difficultyOptions = {"Easy", "Normal", "Hard", "Insane"};
     }
 
@@ -92,7 +95,10 @@ public:
         }
     }
 
+    int getPlayerCount() const { return playerCount; }
+
     int showMainMenu(int highscore) {
+        AllocScope alloc(ALLOC_MENU);
         clear();
         
         // Increment animation frame
@@ -105,7 +111,7 @@ public:
         drawLogo(3, centerX);
 
         // Menu box
-        int boxHeight = 12;
+        int boxHeight = 14;
         int boxWidth = 30;
         int boxY = centerY - 2;
         int boxX = centerX - boxWidth / 2;
@@ -160,7 +166,7 @@ public:
             case 'q':
             case 'Q':
                 timeout(-1);  // Reset to blocking
-                return 2;  // Exit
+                return static_cast<int>(menuOptions.size()) - 1;  // Exit
             case ERR:  // Timeout - just continue animating
                 return -1;
             default:
@@ -175,7 +181,7 @@ public:
         int centerX = COLS / 2;
 
         // Settings box
-        int boxHeight = 14;
+        int boxHeight = 17;
         int boxWidth = 40;
         int boxY = centerY - boxHeight / 2;
         int boxX = centerX - boxWidth / 2;
@@ -204,9 +210,18 @@ public:
             attroff(COLOR_PAIR(1));
         }
 
+        // Player count for multiplayer
+        attron(COLOR_PAIR(5));
+        mvprintw(boxY + 10, boxX + 3, "Players:");
+        attroff(COLOR_PAIR(5));
+        attron(COLOR_PAIR(2) | A_BOLD);
+        mvprintw(boxY + 10, centerX - 2, "< %d >", playerCount);
+        attroff(COLOR_PAIR(2) | A_BOLD);
+
         // Instructions
         attron(COLOR_PAIR(5));
-        mvprintw(boxY + boxHeight - 3, boxX + 5, "Up/Down: Change difficulty");
+        mvprintw(boxY + boxHeight - 4, boxX + 5, "Up/Down: Change difficulty");
+        mvprintw(boxY + boxHeight - 3, boxX + 5, "Left/Right: Change players");
         mvprintw(boxY + boxHeight - 2, boxX + 5, "Q: Back to main menu");
         attroff(COLOR_PAIR(5));
 
@@ -221,6 +236,12 @@ public:
             case KEY_DOWN:
                 difficultyLevel = (difficultyLevel + 1) % static_cast<int>(difficultyOptions.size());
                 return false;
+            case KEY_LEFT:
+                if (playerCount > 2) playerCount--;
+                return false;
+            case KEY_RIGHT:
+                if (playerCount < 4) playerCount++;
+                return false;
             case 'q':
             case 'Q':
             case '\n':
@@ -0,0 +1,134 @@
+#ifndef MULTIGAME_H_
+#define MULTIGAME_H_
+
+#include <cctype>
+#include "common.hpp"
+#include "scheduler.hpp"
+#include "tickstats.hpp"
+#include "log.hpp"
+#include "backend.hpp"
+#include "match.hpp"
+#include "matchview.hpp"
+#include "replay.hpp"
+
+/**
+ * Hot-seat game for 2-4 snakes sharing one keyboard.
+ *
+ * Player 1 steers with the arrows, player 2 with WASD, player 3 with IJKL
+ * and player 4 with the numpad (8/4/5/6 or 8/4/2/6 with NumLock on).
+ * The board is drawn in full once; after that only the cells reported by
+ * Match::getDirty() are redrawn, so a frame costs a few cells per snake.
+ * Every turn is also noted in a Replay that can be saved once it is over.
+ */
+class MultiGame {
+
+    Match match;
+    MatchView view;
+    TickScheduler schedule;
+    Replay replay;
+
+public:
+
+    /**
+     * @brief Maps a key to (player, direction); returns false for other keys
+     */
+    static bool mapKey(int key, int &player, int &direction) {
+        switch (key) {
+            case KEY_UP: player = 0; direction = UP; return true;
+            case KEY_DOWN: player = 0; direction = DOWN; return true;
+            case KEY_LEFT: player = 0; direction = LEFT; return true;
+            case KEY_RIGHT: player = 0; direction = RIGHT; return true;
+        }
+
+        switch (tolower(key)) {
+            case 'w': player = 1; direction = UP; return true;
+            case 's': player = 1; direction = DOWN; return true;
+            case 'a': player = 1; direction = LEFT; return true;
+            case 'd': player = 1; direction = RIGHT; return true;
+            case 'i': player = 2; direction = UP; return true;
+            case 'k': player = 2; direction = DOWN; return true;
+            case 'j': player = 2; direction = LEFT; return true;
+            case 'l': player = 2; direction = RIGHT; return true;
+            case '8': player = 3; direction = UP; return true;
+            case '5':
+            case '2': player = 3; direction = DOWN; return true;
+            case '4': player = 3; direction = LEFT; return true;
+            case '6': player = 3; direction = RIGHT; return true;
+        }
+
+        return false;
+    }
+
+    MultiGame(int players, int level, unsigned int seed, const TickConfig &config = TickConfig())
+        : match(LINES - 1, COLS, players, level, seed), view(match),
+          schedule(config.rate > 0 ? config.rate : tick_rate_for_level(level)),
+          replay(LINES - 1, COLS, players, level, seed) {
+
+        schedule.configure(config);
+        LOG_INFO("match_start", "players", players, "difficulty", level, "rate_mhz", schedule.getRate() * 1000);
+
+        // First frame draws the whole board, later ones only the dirty cells
+        view.drawBoard();
+        refresh();
+    }
+
+    void handleKey(int key) {
+        int player, direction;
+        if (mapKey(key, player, direction) && player < match.getPlayers()) {
+            match.setDirection(player, direction);
+            replay.record(match.getTick(), player, direction);
+        }
+    }
+
+    bool isGameOver() {
+
+        // Drain every pending key so no player starves the others
+        int key;
+        while ((key = getch()) != ERR) {
+            handleKey(key);
+        }
+
+        unsigned long long missed = schedule.getMissed();
+        long long lateness;
+
+        if (schedule.poll(lateness)) {
+
+            if (g_tick_stats != nullptr) g_tick_stats->beginTick(lateness, schedule.getMissed() - missed);
+            if (schedule.getMissed() != missed) {
+                LOG_WARN("deadline_missed", "tick", schedule.getTicks(), "missed", schedule.getMissed() - missed,
+                         "late_us", lateness / 1000, "dropped", schedule.getDropped());
+            }
+
+            match.step();
+            view.drawDirty();
+
+            if (match.isOver()) {
+                replay.finish(match.getTick());
+                LOG_INFO("match_over", "ticks", match.getTick(), "missed", schedule.getMissed());
+                view.printGameOver("Play again? (Y/n)");
+                if (g_tick_stats != nullptr) g_tick_stats->endCompute();
+                refresh();
+                tick_stats_end_tick();
+                return true;
+            }
+
+            if (g_tick_stats != nullptr) g_tick_stats->endCompute();
+            refresh();
+            tick_stats_end_tick();
+        }
+
+        return false;
+    }
+
+    /**
+     * @brief Sleeps until the next tick is due; isGameOver() then runs it
+     */
+    void waitForTick() const {
+        schedule.wait();
+    }
+
+    const Match &getMatch() const { return match; }
+    const Replay &getReplay() const { return replay; }
+};
+
+#endif
@@ -0,0 +1,89 @@
+#ifndef NETGAME_H_
+#define NETGAME_H_
+
+#include "common.hpp"
+#include "clock.hpp"
+#include "backend.hpp"
+#include "matchview.hpp"
+#include "multigame.hpp"
+#include "netplay.hpp"
+
+/**
+ * One side of a two-player game played over the network.
+ *
+ * The local snake is steered with the arrows (or WASD); the remote one
+ * follows the inputs received by the NetSession. A tick that gets rewound
+ * by a rollback redraws the whole board, any other tick only its dirty
+ * cells.
+ */
+class NetGame {
+
+    NetSession session;
+    MatchView view;
+    Clock clock;
+    int pending;
+
+    void drawNetStatus() {
+        attron(COLOR_PAIR(COLOR_STATUS_BG) | A_BOLD);
+        mvprintw(0, COLS - 22, " YOU: P%d %s ", session.getLocalPlayer() + 1,
+                 session.getDesyncs() > 0 ? "DESYNC" : "      ");
+        attroff(COLOR_PAIR(COLOR_STATUS_BG) | A_BOLD);
+    }
+
+public:
+
+    NetGame(NetLink &link, int localPlayer, const NetConfig &config)
+        : session(link, localPlayer, config), view(session.getMatch()), pending(ERR) {
+
+        view.drawBoard();
+        drawNetStatus();
+        refresh();
+    }
+
+    bool isGameOver() {
+
+        int key;
+        while ((key = getch()) != ERR) {
+            int player, direction;
+            if (MultiGame::mapKey(key, player, direction) && player <= 1) {
+                pending = direction;
+            }
+        }
+
+        if (session.poll()) {
+            view.drawBoard();
+            drawNetStatus();
+            refresh();
+        }
+
+        if (clock.getTimestamp() >= DELAY) {
+
+            if (session.advance(pending)) {
+                pending = ERR;
+                view.drawDirty();
+                drawNetStatus();
+                refresh();
+                clock.reset();
+            }
+        }
+
+        if (session.isOver()) {
+            view.drawBoard();
+            view.printGameOver("Press any key");
+            refresh();
+            return true;
+        }
+
+        if (session.hasPeerLeft()) {
+            view.printGameOver("Opponent left - press any key");
+            refresh();
+            return true;
+        }
+
+        return false;
+    }
+
+    const NetSession &getSession() const { return session; }
+};
+
+#endif
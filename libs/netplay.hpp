@@ -0,0 +1,444 @@
+#ifndef NETPLAY_H_
+#define NETPLAY_H_
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <csignal>
+#include <cstring>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "common.hpp"
+#include "match.hpp"
+#include "wire.hpp"
+
+#define NET_DEFAULT_PORT 7777
+
+// Packet types
+#define NET_HELLO 1
+#define NET_WELCOME 2
+#define NET_INPUT 3
+#define NET_BYE 4
+
+/**
+ * Parameters both peers must agree on before the first tick
+ */
+struct NetConfig {
+    int rows;
+    int cols;
+    int level;
+    unsigned int seed;
+
+    NetConfig() : rows(0), cols(0), level(2), seed(0) {}
+};
+
+/**
+ * Non-blocking UDP socket bound to a single peer.
+ *
+ * The listening side learns its peer from the first datagram it receives;
+ * packets from anyone else are dropped afterwards.
+ */
+class NetLink {
+
+    int sock;
+    sockaddr_in peer;
+    bool hasPeer;
+
+    bool open() {
+        sock = socket(AF_INET, SOCK_DGRAM, 0);
+        if (sock < 0) return false;
+        fcntl(sock, F_SETFL, fcntl(sock, F_GETFL, 0) | O_NONBLOCK);
+        return true;
+    }
+
+public:
+
+    NetLink() : sock(-1), hasPeer(false) { std::memset(&peer, 0, sizeof(peer)); }
+
+    ~NetLink() {
+        if (sock >= 0) close(sock);
+    }
+
+    /**
+     * @brief Binds to `port` on every interface (0 picks a free port)
+     */
+    bool listen(int port) {
+        if (!open()) return false;
+
+        sockaddr_in addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_ANY);
+        addr.sin_port = htons(static_cast<unsigned short>(port));
+        return bind(sock, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) == 0;
+    }
+
+    bool connect(const char *host, int port) {
+        if (!open()) return false;
+
+        addrinfo hints;
+        std::memset(&hints, 0, sizeof(hints));
+        hints.ai_family = AF_INET;
+        hints.ai_socktype = SOCK_DGRAM;
+
+        addrinfo *result = nullptr;
+        if (getaddrinfo(host, nullptr, &hints, &result) != 0 || !result) return false;
+
+        std::memcpy(&peer, result->ai_addr, sizeof(peer));
+        peer.sin_port = htons(static_cast<unsigned short>(port));
+        freeaddrinfo(result);
+        hasPeer = true;
+        return true;
+    }
+
+    int getPort() const {
+        sockaddr_in addr;
+        socklen_t len = sizeof(addr);
+        if (getsockname(sock, reinterpret_cast<sockaddr *>(&addr), &len) != 0) return -1;
+        return ntohs(addr.sin_port);
+    }
+
+    bool send(const unsigned char *data, size_t len) {
+        if (!hasPeer) return false;
+        return sendto(sock, data, len, 0, reinterpret_cast<const sockaddr *>(&peer), sizeof(peer)) == static_cast<ssize_t>(len);
+    }
+
+    /**
+     * @brief Reads one datagram from the peer
+     * @return its length, or -1 when nothing is pending
+     */
+    int receive(unsigned char *buffer, size_t capacity) {
+        for (;;) {
+            sockaddr_in from;
+            socklen_t len = sizeof(from);
+            ssize_t n = recvfrom(sock, buffer, capacity, 0, reinterpret_cast<sockaddr *>(&from), &len);
+            if (n < 0) return -1;
+
+            if (!hasPeer) {
+                peer = from;
+                hasPeer = true;
+            } else if (from.sin_addr.s_addr != peer.sin_addr.s_addr || from.sin_port != peer.sin_port) {
+                continue;
+            }
+            return static_cast<int>(n);
+        }
+    }
+};
+
+void netSendWelcome(NetLink &link, const NetConfig &config) {
+    unsigned char reply[10];
+    reply[0] = NET_WELCOME;
+    netPut32(reply + 1, config.seed);
+    reply[5] = static_cast<unsigned char>(config.level);
+    netPut16(reply + 6, config.rows);
+    netPut16(reply + 8, config.cols);
+    link.send(reply, sizeof(reply));
+}
+
+/**
+ * Host side of the handshake: waits for HELLO, answers with WELCOME.
+ * The board is the smaller of both terminals.
+ */
+bool netHostHandshake(NetLink &link, NetConfig &config, const volatile sig_atomic_t &cancel) {
+    unsigned char buffer[64];
+    while (!cancel) {
+        int n = link.receive(buffer, sizeof(buffer));
+        if (n >= 5 && buffer[0] == NET_HELLO) {
+            int rows = netGet16(buffer + 1);
+            int cols = netGet16(buffer + 3);
+            if (rows < config.rows) config.rows = rows;
+            if (cols < config.cols) config.cols = cols;
+
+            netSendWelcome(link, config);
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return false;
+}
+
+/**
+ * Joining side of the handshake: repeats HELLO until WELCOME arrives
+ */
+bool netJoinHandshake(NetLink &link, NetConfig &config, const volatile sig_atomic_t &cancel) {
+    unsigned char hello[5];
+    hello[0] = NET_HELLO;
+    netPut16(hello + 1, config.rows);
+    netPut16(hello + 3, config.cols);
+
+    unsigned char buffer[64];
+    for (int attempt = 0; attempt < 150 && !cancel; attempt++) {
+        link.send(hello, sizeof(hello));
+        for (int wait = 0; wait < 20; wait++) {
+            int n = link.receive(buffer, sizeof(buffer));
+            if (n >= 10 && buffer[0] == NET_WELCOME) {
+                config.seed = netGet32(buffer + 1);
+                config.level = buffer[5];
+                config.rows = netGet16(buffer + 6);
+                config.cols = netGet16(buffer + 8);
+                return true;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+    return false;
+}
+
+/**
+ * Two-player match kept in lockstep over a NetLink with rollback.
+ *
+ * Each peer simulates the same Match from the shared seed. Only per-tick
+ * inputs travel on the wire: every packet carries all local inputs the
+ * peer has not acknowledged yet, so a lost datagram is repaired by the
+ * next one. Remote inputs that have not arrived are predicted as "no
+ * turn". When the real input turns out to be a turn, the state saved
+ * before that tick is restored and the ticks since are simulated again.
+ *
+ * Snapshots are plain Match copies kept in a ring that is reused every
+ * tick; copy-assigning into a warm slot reuses its storage, so a snapshot
+ * is little more than a copy of the grid.
+ * Once both inputs of a tick are final its state checksum is exchanged;
+ * a mismatch is counted as a desync.
+ */
+class NetSession {
+
+public:
+
+    enum { WINDOW = 64, MAX_AHEAD = 12, MAX_BATCH = 32 };
+
+private:
+
+    NetLink &link;
+    NetConfig config;
+    int local;
+    int remote;
+
+    Match match;
+    std::vector<Match> snapshots;
+    signed char inputs[WINDOW][2];
+    unsigned int checksums[WINDOW];
+
+    int current;          // ticks simulated so far
+    int remoteConfirmed;  // last tick with a known remote input
+    int peerAck;          // last local tick the peer confirmed
+    int checked;          // last tick with a final checksum
+    int rollbackFrom;     // earliest mispredicted tick, -1 when none
+    int pendingCheckTick; // peer checksum we could not verify yet
+    unsigned int pendingCheckValue;
+
+    int rollbacks;
+    int maxRollback;
+    int desyncs;
+    int verified;
+    double maxResimMs;
+    bool peerGone;
+    std::chrono::steady_clock::time_point lastHeard;
+
+    int remoteInput(int tick) const {
+        return tick <= remoteConfirmed ? inputs[tick % WINDOW][remote] : ERR;
+    }
+
+    void simulate(int tick) {
+        snapshots[tick % WINDOW] = match;
+        match.setDirection(local, inputs[tick % WINDOW][local]);
+        match.setDirection(remote, remoteInput(tick));
+        match.step();
+    }
+
+    void rollback() {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+        int depth = current - rollbackFrom;
+        match = snapshots[rollbackFrom % WINDOW];
+        for (int t = rollbackFrom; t < current; t++) {
+            simulate(t);
+        }
+
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (ms > maxResimMs) maxResimMs = ms;
+        if (depth > maxRollback) maxRollback = depth;
+        rollbacks++;
+        rollbackFrom = -1;
+    }
+
+    // State after `tick` is the snapshot taken before the next one
+    unsigned int checksumAfter(int tick) const {
+        return tick == current - 1 ? match.checksum() : snapshots[(tick + 1) % WINDOW].checksum();
+    }
+
+    void updateChecksums() {
+        int last = remoteConfirmed < current - 1 ? remoteConfirmed : current - 1;
+        for (int t = checked + 1; t <= last; t++) {
+            checksums[t % WINDOW] = checksumAfter(t);
+        }
+        if (last > checked) checked = last;
+
+        if (pendingCheckTick >= 0 && pendingCheckTick <= checked) {
+            if (pendingCheckTick > checked - WINDOW) {
+                if (checksums[pendingCheckTick % WINDOW] != pendingCheckValue) desyncs++;
+                verified++;
+            }
+            pendingCheckTick = -1;
+        }
+    }
+
+    void handleInput(const unsigned char *packet, int len) {
+        if (len < 18) return;
+
+        int first = static_cast<int>(netGet32(packet + 1));
+        int count = packet[5];
+        int ack = static_cast<int>(netGet32(packet + 6));
+        int checkTick = static_cast<int>(netGet32(packet + 10));
+        unsigned int checkValue = netGet32(packet + 14);
+        if (len < 18 + count) return;
+
+        if (ack > peerAck) peerAck = ack;
+
+        // Inputs must extend the confirmed range without a gap
+        for (int k = 0; k < count; k++) {
+            int tick = first + k;
+            if (tick <= remoteConfirmed) continue;
+            if (tick != remoteConfirmed + 1) break;
+
+            signed char input = static_cast<signed char>(packet[18 + k]);
+            inputs[tick % WINDOW][remote] = input;
+            remoteConfirmed = tick;
+
+            // Ticks already simulated assumed "no turn"
+            if (tick < current && input != ERR && (rollbackFrom < 0 || tick < rollbackFrom)) {
+                rollbackFrom = tick;
+            }
+        }
+
+        if (checkTick >= 0 && pendingCheckTick < 0) {
+            pendingCheckTick = checkTick;
+            pendingCheckValue = checkValue;
+        }
+    }
+
+    void send() {
+        int first = peerAck + 1;
+        if (current - first > MAX_BATCH) first = current - MAX_BATCH;
+        int count = current - first;
+        if (count < 0) count = 0;
+
+        unsigned char packet[18 + MAX_BATCH];
+        packet[0] = NET_INPUT;
+        netPut32(packet + 1, static_cast<unsigned int>(first));
+        packet[5] = static_cast<unsigned char>(count);
+        netPut32(packet + 6, static_cast<unsigned int>(remoteConfirmed));
+        netPut32(packet + 10, static_cast<unsigned int>(checked));
+        netPut32(packet + 14, checked >= 0 ? checksums[checked % WINDOW] : 0);
+        for (int k = 0; k < count; k++) {
+            packet[18 + k] = static_cast<unsigned char>(inputs[(first + k) % WINDOW][local]);
+        }
+        link.send(packet, 18 + count);
+    }
+
+public:
+
+    NetSession(NetLink &link, int localPlayer, const NetConfig &config)
+        : link(link), config(config), local(localPlayer), remote(1 - localPlayer),
+          match(config.rows, config.cols, 2, config.level, config.seed),
+          snapshots(WINDOW, match),
+          current(0), remoteConfirmed(-1), peerAck(-1), checked(-1), rollbackFrom(-1),
+          pendingCheckTick(-1), pendingCheckValue(0),
+          rollbacks(0), maxRollback(0), desyncs(0), verified(0), maxResimMs(0), peerGone(false),
+          lastHeard(std::chrono::steady_clock::now()) {
+
+        std::memset(inputs, ERR, sizeof(inputs));
+        std::memset(checksums, 0, sizeof(checksums));
+    }
+
+    ~NetSession() {
+        unsigned char bye = NET_BYE;
+        link.send(&bye, 1);
+    }
+
+    /**
+     * @brief Reads every pending packet and repairs mispredicted ticks
+     * @return true when the match state was rewound and re-simulated
+     */
+    bool poll() {
+        unsigned char buffer[256];
+        int n;
+        while ((n = link.receive(buffer, sizeof(buffer))) > 0) {
+            lastHeard = std::chrono::steady_clock::now();
+            switch (buffer[0]) {
+                case NET_INPUT: handleInput(buffer, n); break;
+                case NET_BYE: peerGone = true; break;
+                case NET_HELLO:
+                    // Our WELCOME got lost; repeat it
+                    if (local == 0) netSendWelcome(link, config);
+                    break;
+            }
+        }
+
+        if (std::chrono::steady_clock::now() - lastHeard > std::chrono::seconds(5)) {
+            peerGone = true;
+        }
+
+        bool rewound = false;
+        if (rollbackFrom >= 0) {
+            rollback();
+            rewound = true;
+        }
+        updateChecksums();
+        return rewound;
+    }
+
+    /**
+     * @brief Simulates the next tick with the local input
+     * @return false when too far ahead of the peer; try again later
+     */
+    bool advance(int localInput) {
+        if (current - remoteConfirmed > MAX_AHEAD) {
+            send();
+            return false;
+        }
+
+        inputs[current % WINDOW][local] = static_cast<signed char>(localInput);
+        simulate(current);
+        current++;
+
+        updateChecksums();
+        send();
+        return true;
+    }
+
+    /**
+     * @brief True once the match ended on a tick both peers agree on
+     */
+    bool isOver() const {
+        return match.isOver() && remoteConfirmed >= current - 1;
+    }
+
+    const Match &getMatch() const { return match; }
+    int getLocalPlayer() const { return local; }
+    int getTick() const { return current; }
+    int getConfirmedTick() const { return remoteConfirmed; }
+    int getCheckedTick() const { return checked; }
+    int getRollbacks() const { return rollbacks; }
+    int getMaxRollback() const { return maxRollback; }
+    int getDesyncs() const { return desyncs; }
+    int getVerifiedChecksums() const { return verified; }
+    double getMaxResimMs() const { return maxResimMs; }
+    bool isPeerGone() const { return peerGone; }
+
+    /**
+     * @brief The peer went away before the match ended
+     *
+     * A peer says BYE once it is done, also after a normal game over; that
+     * is only leaving while inputs it confirmed are all played out and the
+     * match is not over.
+     */
+    bool hasPeerLeft() const {
+        return peerGone && !isOver() && remoteConfirmed < current;
+    }
+};
+
+#endif
@@ -0,0 +1,227 @@
+#ifndef PERFCOUNTERS_H_
+#define PERFCOUNTERS_H_
+
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+/**
+ * Hardware performance counters around the phases of a game tick.
+ *
+ * Cycles, instructions, cache misses and branch misses are opened as one
+ * perf_event_open group, so a single read() returns all of them counted
+ * over exactly the same interval. They count this thread in user space
+ * only, which perf_event_paranoid 2 still allows. Task clock (CPU time)
+ * is a software event and also works where the hardware counters are
+ * missing, e.g. in most virtual machines.
+ *
+ * A counter that cannot be opened is left out and reported as n/a; when
+ * none can, open() returns false with the reason and every PerfScope
+ * does nothing but test a null pointer.
+ */
+
+enum PerfCounter {
+    PERF_CYCLES,
+    PERF_INSTRUCTIONS,
+    PERF_CACHE_MISSES,
+    PERF_BRANCH_MISSES,
+    PERF_TASK_CLOCK,
+    PERF_COUNTERS
+};
+
+enum PerfPhaseId {
+    PERF_TICK,      // a whole tick, refresh included
+    PERF_REFRESH,   // the frame flush alone
+    PERF_PHASES
+};
+
+struct PerfSample {
+    unsigned long long values[PERF_COUNTERS];
+};
+
+/**
+ * @brief Sums of counter deltas over every run of one phase
+ */
+struct PerfPhase {
+    unsigned long runs;
+    unsigned long long totals[PERF_COUNTERS];
+
+    PerfPhase() : runs(0) {
+        std::memset(totals, 0, sizeof(totals));
+    }
+
+    void add(const PerfSample &start, const PerfSample &end) {
+        runs++;
+        for (int i = 0; i < PERF_COUNTERS; i++) totals[i] += end.values[i] - start.values[i];
+    }
+};
+
+class PerfCounters {
+
+    int fds[PERF_COUNTERS];
+    int order[PERF_COUNTERS];   // counter behind each value of a group read
+    int grouped;
+    int leader;
+    std::string error;
+
+    static int openEvent(unsigned int type, unsigned long long config, int group) {
+        struct perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = group == -1 ? 1 : 0;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP;
+        return static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, group, 0));
+    }
+
+public:
+
+    PerfPhase phases[PERF_PHASES];
+
+    PerfCounters() : grouped(0), leader(-1) {
+        for (int i = 0; i < PERF_COUNTERS; i++) fds[i] = -1;
+    }
+
+    ~PerfCounters() {
+        close();
+    }
+
+    /**
+     * @brief Opens every counter the host allows; false when there is none
+     */
+    bool open() {
+        static const unsigned int types[PERF_COUNTERS] = {
+            PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_SOFTWARE
+        };
+        static const unsigned long long configs[PERF_COUNTERS] = {
+            PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES,
+            PERF_COUNT_HW_BRANCH_MISSES, PERF_COUNT_SW_TASK_CLOCK
+        };
+
+        close();
+        error.clear();
+        for (int i = 0; i < PERF_COUNTERS; i++) {
+            int fd = openEvent(types[i], configs[i], leader);
+            if (fd < 0) {
+                if (error.empty()) error = std::strerror(errno);
+                continue;
+            }
+            fds[i] = fd;
+            order[grouped++] = i;
+            if (leader == -1) leader = fd;
+        }
+        if (leader == -1) return false;
+
+        ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        return true;
+    }
+
+    void close() {
+        for (int i = 0; i < PERF_COUNTERS; i++) {
+            if (fds[i] >= 0) ::close(fds[i]);
+            fds[i] = -1;
+        }
+        grouped = 0;
+        leader = -1;
+    }
+
+    bool has(int counter) const { return fds[counter] >= 0; }
+
+    /**
+     * @brief Why the first unavailable counter failed to open, if any did
+     */
+    const std::string &getError() const { return error; }
+
+    /**
+     * @brief Current value of every open counter, in one read()
+     */
+    void read(PerfSample &sample) const {
+        std::memset(sample.values, 0, sizeof(sample.values));
+        unsigned long long buffer[1 + PERF_COUNTERS];
+        if (leader == -1 || ::read(leader, buffer, sizeof(buffer)) < static_cast<ssize_t>(sizeof(unsigned long long))) return;
+        int count = static_cast<int>(buffer[0]) < grouped ? static_cast<int>(buffer[0]) : grouped;
+        for (int i = 0; i < count; i++) sample.values[order[i]] = buffer[1 + i];
+    }
+
+    /**
+     * @brief Per-phase IPC and miss rates per thousand instructions
+     */
+    void report(FILE *out) const {
+        static const char *names[PERF_PHASES] = { "tick", "refresh" };
+
+        if (leader == -1) {
+            fprintf(out, "perf counters unavailable: %s\n", error.empty() ? "not opened" : error.c_str());
+            return;
+        }
+        if (!error.empty()) fprintf(out, "some perf counters unavailable (%s), shown as n/a\n", error.c_str());
+
+        fprintf(out, "%-8s %8s %12s %12s %6s %14s %14s %10s\n",
+                "phase", "runs", "cycles", "instr", "IPC", "cache-miss/ki", "branch-miss/ki", "cpu us");
+        for (int p = 0; p < PERF_PHASES; p++) {
+            const PerfPhase &phase = phases[p];
+            if (phase.runs == 0) continue;
+
+            char cycles[32], instructions[32], ipc[32], cache[32], branch[32], cpu[32];
+            double runs = static_cast<double>(phase.runs);
+            double instr = static_cast<double>(phase.totals[PERF_INSTRUCTIONS]);
+            formatValue(cycles, has(PERF_CYCLES), "%.0f", phase.totals[PERF_CYCLES] / runs);
+            formatValue(instructions, has(PERF_INSTRUCTIONS), "%.0f", instr / runs);
+            formatValue(ipc, has(PERF_CYCLES) && has(PERF_INSTRUCTIONS) && phase.totals[PERF_CYCLES] > 0,
+                        "%.2f", instr / phase.totals[PERF_CYCLES]);
+            formatValue(cache, has(PERF_CACHE_MISSES) && has(PERF_INSTRUCTIONS) && instr > 0,
+                        "%.3f", 1000.0 * phase.totals[PERF_CACHE_MISSES] / instr);
+            formatValue(branch, has(PERF_BRANCH_MISSES) && has(PERF_INSTRUCTIONS) && instr > 0,
+                        "%.3f", 1000.0 * phase.totals[PERF_BRANCH_MISSES] / instr);
+            formatValue(cpu, has(PERF_TASK_CLOCK), "%.1f", phase.totals[PERF_TASK_CLOCK] / runs / 1000.0);
+            fprintf(out, "%-8s %8lu %12s %12s %6s %14s %14s %10s\n",
+                    names[p], phase.runs, cycles, instructions, ipc, cache, branch, cpu);
+        }
+    }
+
+private:
+
+    static void formatValue(char (&out)[32], bool available, const char *format, double value) {
+        if (available) snprintf(out, sizeof(out), format, value);
+        else snprintf(out, sizeof(out), "n/a");
+    }
+};
+
+// Set while --perf-counters is running
+static PerfCounters *g_perf_counters = nullptr;
+
+/**
+ * @brief Adds the counter deltas of the enclosing block to one phase
+ */
+class PerfScope {
+
+    PerfPhaseId phase;
+    PerfSample start;
+
+public:
+
+    explicit PerfScope(PerfPhaseId phase) : phase(phase) {
+        if (__builtin_expect(g_perf_counters != nullptr, 0)) g_perf_counters->read(start);
+    }
+
+    ~PerfScope() {
+        if (__builtin_expect(g_perf_counters != nullptr, 0)) {
+            PerfSample end;
+            g_perf_counters->read(end);
+            g_perf_counters->phases[phase].add(start, end);
+        }
+    }
+
+    PerfScope(const PerfScope &) = delete;
+    PerfScope &operator=(const PerfScope &) = delete;
+};
+
+#endif
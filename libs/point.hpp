@@ -13,6 +13,7 @@ public:
   Point() { x = 0; y = 0; }
   Point(int x, int y) { this->x = x; this->y = y; }
   Point(const Point &obj) { x = obj.getX(); y = obj.getY(); }
+  Point& operator=(const Point &obj) { x = obj.getX(); y = obj.getY(); return *this; }
   
   bool operator!=(const Point& p) { 
     return (x != p.getX() || y != p.getY()) ? true : false;
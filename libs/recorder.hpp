@@ -0,0 +1,268 @@
+#ifndef RECORDER_H_
+#define RECORDER_H_
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include "terminal.hpp"
+
+/**
+ * @brief Appends one asciicast v2 event line: [time, "o", "data"]
+ */
+inline void appendCastEvent(std::string &out, double seconds, const char *type, const char *bytes, size_t length) {
+    char number[32];
+    snprintf(number, sizeof(number), "[%.6f, \"%s\", \"", seconds, type);
+    out += number;
+
+    for (size_t i = 0; i < length; i++) {
+        unsigned char c = static_cast<unsigned char>(bytes[i]);
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += static_cast<char>(c);
+        } else if (c < 0x20 || c == 0x7F) {
+            char escaped[8];
+            snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            out += escaped;
+        } else {
+            out += static_cast<char>(c);
+        }
+    }
+    out += "\"]\n";
+}
+
+/**
+ * @brief Appends the asciicast v2 header line
+ */
+inline void appendCastHeader(std::string &out, int width, int height, long timestamp) {
+    char header[160];
+    snprintf(header, sizeof(header),
+             "{\"version\": 2, \"width\": %d, \"height\": %d, \"timestamp\": %ld, "
+             "\"env\": {\"TERM\": \"xterm-256color\"}}\n", width, height, timestamp);
+    out += header;
+}
+
+/**
+ * Streams everything refresh() sends to the terminal into an asciicast v2
+ * file (`asciinema play file.cast`).
+ *
+ * The game thread only copies each frame and its timestamp into a
+ * fixed-size single-producer/single-consumer byte ring; a background thread
+ * turns the records into JSON lines and writes them, so a slow disk can
+ * never stall a tick. When the ring is full the frame is dropped and the
+ * next frame that fits is replaced by a keyframe, keeping the recording
+ * consistent.
+ *
+ * Lines are only ever written whole and the file is synced every
+ * FLUSH_MS, so after a crash the file is still a valid recording up to the
+ * last sync. A clean stop() appends a trailer that restores the viewer's
+ * terminal.
+ */
+class Recorder {
+
+    enum { FLUSH_MS = 1000, POLL_MS = 10 };
+
+    struct Record {
+        double seconds;
+        unsigned int length;
+    };
+
+    std::vector<char> ring;
+    size_t mask;
+    std::atomic<size_t> head;  // written by the game thread
+    std::atomic<size_t> tail;  // written by the writer thread
+
+    int fd;
+    std::chrono::steady_clock::time_point start;
+    std::atomic<bool> running;
+    std::thread writer;
+    bool resync;
+
+    std::atomic<unsigned long> frames;
+    std::atomic<unsigned long> drops;
+    std::atomic<unsigned long> bytesIn;
+
+    void copyIn(size_t at, const void *data, size_t length) {
+        size_t offset = at & mask;
+        size_t first = length < ring.size() - offset ? length : ring.size() - offset;
+        std::memcpy(&ring[offset], data, first);
+        std::memcpy(&ring[0], static_cast<const char *>(data) + first, length - first);
+    }
+
+    void copyOut(size_t at, void *data, size_t length) const {
+        size_t offset = at & mask;
+        size_t first = length < ring.size() - offset ? length : ring.size() - offset;
+        std::memcpy(data, &ring[offset], first);
+        std::memcpy(static_cast<char *>(data) + first, &ring[0], length - first);
+    }
+
+    bool push(const char *bytes, size_t length) {
+        size_t needed = sizeof(Record) + length;
+        size_t at = head.load(std::memory_order_relaxed);
+        if (needed > ring.size() - (at - tail.load(std::memory_order_acquire))) return false;
+
+        Record record;
+        record.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        record.length = static_cast<unsigned int>(length);
+        copyIn(at, &record, sizeof(record));
+        copyIn(at + sizeof(record), bytes, length);
+        head.store(at + needed, std::memory_order_release);
+        return true;
+    }
+
+    bool writeAll(const std::string &lines) {
+        size_t done = 0;
+        while (done < lines.size()) {
+            ssize_t n = ::write(fd, lines.data() + done, lines.size() - done);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            done += static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    // Converts every complete record in the ring into event lines
+    void drain(std::string &lines, std::vector<char> &payload) {
+        size_t at = tail.load(std::memory_order_relaxed);
+        size_t end = head.load(std::memory_order_acquire);
+        while (at < end) {
+            Record record;
+            copyOut(at, &record, sizeof(record));
+            payload.resize(record.length);
+            if (record.length > 0) copyOut(at + sizeof(record), &payload[0], record.length);
+            appendCastEvent(lines, record.seconds, "o", payload.data(), record.length);
+            at += sizeof(record) + record.length;
+        }
+        tail.store(at, std::memory_order_release);
+    }
+
+    void run() {
+        std::string lines;
+        std::vector<char> payload;
+        std::chrono::steady_clock::time_point lastSync = std::chrono::steady_clock::now();
+
+        while (running.load(std::memory_order_relaxed)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(POLL_MS));
+
+            lines.clear();
+            drain(lines, payload);
+            if (!lines.empty()) writeAll(lines);
+
+            if (std::chrono::steady_clock::now() - lastSync >= std::chrono::milliseconds(FLUSH_MS)) {
+                fdatasync(fd);
+                lastSync = std::chrono::steady_clock::now();
+            }
+        }
+
+        lines.clear();
+        drain(lines, payload);
+        writeAll(lines);
+    }
+
+    static void onFrame(const char *bytes, size_t length, const int * /* cells */, int count, void *context) {
+        if (count > 0) static_cast<Recorder *>(context)->frame(bytes, length);
+    }
+
+    Recorder(const Recorder &);
+    Recorder &operator=(const Recorder &);
+
+public:
+
+    /**
+     * @param capacity ring size in bytes, rounded up to a power of two
+     */
+    Recorder(size_t capacity = 4 << 20)
+        : head(0), tail(0), fd(-1), running(false), resync(false),
+          frames(0), drops(0), bytesIn(0) {
+        size_t size = 1024;
+        while (size < capacity) size <<= 1;
+        ring.resize(size);
+        mask = size - 1;
+    }
+
+    ~Recorder() {
+        stop();
+    }
+
+    /**
+     * @brief Creates the cast file, writes its header and starts the writer
+     */
+    bool open(const char *path, int width, int height) {
+        fd = ::open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0) return false;
+
+        std::string header;
+        appendCastHeader(header, width, height, static_cast<long>(std::time(nullptr)));
+        if (!writeAll(header)) return false;
+
+        start = std::chrono::steady_clock::now();
+        running = true;
+        writer = std::thread(&Recorder::run, this);
+        return true;
+    }
+
+    /**
+     * @brief Records every refresh() of this process
+     */
+    bool attach() {
+        return add_frame_listener(onFrame, this);
+    }
+
+    /**
+     * @brief Queues one frame; never blocks, drops the frame if the ring is full
+     */
+    void frame(const char *bytes, size_t length) {
+        size_t pushed = length;
+        if (resync) {
+            // Frames were lost: continue from a full picture of the screen
+            std::string full;
+            encode_keyframe(full);
+            if (!push(full.data(), full.size())) {
+                drops.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            resync = false;
+            pushed = full.size();
+        } else if (!push(bytes, length)) {
+            drops.fetch_add(1, std::memory_order_relaxed);
+            resync = true;
+            return;
+        }
+        frames.fetch_add(1, std::memory_order_relaxed);
+        bytesIn.fetch_add(pushed, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Writes what is left plus the trailer and closes the file
+     */
+    void stop() {
+        remove_frame_listener(onFrame, this);
+        if (running.exchange(false)) {
+            writer.join();
+
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            std::string trailer;
+            const char reset[] = ANSI_RESET ANSI_CURSOR_SHOW;
+            appendCastEvent(trailer, seconds, "o", reset, sizeof(reset) - 1);
+            writeAll(trailer);
+            fdatasync(fd);
+        }
+        if (fd >= 0) ::close(fd);
+        fd = -1;
+    }
+
+    unsigned long getFrames() const { return frames.load(std::memory_order_relaxed); }
+    unsigned long getDrops() const { return drops.load(std::memory_order_relaxed); }
+    unsigned long getBytes() const { return bytesIn.load(std::memory_order_relaxed); }
+};
+
+#endif
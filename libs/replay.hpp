@@ -0,0 +1,171 @@
+#ifndef REPLAY_H_
+#define REPLAY_H_
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "match.hpp"
+#include "wire.hpp"
+
+#define REPLAY_MAGIC "TSRP"
+#define REPLAY_VERSION 1
+
+// Header: magic, u8 version, u16 rows, u16 cols, u8 players, u8 level, u32 seed, u32 ticks, u32 inputs
+#define REPLAY_HEADER 23
+#define REPLAY_INPUT 6
+
+// Largest setup a game can record: the menu seats up to 4 players on a terminal-sized board
+#define REPLAY_MAX_PLAYERS 4
+#define REPLAY_MAX_ROWS 1024
+#define REPLAY_MAX_COLS 1024
+
+struct ReplayInput {
+    unsigned int tick;
+    unsigned char player;
+    unsigned char direction;
+};
+
+/**
+ * A Match game stored as its setup and the turns players made.
+ *
+ * Matches are deterministic, so a seed plus every setDirection() call and
+ * the tick it happened before is enough to rebuild every frame: a whole
+ * game is a few hundred bytes.
+ */
+class Replay {
+
+    int rows;
+    int cols;
+    int players;
+    int level;
+    unsigned int seed;
+    unsigned int ticks;
+    std::vector<ReplayInput> inputs;
+
+public:
+
+    Replay() : rows(0), cols(0), players(0), level(0), seed(0), ticks(0) {}
+
+    Replay(int rows, int cols, int players, int level, unsigned int seed)
+        : rows(rows), cols(cols), players(players), level(level), seed(seed), ticks(0) {}
+
+    /**
+     * @brief Notes a turn queued before step number `tick`
+     */
+    void record(unsigned long tick, int player, int direction) {
+        ReplayInput input;
+        input.tick = static_cast<unsigned int>(tick);
+        input.player = static_cast<unsigned char>(player);
+        input.direction = static_cast<unsigned char>(direction);
+        inputs.push_back(input);
+    }
+
+    void finish(unsigned long tickCount) { ticks = static_cast<unsigned int>(tickCount); }
+
+    bool save(const char *path) const {
+        std::vector<unsigned char> data(REPLAY_HEADER + inputs.size() * REPLAY_INPUT);
+        std::memcpy(&data[0], REPLAY_MAGIC, 4);
+        data[4] = REPLAY_VERSION;
+        netPut16(&data[5], rows);
+        netPut16(&data[7], cols);
+        data[9] = static_cast<unsigned char>(players);
+        data[10] = static_cast<unsigned char>(level);
+        netPut32(&data[11], seed);
+        netPut32(&data[15], ticks);
+        netPut32(&data[19], static_cast<unsigned int>(inputs.size()));
+        for (size_t i = 0; i < inputs.size(); i++) {
+            unsigned char *p = &data[REPLAY_HEADER + i * REPLAY_INPUT];
+            netPut32(p, inputs[i].tick);
+            p[4] = inputs[i].player;
+            p[5] = inputs[i].direction;
+        }
+
+        FILE *file = fopen(path, "wb");
+        if (file == nullptr) return false;
+        bool ok = fwrite(&data[0], 1, data.size(), file) == data.size();
+        return fclose(file) == 0 && ok;
+    }
+
+    bool load(const char *path) {
+        FILE *file = fopen(path, "rb");
+        if (file == nullptr) return false;
+
+        unsigned char header[REPLAY_HEADER];
+        bool ok = fread(header, 1, REPLAY_HEADER, file) == REPLAY_HEADER &&
+                  std::memcmp(header, REPLAY_MAGIC, 4) == 0 && header[4] == REPLAY_VERSION;
+        if (ok) {
+            rows = netGet16(&header[5]);
+            cols = netGet16(&header[7]);
+            players = header[9];
+            level = header[10];
+            seed = netGet32(&header[11]);
+            ticks = netGet32(&header[15]);
+
+            // The count comes from the file: it has to fit in what is left of it
+            size_t count = netGet32(&header[19]);
+            long start = ftell(file);
+            ok = start >= 0 && fseek(file, 0, SEEK_END) == 0;
+            long end = ok ? ftell(file) : -1;
+            ok = ok && end >= start && count <= static_cast<size_t>(end - start) / REPLAY_INPUT &&
+                 fseek(file, start, SEEK_SET) == 0;
+
+            std::vector<unsigned char> data(ok ? count * REPLAY_INPUT : 0);
+            ok = ok && (data.empty() || fread(&data[0], 1, data.size(), file) == data.size());
+            inputs.clear();
+            for (size_t at = 0; ok && at < data.size(); at += REPLAY_INPUT) {
+                ReplayInput input;
+                input.tick = netGet32(&data[at]);
+                input.player = data[at + 4];
+                input.direction = data[at + 5];
+                ok = input.player < players;
+                inputs.push_back(input);
+            }
+            ok = ok && rows >= 4 && rows <= REPLAY_MAX_ROWS && cols >= 8 && cols <= REPLAY_MAX_COLS &&
+                 players >= 1 && players <= REPLAY_MAX_PLAYERS;
+        }
+        fclose(file);
+        return ok;
+    }
+
+    int getRows() const { return rows; }
+    int getCols() const { return cols; }
+    int getPlayers() const { return players; }
+    int getLevel() const { return level; }
+    unsigned int getSeed() const { return seed; }
+    unsigned int getTicks() const { return ticks; }
+    const std::vector<ReplayInput> &getInputs() const { return inputs; }
+};
+
+/**
+ * Steps a Match through a Replay one tick at a time
+ */
+class ReplayPlayer {
+
+    const Replay &replay;
+    Match match;
+    size_t next;
+
+public:
+
+    ReplayPlayer(const Replay &replay)
+        : replay(replay),
+          match(replay.getRows(), replay.getCols(), replay.getPlayers(), replay.getLevel(), replay.getSeed()),
+          next(0) {}
+
+    bool isDone() const { return match.getTick() >= replay.getTicks() || match.isOver(); }
+
+    void step() {
+        const std::vector<ReplayInput> &inputs = replay.getInputs();
+        while (next < inputs.size() && inputs[next].tick <= match.getTick()) {
+            if (inputs[next].player < match.getPlayers()) {
+                match.setDirection(inputs[next].player, inputs[next].direction);
+            }
+            next++;
+        }
+        match.step();
+    }
+
+    const Match &getMatch() const { return match; }
+};
+
+#endif
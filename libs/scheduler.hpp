@@ -0,0 +1,180 @@
+#ifndef SCHEDULER_H_
+#define SCHEDULER_H_
+
+#include <time.h>
+#include <cerrno>
+#include "common.hpp"
+
+/**
+ * Fires game ticks at absolute deadlines.
+ *
+ * Deadline n is start + n * period, so neither a slow tick nor a late
+ * wake-up pushes later ticks back: there is no drift to build up, unlike
+ * restarting a timer after each tick. wait() sleeps with
+ * clock_nanosleep(TIMER_ABSTIME) on CLOCK_MONOTONIC and can spin for the
+ * last few microseconds, trading CPU for less wake-up jitter.
+ *
+ * When poll() finds that more than one deadline has passed (a long frame,
+ * a stopped process), the extra ones are counted as missed and either run
+ * back to back to catch up, up to MAX_CATCH_UP of them, or are dropped
+ * and the schedule skips ahead to the next deadline on the same grid.
+ *
+ * The rate can change at any time, from MIN_HZ to MAX_HZ; it applies from
+ * the next deadline on.
+ *
+ * Deadlines are read from now() unless another TickClock is given, so
+ * tests can step time by hand; wait() only sleeps on the real clock.
+ */
+
+enum TickPolicy {
+    TICK_CATCH_UP,  // run missed ticks back to back
+    TICK_DROP       // skip missed ticks, keep the phase
+};
+
+/**
+ * @brief Scheduling settings a game is started with
+ */
+struct TickConfig {
+    double rate;        // Hz; 0 picks the rate of the difficulty level
+    double speedup;     // percent faster after each food eaten
+    long long spinNs;   // busy-wait this long before each deadline
+    TickPolicy policy;
+
+    TickConfig() : rate(0), speedup(0), spinNs(0), policy(TICK_CATCH_UP) {}
+};
+
+/**
+ * @brief Tick rate of a difficulty level: 1 (Easy) runs every DELAY ms, each level above is 20% faster
+ */
+inline double tick_rate_for_level(int level) {
+    return 1000.0 / DELAY * (1 + (level - 1) / 5.0);
+}
+
+// Monotonic nanoseconds
+typedef long long (*TickClock)();
+
+class TickScheduler {
+
+    TickClock clock;
+    long long period;
+    long long next;         // deadline of the next tick, monotonic ns
+    long long spinNs;
+    TickPolicy policy;
+    unsigned long long ticks;
+    unsigned long long missed;
+    unsigned long long dropped;
+    int behind;             // deadlines still owed by a catch-up
+
+public:
+
+    enum { MIN_HZ = 5, MAX_HZ = 1000, MAX_CATCH_UP = 5 };
+
+    /**
+     * @brief Monotonic time in nanoseconds, the clock deadlines are kept in
+     */
+    static long long now() {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+    }
+
+    explicit TickScheduler(double hz = 1000.0 / DELAY, TickClock clock = &TickScheduler::now)
+        : clock(clock), period(0), next(0), spinNs(0), policy(TICK_CATCH_UP), ticks(0), missed(0), dropped(0), behind(0) {
+        setRate(hz);
+        restart();
+    }
+
+    /**
+     * @brief Ticks per second, clamped to MIN_HZ..MAX_HZ
+     */
+    void setRate(double hz) {
+        if (hz < MIN_HZ) hz = MIN_HZ;
+        if (hz > MAX_HZ) hz = MAX_HZ;
+        long long previous = period;
+        period = static_cast<long long>(1e9 / hz + 0.5);
+        // The pending deadline moves with the new period
+        if (previous != 0) next += period - previous;
+    }
+
+    double getRate() const { return 1e9 / period; }
+    long long getPeriod() const { return period; }
+
+    void setSpin(long long ns) { spinNs = ns > 0 ? ns : 0; }
+    void setPolicy(TickPolicy p) { policy = p; }
+
+    void configure(const TickConfig &config) {
+        setSpin(config.spinNs);
+        setPolicy(config.policy);
+    }
+
+    /**
+     * @brief First deadline one period from now; counters are kept
+     */
+    void restart() {
+        next = clock() + period;
+        behind = 0;
+    }
+
+    long long getDeadline() const { return next; }
+    unsigned long long getTicks() const { return ticks; }
+    // Deadlines that passed before their tick could start
+    unsigned long long getMissed() const { return missed; }
+    // Missed deadlines that were skipped rather than run late
+    unsigned long long getDropped() const { return dropped; }
+
+    /**
+     * @brief True when a tick is due, with how late it is (ns) in `lateness`
+     */
+    bool poll(long long &lateness) {
+        long long t = clock();
+        if (t < next) return false;
+
+        long long deadline = next;
+        lateness = t - deadline;
+        ticks++;
+        next = deadline + period;
+
+        if (behind > 0) {
+            // A tick owed by an earlier catch-up, already counted as missed
+            behind--;
+        } else if (t >= next) {
+            long long passed = (t - next) / period + 1;
+            missed += passed;
+            if (policy == TICK_DROP || passed > MAX_CATCH_UP) {
+                next += passed * period;
+                dropped += passed;
+            } else {
+                behind = static_cast<int>(passed);
+            }
+        }
+        return true;
+    }
+
+    bool poll() {
+        long long lateness;
+        return poll(lateness);
+    }
+
+    /**
+     * @brief Sleeps until the next deadline; returns early on a signal
+     *
+     * Returns at once with another clock: whoever owns it moves time on.
+     */
+    void wait() const {
+        if (clock != &TickScheduler::now) return;
+        long long wake = next - spinNs;
+        if (wake > now()) {
+            struct timespec ts;
+            ts.tv_sec = wake / 1000000000LL;
+            ts.tv_nsec = wake % 1000000000LL;
+            if (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) return;
+        }
+        while (now() < next) {
+#if defined(__x86_64__) || defined(__i386__)
+            __builtin_ia32_pause();
+#endif
+        }
+    }
+};
+
+#endif
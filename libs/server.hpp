@@ -0,0 +1,486 @@
+#ifndef SERVER_H_
+#define SERVER_H_
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <cerrno>
+#include <cstring>
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include "common.hpp"
+#include "match.hpp"
+#include "wire.hpp"
+
+struct ServerConfig {
+    int port;
+    int shards;
+    int matchesPerShard;
+    int clientsPerShard;
+    int seats;
+    int rows;
+    int cols;
+    int level;
+    int tickMs;
+
+    ServerConfig()
+        : port(7878), shards(1), matchesPerShard(8192), clientsPerShard(16384),
+          seats(2), rows(24), cols(80), level(2), tickMs(DELAY) {}
+};
+
+/**
+ * Counters a shard publishes to the reporting thread (relaxed atomics,
+ * written by the owning shard only)
+ */
+struct ShardStats {
+    std::atomic<unsigned long> ticks;
+    std::atomic<unsigned long> missedTicks;
+    std::atomic<unsigned long> lateTicks;
+    std::atomic<unsigned long> maxTickUs;
+    std::atomic<unsigned long> bytesOut;
+    std::atomic<int> clients;
+    std::atomic<int> matches;
+    std::atomic<unsigned long> dropped;
+
+    ShardStats() : ticks(0), missedTicks(0), lateTicks(0), maxTickUs(0), bytesOut(0),
+                   clients(0), matches(0), dropped(0) {}
+};
+
+inline void frameHeader(unsigned char *p, int payload, int type) {
+    p[0] = (payload + 1) >> 8;
+    p[1] = payload + 1;
+    p[2] = static_cast<unsigned char>(type);
+}
+
+/**
+ * @brief Bytes of the largest KEYFRAME a rows x cols board can produce: every interior cell taken
+ */
+inline long long keyframeBound(int rows, int cols) {
+    return FRAME_HEADER + 6 + static_cast<long long>(rows - 2) * (cols - 2) * CELL_ENTRY;
+}
+
+/**
+ * @brief Whether every frame of a rows x cols board fits the u16 length field
+ */
+inline bool boardFitsFrames(int rows, int cols) {
+    return keyframeBound(rows, cols) - 2 <= FRAME_MAX_LENGTH;
+}
+
+inline unsigned char cellKind(unsigned short owner) {
+    if (owner == Grid::FOOD) return CELL_FOOD;
+    if (Grid::isSnake(owner)) return static_cast<unsigned char>(CELL_SNAKE + owner - 1);
+    return CELL_EMPTY;
+}
+
+/**
+ * One independent server shard.
+ *
+ * A shard owns an epoll instance, its own SO_REUSEPORT listening socket,
+ * a timerfd for the tick and fixed pools of match and client slots that
+ * are allocated once at startup. The kernel spreads new connections over
+ * the shards' listening sockets, a connection never leaves the shard that
+ * accepted it and the matches it joins live in that same shard, so shards
+ * share no state and take no locks.
+ *
+ * Each tick the dirty cells of a match are encoded once into a DELTA frame
+ * and copied into the output buffer of every seated client. A client that
+ * cannot keep up (its buffer is full) is disconnected. Output buffers hold
+ * a welcome, the largest keyframe of the board and OUT_SLACK bytes of
+ * deltas; a client slot gets its buffer the first time it is used and
+ * keeps it.
+ */
+class Shard {
+
+    enum { OUT_SLACK = 2048, WELCOME_SIZE = FRAME_HEADER + 9, TAG_LISTEN = -1, TAG_TIMER = -2 };
+
+    struct Client {
+        int fd;
+        int match;
+        int seat;
+        int outStart;
+        int outEnd;
+        bool wantWrite;
+        std::vector<unsigned char> out;
+    };
+
+    struct MatchSlot {
+        Match match;
+        std::vector<int> seats;  // client index per seat, -1 when free
+        int occupied;
+
+        MatchSlot(const ServerConfig &config)
+            : match(config.rows, config.cols, config.seats, config.level, 0),
+              seats(config.seats, -1), occupied(0) {}
+    };
+
+    ServerConfig config;
+    int id;
+    int epfd;
+    int listenFd;
+    int timerFd;
+
+    std::vector<MatchSlot> matches;
+    std::vector<Client> clients;
+    std::vector<int> freeClients;
+    std::vector<unsigned char> frame;
+    int outCapacity;
+    unsigned int seedCounter;
+    size_t fillCursor;  // no match before this one has a free seat
+
+    std::chrono::steady_clock::time_point nextDeadline;
+
+    void watch(int fd, int tag, unsigned int events) {
+        epoll_event ev;
+        std::memset(&ev, 0, sizeof(ev));
+        ev.events = events;
+        ev.data.u64 = static_cast<unsigned long long>(static_cast<long long>(tag));
+        epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev);
+    }
+
+    void rewatch(int client, unsigned int events) {
+        epoll_event ev;
+        std::memset(&ev, 0, sizeof(ev));
+        ev.events = events;
+        ev.data.u64 = static_cast<unsigned long long>(client);
+        epoll_ctl(epfd, EPOLL_CTL_MOD, clients[client].fd, &ev);
+    }
+
+    bool enqueue(int client, const unsigned char *data, int len) {
+        Client &c = clients[client];
+        if (c.outEnd + len > outCapacity) {
+            // Compact before giving up
+            std::memmove(&c.out[0], &c.out[c.outStart], c.outEnd - c.outStart);
+            c.outEnd -= c.outStart;
+            c.outStart = 0;
+            if (c.outEnd + len > outCapacity) return false;
+        }
+        std::memcpy(&c.out[c.outEnd], data, len);
+        c.outEnd += len;
+        return true;
+    }
+
+    bool flush(int client) {
+        Client &c = clients[client];
+        while (c.outStart < c.outEnd) {
+            ssize_t n = ::send(c.fd, &c.out[c.outStart], c.outEnd - c.outStart, MSG_NOSIGNAL);
+            if (n < 0) {
+                if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+                return false;
+            }
+            c.outStart += static_cast<int>(n);
+            stats.bytesOut.fetch_add(n, std::memory_order_relaxed);
+        }
+        if (c.outStart == c.outEnd) c.outStart = c.outEnd = 0;
+
+        bool pending = c.outStart < c.outEnd;
+        if (pending != c.wantWrite) {
+            c.wantWrite = pending;
+            rewatch(client, pending ? EPOLLIN | EPOLLOUT : static_cast<unsigned int>(EPOLLIN));
+        }
+        return true;
+    }
+
+    void disconnect(int client) {
+        Client &c = clients[client];
+        if (c.fd < 0) return;
+
+        MatchSlot &slot = matches[c.match];
+        slot.seats[c.seat] = -1;
+        if (--slot.occupied == 0) stats.matches.fetch_sub(1, std::memory_order_relaxed);
+        if (static_cast<size_t>(c.match) < fillCursor) fillCursor = c.match;
+
+        release(client);
+    }
+
+    void release(int client) {
+        Client &c = clients[client];
+        epoll_ctl(epfd, EPOLL_CTL_DEL, c.fd, nullptr);
+        close(c.fd);
+        c.fd = -1;
+        freeClients.push_back(client);
+        stats.clients.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    // Every non-empty, non-wall cell; clients know the board is walled
+    int encodeKeyframe(const Match &match) {
+        const Grid &grid = match.getGrid();
+        int count = 0;
+        frame.resize(FRAME_HEADER + 6);
+        for (int i = 1; i < grid.getRows() - 1; i++) {
+            for (int j = 1; j < grid.getCols() - 1; j++) {
+                unsigned short owner = grid.get(Point(i, j));
+                if (owner == Grid::EMPTY) continue;
+                appendCell(i, j, cellKind(owner));
+                count++;
+            }
+        }
+        finishFrame(FRAME_KEYFRAME, match.getTick(), count);
+        return static_cast<int>(frame.size());
+    }
+
+    int encodeDelta(const Match &match) {
+        const std::vector<Point> &dirty = match.getDirty();
+        frame.resize(FRAME_HEADER + 6);
+        for (size_t i = 0; i < dirty.size(); i++) {
+            appendCell(dirty[i].getX(), dirty[i].getY(), cellKind(match.getGrid().get(dirty[i])));
+        }
+        finishFrame(FRAME_DELTA, match.getTick(), static_cast<int>(dirty.size()));
+        return static_cast<int>(frame.size());
+    }
+
+    void appendCell(int row, int col, unsigned char kind) {
+        size_t at = frame.size();
+        frame.resize(at + CELL_ENTRY);
+        netPut16(&frame[at], row);
+        netPut16(&frame[at + 2], col);
+        frame[at + 4] = kind;
+    }
+
+    // Payload: u32 tick, u16 cell count, cells
+    void finishFrame(int type, unsigned long tick, int count) {
+        frameHeader(&frame[0], static_cast<int>(frame.size()) - FRAME_HEADER, type);
+        netPut32(&frame[FRAME_HEADER], static_cast<unsigned int>(tick));
+        netPut16(&frame[FRAME_HEADER + 4], count);
+    }
+
+    void broadcast(int matchIndex, int len) {
+        MatchSlot &slot = matches[matchIndex];
+        for (size_t s = 0; s < slot.seats.size(); s++) {
+            int client = slot.seats[s];
+            if (client < 0) continue;
+            if (!enqueue(client, &frame[0], len)) {
+                stats.dropped.fetch_add(1, std::memory_order_relaxed);
+                disconnect(client);
+            } else if (!clients[client].wantWrite && !flush(client)) {
+                disconnect(client);
+            }
+        }
+    }
+
+    void seat(int client) {
+        // Fill the first match with a free seat; empty matches are restarted
+        for (size_t m = fillCursor; m < matches.size(); m++) {
+            MatchSlot &slot = matches[m];
+            if (slot.occupied >= config.seats) {
+                if (m == fillCursor) fillCursor++;
+                continue;
+            }
+
+            if (slot.occupied == 0) {
+                slot.match.reset(seedCounter++);
+                stats.matches.fetch_add(1, std::memory_order_relaxed);
+            }
+            for (int s = 0; s < config.seats; s++) {
+                if (slot.seats[s] >= 0) continue;
+                slot.seats[s] = client;
+                slot.occupied++;
+                clients[client].match = static_cast<int>(m);
+                clients[client].seat = s;
+
+                unsigned char welcome[WELCOME_SIZE];
+                frameHeader(welcome, 9, FRAME_WELCOME);
+                welcome[FRAME_HEADER] = static_cast<unsigned char>(s);
+                netPut16(welcome + FRAME_HEADER + 1, config.rows);
+                netPut16(welcome + FRAME_HEADER + 3, config.cols);
+                netPut32(welcome + FRAME_HEADER + 5, static_cast<unsigned int>(id * matches.size() + m));
+                int len = encodeKeyframe(slot.match);
+                if (!enqueue(client, welcome, sizeof(welcome)) || !enqueue(client, &frame[0], len)) {
+                    stats.dropped.fetch_add(1, std::memory_order_relaxed);
+                    disconnect(client);
+                } else if (!flush(client)) {
+                    disconnect(client);
+                }
+                return;
+            }
+        }
+        // Every match is full
+        release(client);
+    }
+
+    void acceptAll() {
+        for (;;) {
+            int fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK);
+            if (fd < 0) return;
+
+            if (freeClients.empty()) {
+                close(fd);
+                continue;
+            }
+            int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+            int client = freeClients.back();
+            freeClients.pop_back();
+            Client &c = clients[client];
+            c.fd = fd;
+            if (c.out.empty()) c.out.resize(outCapacity);
+            c.outStart = c.outEnd = 0;
+            c.wantWrite = false;
+            stats.clients.fetch_add(1, std::memory_order_relaxed);
+
+            watch(fd, client, EPOLLIN);
+            seat(client);
+        }
+    }
+
+    // Clients send one byte per turn (UP/DOWN/LEFT/RIGHT)
+    void readInput(int client) {
+        unsigned char buffer[64];
+        for (;;) {
+            ssize_t n = recv(clients[client].fd, buffer, sizeof(buffer), 0);
+            if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+                disconnect(client);
+                return;
+            }
+            if (n < 0) return;
+
+            Client &c = clients[client];
+            for (ssize_t k = 0; k < n; k++) {
+                matches[c.match].match.setDirection(c.seat, buffer[k]);
+            }
+        }
+    }
+
+    void tick() {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+        for (size_t m = 0; m < matches.size(); m++) {
+            MatchSlot &slot = matches[m];
+            if (slot.occupied == 0) continue;
+
+            slot.match.step();
+            int len = slot.match.isOver() ? (slot.match.reset(seedCounter++), encodeKeyframe(slot.match))
+                                          : encodeDelta(slot.match);
+            broadcast(static_cast<int>(m), len);
+        }
+
+        std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+        unsigned long us = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+        if (us > stats.maxTickUs.load(std::memory_order_relaxed)) {
+            stats.maxTickUs.store(us, std::memory_order_relaxed);
+        }
+        if (end > nextDeadline) {
+            stats.lateTicks.fetch_add(1, std::memory_order_relaxed);
+        }
+        stats.ticks.fetch_add(1, std::memory_order_relaxed);
+    }
+
+public:
+
+    ShardStats stats;
+
+    Shard(const ServerConfig &config, int id)
+        : config(config), id(id), epfd(-1), listenFd(-1), timerFd(-1),
+          clients(config.clientsPerShard),
+          outCapacity(static_cast<int>(WELCOME_SIZE + keyframeBound(config.rows, config.cols) + OUT_SLACK)),
+          seedCounter(static_cast<unsigned int>(id) * 7919u), fillCursor(0) {
+
+        matches.reserve(config.matchesPerShard);
+        for (int m = 0; m < config.matchesPerShard; m++) {
+            matches.push_back(MatchSlot(config));
+        }
+        for (int c = config.clientsPerShard - 1; c >= 0; c--) {
+            clients[c].fd = -1;
+            freeClients.push_back(c);
+        }
+        frame.reserve(keyframeBound(config.rows, config.cols));
+    }
+
+    ~Shard() {
+        for (size_t c = 0; c < clients.size(); c++) {
+            if (clients[c].fd >= 0) close(clients[c].fd);
+        }
+        if (timerFd >= 0) close(timerFd);
+        if (listenFd >= 0) close(listenFd);
+        if (epfd >= 0) close(epfd);
+    }
+
+    bool open() {
+        epfd = epoll_create1(0);
+        listenFd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+        timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+        if (epfd < 0 || listenFd < 0 || timerFd < 0) return false;
+
+        int one = 1;
+        setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        setsockopt(listenFd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one));
+
+        sockaddr_in addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_ANY);
+        addr.sin_port = htons(static_cast<unsigned short>(config.port));
+        if (bind(listenFd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0) return false;
+        if (::listen(listenFd, 4096) != 0) return false;
+
+        itimerspec period;
+        std::memset(&period, 0, sizeof(period));
+        period.it_interval.tv_sec = config.tickMs / 1000;
+        period.it_interval.tv_nsec = (config.tickMs % 1000) * 1000000L;
+        period.it_value = period.it_interval;
+        timerfd_settime(timerFd, 0, &period, nullptr);
+
+        watch(listenFd, TAG_LISTEN, EPOLLIN);
+        watch(timerFd, TAG_TIMER, EPOLLIN);
+        return true;
+    }
+
+    /**
+     * @brief Event loop; returns when `running` turns false
+     */
+    void run(const std::atomic<bool> &running) {
+        epoll_event events[256];
+        while (running.load(std::memory_order_relaxed)) {
+            int n = epoll_wait(epfd, events, 256, 100);
+            for (int i = 0; i < n; i++) {
+                long long tag = static_cast<long long>(events[i].data.u64);
+
+                if (tag == TAG_LISTEN) {
+                    acceptAll();
+                } else if (tag == TAG_TIMER) {
+                    unsigned long long expirations = 0;
+                    if (read(timerFd, &expirations, sizeof(expirations)) != sizeof(expirations)) continue;
+
+                    // More than one expiration means whole ticks were skipped
+                    if (expirations > 1) {
+                        stats.missedTicks.fetch_add(expirations - 1, std::memory_order_relaxed);
+                    }
+                    // The tick has to be done before the timer fires again
+                    nextDeadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(config.tickMs);
+                    tick();
+                } else {
+                    int client = static_cast<int>(tag);
+                    if (clients[client].fd < 0) continue;
+                    if (events[i].events & (EPOLLHUP | EPOLLERR)) {
+                        disconnect(client);
+                        continue;
+                    }
+                    if (events[i].events & EPOLLIN) readInput(client);
+                    if (clients[client].fd >= 0 && (events[i].events & EPOLLOUT) && !flush(client)) {
+                        disconnect(client);
+                    }
+                }
+            }
+        }
+    }
+
+    int getId() const { return id; }
+
+    /**
+     * @brief Port the shard listens on; the one picked by the kernel when configured as 0
+     */
+    int getPort() const {
+        sockaddr_in addr;
+        socklen_t size = sizeof(addr);
+        if (getsockname(listenFd, reinterpret_cast<sockaddr *>(&addr), &size) != 0) return -1;
+        return ntohs(addr.sin_port);
+    }
+};
+
+#endif
@@ -0,0 +1,114 @@
+#ifndef SPATIAL_H_
+#define SPATIAL_H_
+
+#include <vector>
+#include <cstdlib>
+#include "point.hpp"
+
+/**
+ * Bucketed spatial index over food cells.
+ *
+ * The board is cut into square buckets of BUCKET cells; each bucket keeps
+ * the food points that fall inside it. A nearest query walks rings of
+ * buckets outwards from the query point and stops as soon as no unvisited
+ * ring can hold anything closer than the best hit, so it touches a few
+ * buckets instead of every food on the board.
+ */
+class FoodIndex {
+
+    static const int BUCKET = 16;
+
+    int bucketRows;
+    int bucketCols;
+    std::vector< std::vector<Point> > buckets;
+    int count;
+
+    int bucketOf(int row, int col) const { return row * bucketCols + col; }
+
+    static int distance(const Point &a, const Point &b) {
+        return std::abs(a.getX() - b.getX()) + std::abs(a.getY() - b.getY());
+    }
+
+    void scanBucket(int row, int col, const Point &from, int &best, Point &found) const {
+        if (row < 0 || row >= bucketRows || col < 0 || col >= bucketCols) return;
+
+        const std::vector<Point> &bucket = buckets[bucketOf(row, col)];
+        for (size_t i = 0; i < bucket.size(); i++) {
+            int d = distance(from, bucket[i]);
+            // Ties go to the smaller (row, col) so results never depend on insertion order
+            if (d < best || (d == best && (bucket[i].getX() < found.getX() ||
+                (bucket[i].getX() == found.getX() && bucket[i].getY() < found.getY())))) {
+                best = d;
+                found = bucket[i];
+            }
+        }
+    }
+
+public:
+
+    FoodIndex(int rows, int cols)
+        : bucketRows(rows / BUCKET + 1), bucketCols(cols / BUCKET + 1),
+          buckets(bucketRows * bucketCols), count(0) {}
+
+    void insert(const Point &p) {
+        buckets[bucketOf(p.getX() / BUCKET, p.getY() / BUCKET)].push_back(p);
+        count++;
+    }
+
+    bool remove(const Point &p) {
+        std::vector<Point> &bucket = buckets[bucketOf(p.getX() / BUCKET, p.getY() / BUCKET)];
+        for (size_t i = 0; i < bucket.size(); i++) {
+            if (bucket[i].getX() == p.getX() && bucket[i].getY() == p.getY()) {
+                bucket[i] = bucket.back();
+                bucket.pop_back();
+                count--;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void clear() {
+        for (size_t i = 0; i < buckets.size(); i++) {
+            buckets[i].clear();
+        }
+        count = 0;
+    }
+
+    int size() const { return count; }
+
+    /**
+     * @brief Finds the food closest to `from` (Manhattan distance)
+     * @return false when the index is empty
+     */
+    bool nearest(const Point &from, Point &found) const {
+        if (count == 0) return false;
+
+        int centerRow = from.getX() / BUCKET;
+        int centerCol = from.getY() / BUCKET;
+        int maxRing = bucketRows > bucketCols ? bucketRows : bucketCols;
+        int best = 0x7FFFFFFF;
+
+        for (int ring = 0; ring <= maxRing; ring++) {
+            // Every cell in this ring is at least (ring - 1) buckets away
+            if (ring > 0 && (ring - 1) * BUCKET >= best) break;
+
+            if (ring == 0) {
+                scanBucket(centerRow, centerCol, from, best, found);
+                continue;
+            }
+            for (int k = -ring; k <= ring; k++) {
+                scanBucket(centerRow - ring, centerCol + k, from, best, found);
+                scanBucket(centerRow + ring, centerCol + k, from, best, found);
+            }
+            for (int k = -ring + 1; k <= ring - 1; k++) {
+                scanBucket(centerRow + k, centerCol - ring, from, best, found);
+                scanBucket(centerRow + k, centerCol + ring, from, best, found);
+            }
+        }
+
+        return best != 0x7FFFFFFF;
+    }
+};
+
+#endif
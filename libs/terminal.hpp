@@ -12,6 +12,11 @@
 #include <ctime>
 #include <cctype>
 #include <cstdarg>
+#include <cerrno>
+#include <string>
+#include <vector>
+#include "tickstats.hpp"
+#include "inputlatency.hpp"
 
 // ============================================================================
 // TYPE DEFINITIONS AND ACS DEFINITIONS
@@ -96,6 +101,82 @@ struct ColoredChar {
     }
 };
 
+// ============================================================================
+// RENDER SINKS - Where terminal output goes
+// ============================================================================
+
+/**
+ * Destination of every byte the terminal layer produces. Output is handed
+ * over a whole frame (or escape sequence) at a time, never per cell.
+ */
+class RenderSink {
+public:
+    virtual ~RenderSink() {}
+    virtual void write(const char *bytes, size_t length) = 0;
+    virtual void flush() {}
+};
+
+/**
+ * Writes straight to a file descriptor (stdout by default)
+ */
+class FdSink : public RenderSink {
+    int fd;
+public:
+    FdSink(int fd = STDOUT_FILENO) : fd(fd) {}
+
+    void write(const char *bytes, size_t length) {
+        while (length > 0) {
+            ssize_t n = ::write(fd, bytes, length);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                return;
+            }
+            bytes += n;
+            length -= static_cast<size_t>(n);
+        }
+    }
+};
+
+/**
+ * Keeps everything in memory, for tests, benchmarks and offline rendering
+ */
+class MemorySink : public RenderSink {
+    std::string data;
+public:
+    void write(const char *bytes, size_t length) { data.append(bytes, length); }
+
+    const std::string &getData() const { return data; }
+    void clear() { data.clear(); }
+};
+
+/**
+ * Sends the same output to two sinks
+ */
+class TeeSink : public RenderSink {
+    RenderSink &first;
+    RenderSink &second;
+public:
+    TeeSink(RenderSink &first, RenderSink &second) : first(first), second(second) {}
+
+    void write(const char *bytes, size_t length) {
+        first.write(bytes, length);
+        second.write(bytes, length);
+    }
+
+    void flush() {
+        first.flush();
+        second.flush();
+    }
+};
+
+/**
+ * Discards everything, to measure rendering alone
+ */
+class NullSink : public RenderSink {
+public:
+    void write(const char *, size_t) {}
+};
+
 // ============================================================================
 // GLOBAL STATE
 // ============================================================================
@@ -106,12 +187,59 @@ static int g_cols = 80;
 static ColoredChar** g_screen_buffer = nullptr;
 static ColoredChar** g_previous_buffer = nullptr;
 static bool g_initialized = false;
+static bool g_raw_mode = false;
+
+static FdSink g_stdout_sink;
+static RenderSink *g_sink = &g_stdout_sink;
 
 // Current attributes being applied
 static int g_current_fg = -1;
 static int g_current_bg = -1;
 static int g_current_attr = 0;
 
+// Output of the last refresh: changed cells (y * cols + x) and the bytes sent
+static std::vector<int> g_dirty_cells;
+static std::string g_frame;
+
+/**
+ * Called after every refresh with the bytes written and the cells they cover
+ */
+typedef void (*frame_listener)(const char *bytes, size_t length, const int *cells, int count, void *context);
+
+#define MAX_FRAME_LISTENERS 4
+
+static frame_listener g_frame_listeners[MAX_FRAME_LISTENERS] = { nullptr };
+static void *g_frame_contexts[MAX_FRAME_LISTENERS] = { nullptr };
+
+// ============================================================================
+// OUTPUT
+// ============================================================================
+
+/**
+ * @brief Sends output to a different sink; nullptr restores stdout
+ */
+void set_render_sink(RenderSink *sink) {
+    g_sink = sink != nullptr ? sink : &g_stdout_sink;
+}
+
+/**
+ * @brief Gets the sink output currently goes to
+ */
+RenderSink *get_render_sink() {
+    return g_sink;
+}
+
+/**
+ * @brief Writes a sequence to the current sink
+ */
+void term_write(const char *bytes, size_t length) {
+    g_sink->write(bytes, length);
+}
+
+void term_write(const char *text) {
+    g_sink->write(text, std::strlen(text));
+}
+
 // ============================================================================
 // ANSI COLOR HELPER FUNCTIONS
 // ============================================================================
@@ -151,32 +279,62 @@ const char* get_ansi_bg_color(int color) {
 }
 
 /**
- * @brief Apply color and attributes to terminal
+ * @brief Appends the sequence selecting a color and attributes
  */
-void apply_ansi_color(int fg, int bg, int attr) {
-    printf(ANSI_RESET);  // Always reset first
+void append_ansi_color(std::string &out, int fg, int bg, int attr) {
+    out += ANSI_RESET;  // Always reset first
     
     if (fg >= 0) {
-        printf("%s", get_ansi_fg_color(fg));
+        out += get_ansi_fg_color(fg);
     }
     
     if (bg >= 0) {
-        printf("%s", get_ansi_bg_color(bg));
+        out += get_ansi_bg_color(bg);
     }
     
     if (attr & A_BOLD) {
-        printf(ANSI_BOLD);
+        out += ANSI_BOLD;
     }
     
     if (attr & A_REVERSE) {
-        printf("\x1b[7m");
+        out += "\x1b[7m";
     }
     
     if (attr & A_BLINK) {
-        printf("\x1b[5m");
+        out += "\x1b[5m";
     }
 }
 
+/**
+ * @brief Apply color and attributes to terminal
+ */
+void apply_ansi_color(int fg, int bg, int attr) {
+    std::string sequence;
+    append_ansi_color(sequence, fg, bg, attr);
+    term_write(sequence.data(), sequence.size());
+}
+
+/**
+ * @brief Appends one cell: cursor move, color, character and reset
+ */
+void append_cell(std::string &out, int y, int x, const ColoredChar &cell) {
+    // Same bytes as "\x1b[%d;%dH", without going through printf
+    char move[32];
+    char *p = move + sizeof(move);
+    unsigned int value = static_cast<unsigned int>(x + 1);
+    *--p = 'H';
+    do { *--p = static_cast<char>('0' + value % 10); value /= 10; } while (value > 0);
+    *--p = ';';
+    value = static_cast<unsigned int>(y + 1);
+    do { *--p = static_cast<char>('0' + value % 10); value /= 10; } while (value > 0);
+    *--p = '[';
+    *--p = '\x1b';
+    out.append(p, move + sizeof(move) - p);
+    append_ansi_color(out, cell.fg, cell.bg, cell.attr);
+    out += cell.ch;
+    out += ANSI_RESET;
+}
+
 // ============================================================================
 // TERMINAL CONTROL FUNCTIONS
 // ============================================================================
@@ -185,14 +343,26 @@ void apply_ansi_color(int fg, int bg, int attr) {
  * @brief Restores the original terminal settings
  */
 void restore_terminal() {
+    if (!g_raw_mode) return;
     tcsetattr(STDIN_FILENO, TCSAFLUSH, &g_original_termios);
 }
 
+/**
+ * @brief Puts the terminal back from a signal handler: write() and tcsetattr() only
+ */
+void restore_terminal_from_signal() {
+    static const char reset[] = ANSI_RESET ANSI_CURSOR_SHOW ANSI_CLEAR_SCREEN ANSI_CURSOR_HOME;
+    ssize_t written = ::write(STDOUT_FILENO, reset, sizeof(reset) - 1);
+    (void)written;
+    if (g_raw_mode) tcsetattr(STDIN_FILENO, TCSANOW, &g_original_termios);
+}
+
 /**
  * @brief Configures the terminal to raw/non-blocking mode
  */
 void set_raw_mode() {
-    tcgetattr(STDIN_FILENO, &g_original_termios);
+    if (tcgetattr(STDIN_FILENO, &g_original_termios) != 0) return;
+    g_raw_mode = true;
     atexit(restore_terminal);
 
     struct termios raw = g_original_termios;
@@ -212,7 +382,8 @@ void set_raw_mode() {
  */
 void get_terminal_size() {
     struct winsize w;
-    ioctl(STDOUT_FILENO, TIOCGWINSZ, &w);
+    // Keep the previous size when stdout is not a terminal
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &w) != 0 || w.ws_row == 0 || w.ws_col == 0) return;
     g_lines = w.ws_row;
     g_cols = w.ws_col;
 }
@@ -221,41 +392,37 @@ void get_terminal_size() {
  * @brief Moves cursor to position (y, x)
  */
 void go_to_xy(int y, int x) {
-    printf("\x1b[%d;%dH", y + 1, x + 1);
-    fflush(stdout);
+    char move[32];
+    int length = snprintf(move, sizeof(move), "\x1b[%d;%dH", y + 1, x + 1);
+    term_write(move, length);
 }
 
 /**
  * @brief Clears the entire screen
  */
 void clear_screen() {
-    printf(ANSI_CLEAR_SCREEN);
-    printf(ANSI_CURSOR_HOME);
-    fflush(stdout);
+    term_write(ANSI_CLEAR_SCREEN ANSI_CURSOR_HOME);
 }
 
 /**
  * @brief Hides the cursor
  */
 void hide_cursor() {
-    printf(ANSI_CURSOR_HIDE);
-    fflush(stdout);
+    term_write(ANSI_CURSOR_HIDE);
 }
 
 /**
  * @brief Shows the cursor
  */
 void show_cursor() {
-    printf(ANSI_CURSOR_SHOW);
-    fflush(stdout);
+    term_write(ANSI_CURSOR_SHOW);
 }
 
 /**
  * @brief Resets all attributes
  */
 void reset_attributes() {
-    printf(ANSI_RESET);
-    fflush(stdout);
+    term_write(ANSI_RESET);
 }
 
 // ============================================================================
@@ -269,8 +436,11 @@ int handle_special_keys() {
     char c;
     
     if (read(STDIN_FILENO, &c, 1) != 1) {
+        if (g_input_latency != nullptr) g_input_latency->noKey(tick_now());
         return -1;
     }
+    // Stamped at the first byte, before an escape sequence is decoded
+    if (g_input_latency != nullptr) g_input_latency->keyRead(tick_now());
     
     // Check for ESC sequence start
     if (c == '\x1b') {
@@ -316,11 +486,12 @@ void timeout(int ms) {
 // ============================================================================
 
 /**
- * @brief Initializes the screen buffer system
+ * @brief Initializes the screen buffers for an explicit size
  */
-void init_screen() {
-    get_terminal_size();
-    
+void init_screen(int lines, int cols) {
+    g_lines = lines;
+    g_cols = cols;
+
     // Allocate current buffer
     g_screen_buffer = new ColoredChar*[g_lines];
     for (int i = 0; i < g_lines; i++) {
@@ -339,9 +510,18 @@ void init_screen() {
         }
     }
     
+    g_dirty_cells.reserve(g_lines * g_cols);
     g_initialized = true;
 }
 
+/**
+ * @brief Initializes the screen buffer system
+ */
+void init_screen() {
+    get_terminal_size();
+    init_screen(g_lines, g_cols);
+}
+
 /**
  * @brief Frees the screen buffers
  */
@@ -360,36 +540,106 @@ void cleanup_screen() {
 }
 
 /**
- * @brief Renders only the differences with colors
+ * @brief Registers a listener for refreshed frames; returns false when full
  */
-void refresh_diff() {
+bool add_frame_listener(frame_listener listener, void *context) {
+    for (int i = 0; i < MAX_FRAME_LISTENERS; i++) {
+        if (g_frame_listeners[i] == nullptr) {
+            g_frame_listeners[i] = listener;
+            g_frame_contexts[i] = context;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Unregisters a frame listener
+ */
+void remove_frame_listener(frame_listener listener, void *context) {
+    for (int i = 0; i < MAX_FRAME_LISTENERS; i++) {
+        if (g_frame_listeners[i] == listener && g_frame_contexts[i] == context) {
+            g_frame_listeners[i] = nullptr;
+            g_frame_contexts[i] = nullptr;
+        }
+    }
+}
+
+/**
+ * @brief Encodes the whole displayed screen, starting from a cleared terminal
+ */
+void encode_keyframe(std::string &out) {
+    out += ANSI_CLEAR_SCREEN;
+    out += ANSI_CURSOR_HOME;
+    if (!g_initialized) return;
+
     for (int y = 0; y < g_lines; y++) {
         for (int x = 0; x < g_cols; x++) {
-            if (g_screen_buffer[y][x] != g_previous_buffer[y][x]) {
-                go_to_xy(y, x);
-                
-                // Apply color
-                apply_ansi_color(g_screen_buffer[y][x].fg, 
-                                g_screen_buffer[y][x].bg, 
-                                g_screen_buffer[y][x].attr);
-                
-                // Print character
-                printf("%c", g_screen_buffer[y][x].ch);
-                
-                // Reset after each character
-                printf(ANSI_RESET);
-            }
+            const ColoredChar &cell = g_previous_buffer[y][x];
+            if (cell.ch == '\0' || (cell.ch == ' ' && cell.fg < 0 && cell.bg < 0 && cell.attr == 0)) continue;
+            append_cell(out, y, x, cell);
         }
     }
-    
-    // Copy current to previous for next refresh
+}
+
+/**
+ * @brief Encodes the differences into g_frame without writing them
+ */
+void encode_diff() {
+    g_dirty_cells.clear();
+    g_frame.clear();
+
     for (int y = 0; y < g_lines; y++) {
         for (int x = 0; x < g_cols; x++) {
-            g_previous_buffer[y][x] = g_screen_buffer[y][x];
+            if (g_screen_buffer[y][x] != g_previous_buffer[y][x]) {
+                g_dirty_cells.push_back(y * g_cols + x);
+                append_cell(g_frame, y, x, g_screen_buffer[y][x]);
+
+                // Copy current to previous for next refresh
+                g_previous_buffer[y][x] = g_screen_buffer[y][x];
+            }
+        }
+    }
+}
+
+/**
+ * @brief Bytes of the last frame refresh_diff() wrote
+ */
+size_t frame_bytes() {
+    return g_frame.size();
+}
+
+/**
+ * @brief Cells that changed in the last frame refresh_diff() wrote
+ */
+size_t frame_cells() {
+    return g_dirty_cells.size();
+}
+
+/**
+ * @brief Renders only the differences with colors
+ */
+void refresh_diff() {
+    {
+        TickTimer render(TICK_RENDER);
+        encode_diff();
+    }
+    if (g_input_latency != nullptr) g_input_latency->rendered(tick_now());
+    {
+        TickTimer flush(TICK_FLUSH);
+        // One write per frame instead of one per cell
+        if (!g_frame.empty()) term_write(g_frame.data(), g_frame.size());
+        g_sink->flush();
+    }
+    if (g_input_latency != nullptr) g_input_latency->flushed(tick_now());
+
+    for (int i = 0; i < MAX_FRAME_LISTENERS; i++) {
+        if (g_frame_listeners[i] != nullptr) {
+            g_frame_listeners[i](g_frame.data(), g_frame.size(),
+                                 g_dirty_cells.data(), static_cast<int>(g_dirty_cells.size()),
+                                 g_frame_contexts[i]);
         }
     }
-    
-    fflush(stdout);
 }
 
 // ============================================================================
@@ -405,7 +655,18 @@ void initscr() {
     init_screen();
     clear_screen();
     reset_attributes();
-    fflush(stdout);
+}
+
+/**
+ * @brief Initializes a headless screen of the given size
+ *
+ * The terminal is neither queried nor switched to raw mode, so the full
+ * rendering path runs without a TTY; pair it with set_render_sink().
+ */
+void initscr(int lines, int cols) {
+    init_screen(lines, cols);
+    clear_screen();
+    reset_attributes();
 }
 
 /**
@@ -499,10 +760,7 @@ void clear() {
  * @brief Full clear of terminal and buffers (use before game starts)
  */
 void full_clear_screen() {
-    printf(ANSI_CLEAR_SCREEN);
-    printf(ANSI_CURSOR_HOME);
-    reset_attributes();
-    fflush(stdout);
+    term_write(ANSI_CLEAR_SCREEN ANSI_CURSOR_HOME ANSI_RESET);
     
     // Reset all buffers
     for (int i = 0; i < g_lines; i++) {
@@ -564,8 +822,8 @@ void attron(int attr) {
     
     g_current_attr = attr & ~0xFF;  // Store only attributes, not color pair
     
-    // Send to terminal for direct output functions (printw, etc)
-    apply_ansi_color(g_current_fg, g_current_bg, g_current_attr);
+    // Nothing is sent here: refresh() colors every cell and printw() applies
+    // the current attributes itself
 }
 
 /**
@@ -576,7 +834,6 @@ void attroff(int attr) {
     g_current_fg = -1;
     g_current_bg = -1;
     g_current_attr = 0;
-    reset_attributes();
 }
 
 /**
@@ -617,10 +874,14 @@ int printw(const char* fmt, ...) {
     vsnprintf(buffer, sizeof(buffer), fmt, args);
     va_end(args);
     
-    // Apply current color and print
-    apply_ansi_color(g_current_fg, g_current_bg, g_current_attr);
-    printf("%s", buffer);
-    fflush(stdout);
+    // Apply current color, print and leave the terminal reset; the
+    // buffer keeps its capacity between calls
+    static std::string sequence;
+    sequence.clear();
+    append_ansi_color(sequence, g_current_fg, g_current_bg, g_current_attr);
+    sequence += buffer;
+    sequence += ANSI_RESET;
+    term_write(sequence.data(), sequence.size());
     
     return std::strlen(buffer);
 }
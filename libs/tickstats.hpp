@@ -0,0 +1,237 @@
+#ifndef TICKSTATS_H_
+#define TICKSTATS_H_
+
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+
+/**
+ * Nanosecond tick timing kept in HDR-style histograms (--tick-stats).
+ *
+ * Four things are measured per tick: how late it started against its
+ * deadline, the game logic before drawing (compute), encoding the frame
+ * (render) and writing it out (flush). Each goes into a log-linear
+ * histogram: exact below 128 ns, then 64 buckets per power of two, so
+ * any recorded value is off by less than 1.6% and a record is a couple
+ * of shifts and an increment, with no allocation.
+ *
+ * Percentiles are printed on exit; SIGUSR1 asks for the same report in
+ * the middle of a game. The handler only sets a flag, and the next tick
+ * prints the report once it is done, so the game keeps running. Only
+ * frames drawn by a tick are timed, not menus.
+ */
+
+enum TickMetric {
+    TICK_LATENESS,  // tick start after its deadline
+    TICK_COMPUTE,   // input, movement, collision and drawing into the buffer
+    TICK_RENDER,    // encoding the changed cells into a frame
+    TICK_FLUSH,     // writing the frame to the terminal
+    TICK_METRICS
+};
+
+/**
+ * @brief Monotonic time in nanoseconds
+ */
+inline long long tick_now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+class LatencyHistogram {
+
+    enum {
+        SUB_BITS = 6,                       // 64 buckets per power of two
+        HALF = 1 << SUB_BITS,
+        MAX_SHIFT = 40 - SUB_BITS,          // values are capped at 2^40 ns (18 min)
+        BUCKETS = HALF * (MAX_SHIFT + 2)
+    };
+
+    unsigned long long buckets[BUCKETS];
+    unsigned long long count;
+    unsigned long long sum;
+    long long min;
+    long long max;
+
+    static int indexOf(long long value) {
+        if (value < 2 * HALF) return static_cast<int>(value);
+        int shift = 63 - __builtin_clzll(static_cast<unsigned long long>(value)) - SUB_BITS;
+        return HALF * shift + static_cast<int>(value >> shift);
+    }
+
+    // Largest value that falls into bucket `index`
+    static long long highestIn(int index) {
+        if (index < 2 * HALF) return index;
+        int shift = index / HALF - 1;
+        long long sub = index - HALF * shift;
+        return ((sub + 1) << shift) - 1;
+    }
+
+public:
+
+    LatencyHistogram() {
+        clear();
+    }
+
+    void clear() {
+        std::memset(buckets, 0, sizeof(buckets));
+        count = 0;
+        sum = 0;
+        min = 0;
+        max = 0;
+    }
+
+    void record(long long ns) {
+        if (ns < 0) ns = 0;
+        if (ns >= (1LL << 40)) ns = (1LL << 40) - 1;
+        buckets[indexOf(ns)]++;
+        if (count == 0 || ns < min) min = ns;
+        if (ns > max) max = ns;
+        count++;
+        sum += ns;
+    }
+
+    unsigned long long getCount() const { return count; }
+    long long getMin() const { return min; }
+    long long getMax() const { return max; }
+    double getMean() const { return count ? static_cast<double>(sum) / count : 0; }
+
+    /**
+     * @brief Smallest value at or above `percent` of the records (0 when empty)
+     */
+    long long percentile(double percent) const {
+        if (count == 0) return 0;
+        unsigned long long rank = static_cast<unsigned long long>(percent / 100.0 * count + 0.5);
+        if (rank < 1) rank = 1;
+        if (rank > count) rank = count;
+
+        unsigned long long seen = 0;
+        for (int i = 0; i < BUCKETS; i++) {
+            seen += buckets[i];
+            if (seen >= rank) {
+                long long value = highestIn(i);
+                return value < max ? value : max;
+            }
+        }
+        return max;
+    }
+};
+
+class TickStats {
+
+    long long tickStart;
+    bool ticking;
+
+public:
+
+    LatencyHistogram metrics[TICK_METRICS];
+    unsigned long long missed;  // deadlines passed before their tick started
+
+    TickStats() : tickStart(0), ticking(false), missed(0) {}
+
+    void clear() {
+        for (int i = 0; i < TICK_METRICS; i++) metrics[i].clear();
+        missed = 0;
+    }
+
+    /**
+     * @brief A tick that was due `lateness` ns ago starts now, after `missedDeadlines` more passed
+     */
+    void beginTick(long long lateness, unsigned long long missedDeadlines = 0) {
+        tickStart = tick_now();
+        ticking = true;
+        missed += missedDeadlines;
+        metrics[TICK_LATENESS].record(lateness);
+    }
+
+    /**
+     * @brief The game logic of the current tick is done; drawing comes next
+     */
+    void endCompute() {
+        metrics[TICK_COMPUTE].record(tick_now() - tickStart);
+    }
+
+    void endTick() {
+        ticking = false;
+    }
+
+    // Frames drawn outside a tick (menus, waiting screens) are not timed
+    bool isTicking() const { return ticking; }
+
+    /**
+     * @brief Percentiles of every metric, in microseconds
+     */
+    void report(FILE *out) const {
+        static const char *names[TICK_METRICS] = { "lateness", "compute", "render", "flush" };
+
+        fprintf(out, "%-9s %8s %10s %10s %10s %10s %10s %10s %10s\n",
+                "tick us", "count", "min", "p50", "p90", "p99", "p99.9", "max", "mean");
+        for (int i = 0; i < TICK_METRICS; i++) {
+            const LatencyHistogram &h = metrics[i];
+            fprintf(out, "%-9s %8llu %10.3f %10.3f %10.3f %10.3f %10.3f %10.3f %10.3f\n",
+                    names[i], h.getCount(), h.getMin() / 1000.0, h.percentile(50) / 1000.0,
+                    h.percentile(90) / 1000.0, h.percentile(99) / 1000.0, h.percentile(99.9) / 1000.0,
+                    h.getMax() / 1000.0, h.getMean() / 1000.0);
+        }
+
+        const LatencyHistogram &late = metrics[TICK_LATENESS];
+        if (late.getCount() > 0) {
+            fprintf(out, "p99 lateness %.3f ms (target < 1 ms): %s, %llu missed deadlines\n", late.percentile(99) / 1e6,
+                    late.percentile(99) < 1000000 ? "ok" : "over", missed);
+        }
+        fflush(out);
+    }
+};
+
+// Set while --tick-stats is running
+static TickStats *g_tick_stats = nullptr;
+
+// Where SIGUSR1 reports go; never the terminal the game draws on, so they are dropped when unset
+static FILE *g_tick_stats_out = nullptr;
+
+static volatile sig_atomic_t g_tick_stats_requested = 0;
+
+/**
+ * @brief SIGUSR1 handler: the next tick prints a report
+ */
+inline void tick_stats_request(int /* sig */) {
+    g_tick_stats_requested = 1;
+}
+
+/**
+ * @brief Ends the current tick and prints the report SIGUSR1 asked for, if any
+ */
+inline void tick_stats_end_tick() {
+    if (g_tick_stats == nullptr) return;
+    g_tick_stats->endTick();
+    if (__builtin_expect(g_tick_stats_requested != 0, 0)) {
+        g_tick_stats_requested = 0;
+        if (g_tick_stats_out != nullptr) g_tick_stats->report(g_tick_stats_out);
+    }
+}
+
+/**
+ * @brief Records the time spent in the enclosing block as one metric
+ */
+class TickTimer {
+
+    TickMetric metric;
+    long long start;
+
+public:
+
+    explicit TickTimer(TickMetric metric) : metric(metric), start(0) {
+        if (__builtin_expect(g_tick_stats != nullptr, 0) && g_tick_stats->isTicking()) start = tick_now();
+    }
+
+    ~TickTimer() {
+        if (__builtin_expect(start != 0, 0) && g_tick_stats != nullptr) {
+            g_tick_stats->metrics[metric].record(tick_now() - start);
+        }
+    }
+
+    TickTimer(const TickTimer &) = delete;
+    TickTimer &operator=(const TickTimer &) = delete;
+};
+
+#endif
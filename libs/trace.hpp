@@ -0,0 +1,220 @@
+#ifndef TRACE_H_
+#define TRACE_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * Scoped spans in Chrome trace-event format (chrome://tracing, Perfetto).
+ *
+ *     TRACE_SCOPE("collision");
+ *
+ * records the time from that line to the end of the enclosing block. Every
+ * thread appends to its own fixed-size ring, so recording is two clock
+ * reads and a few stores with no lock; a full ring overwrites its oldest
+ * spans. trace_write() turns all rings into one JSON file, once the other
+ * threads are done.
+ *
+ * Until trace_start() a scope only tests g_trace_enabled, which is always
+ * false and predicted as such, and its end tests the answer it kept.
+ */
+
+#define TRACE_RING_EVENTS (1 << 16)
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(trace_scope_, __LINE__)(name)
+
+struct TraceEvent {
+    const char *name;           // must outlive the trace, e.g. a literal
+    unsigned long long start;   // ns since trace_start()
+    unsigned long long duration;
+};
+
+/**
+ * @brief One thread's spans; only that thread writes
+ */
+class TraceRing {
+
+    std::vector<TraceEvent> events;
+    unsigned long mask;
+    std::atomic<unsigned long> head;
+
+public:
+
+    int tid;
+    std::string name;
+
+    TraceRing(size_t capacity, int tid) : mask(0), head(0), tid(tid) {
+        size_t size = 1;
+        while (size < capacity) size <<= 1;
+        events.resize(size);
+        mask = size - 1;
+    }
+
+    void push(const char *name, unsigned long long start, unsigned long long duration) {
+        unsigned long at = head.load(std::memory_order_relaxed);
+        TraceEvent &event = events[at & mask];
+        event.name = name;
+        event.start = start;
+        event.duration = duration;
+        head.store(at + 1, std::memory_order_release);
+    }
+
+    unsigned long getHead() const { return head.load(std::memory_order_acquire); }
+
+    size_t getCapacity() const { return events.size(); }
+
+    const TraceEvent &at(unsigned long index) const { return events[index & mask]; }
+
+    void clear() { head.store(0, std::memory_order_release); }
+};
+
+static bool g_trace_enabled = false;
+static size_t g_trace_capacity = TRACE_RING_EVENTS;
+static std::chrono::steady_clock::time_point g_trace_epoch;
+
+// Rings live until exit so spans of finished threads are still written
+static std::mutex g_trace_mutex;
+static std::vector<TraceRing *> g_trace_rings;
+static thread_local TraceRing *t_trace_ring = nullptr;
+
+inline unsigned long long trace_now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - g_trace_epoch).count();
+}
+
+/**
+ * @brief This thread's ring, made on its first span
+ */
+inline TraceRing &trace_ring() {
+    if (t_trace_ring == nullptr) {
+        std::lock_guard<std::mutex> lock(g_trace_mutex);
+        t_trace_ring = new TraceRing(g_trace_capacity, static_cast<int>(g_trace_rings.size()) + 1);
+        g_trace_rings.push_back(t_trace_ring);
+    }
+    return *t_trace_ring;
+}
+
+__attribute__((noinline)) inline void trace_record(const char *name, unsigned long long start) {
+    trace_ring().push(name, start, trace_now() - start);
+}
+
+class TraceScope {
+
+    const char *name;
+    unsigned long long start;
+
+public:
+
+    explicit TraceScope(const char *name) : name(nullptr), start(0) {
+        if (__builtin_expect(g_trace_enabled, 0)) {
+            this->name = name;
+            start = trace_now();
+        }
+    }
+
+    ~TraceScope() {
+        if (__builtin_expect(name != nullptr, 0)) trace_record(name, start);
+    }
+
+    TraceScope(const TraceScope &) = delete;
+    TraceScope &operator=(const TraceScope &) = delete;
+};
+
+/**
+ * @brief Starts recording; rings made from now on hold `eventsPerThread` spans
+ */
+inline void trace_start(size_t eventsPerThread = TRACE_RING_EVENTS) {
+    g_trace_capacity = eventsPerThread;
+    g_trace_epoch = std::chrono::steady_clock::now();
+    g_trace_enabled = true;
+}
+
+inline void trace_stop() {
+    g_trace_enabled = false;
+}
+
+/**
+ * @brief Drops every recorded span, keeping the rings
+ */
+inline void trace_clear() {
+    std::lock_guard<std::mutex> lock(g_trace_mutex);
+    for (size_t i = 0; i < g_trace_rings.size(); i++) g_trace_rings[i]->clear();
+}
+
+/**
+ * @brief Names the calling thread in the trace viewer
+ */
+inline void trace_set_thread_name(const char *name) {
+    trace_ring().name = name;
+}
+
+/**
+ * @brief Spans lost to full rings
+ */
+inline unsigned long trace_dropped() {
+    std::lock_guard<std::mutex> lock(g_trace_mutex);
+    unsigned long dropped = 0;
+    for (size_t i = 0; i < g_trace_rings.size(); i++) {
+        unsigned long head = g_trace_rings[i]->getHead();
+        size_t capacity = g_trace_rings[i]->getCapacity();
+        if (head > capacity) dropped += head - capacity;
+    }
+    return dropped;
+}
+
+/**
+ * @brief Appends every ring as a trace-event JSON object
+ *
+ * Timestamps are microseconds with nanosecond decimals, as the format asks.
+ */
+inline void trace_json(std::string &out) {
+    std::lock_guard<std::mutex> lock(g_trace_mutex);
+    char line[256];
+    out += "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n";
+    bool first = true;
+
+    for (size_t r = 0; r < g_trace_rings.size(); r++) {
+        const TraceRing &ring = *g_trace_rings[r];
+        if (!ring.name.empty()) {
+            snprintf(line, sizeof(line),
+                     "%s{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %d, \"args\": {\"name\": \"%s\"}}",
+                     first ? "" : ",\n", ring.tid, ring.name.c_str());
+            out += line;
+            first = false;
+        }
+
+        unsigned long head = ring.getHead();
+        unsigned long begin = head > ring.getCapacity() ? head - ring.getCapacity() : 0;
+        for (unsigned long i = begin; i < head; i++) {
+            const TraceEvent &event = ring.at(i);
+            snprintf(line, sizeof(line),
+                     "%s{\"name\": \"%s\", \"ph\": \"X\", \"pid\": 1, \"tid\": %d, \"ts\": %llu.%03llu, \"dur\": %llu.%03llu}",
+                     first ? "" : ",\n", event.name, ring.tid,
+                     event.start / 1000, event.start % 1000, event.duration / 1000, event.duration % 1000);
+            out += line;
+            first = false;
+        }
+    }
+    out += "\n]}\n";
+}
+
+/**
+ * @brief Writes the trace to `path`; false when the file cannot be written
+ */
+inline bool trace_write(const char *path) {
+    std::string json;
+    trace_json(json);
+
+    FILE *file = fopen(path, "w");
+    if (file == nullptr) return false;
+    bool ok = fwrite(json.data(), 1, json.size(), file) == json.size();
+    return fclose(file) == 0 && ok;
+}
+
+#endif
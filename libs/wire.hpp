@@ -0,0 +1,29 @@
+#ifndef WIRE_H_
+#define WIRE_H_
+
+// Big-endian field helpers shared by the network protocols
+
+// Match server (server.hpp) -> client frame types; every frame is [u16 length][u8 type][payload]
+#define FRAME_WELCOME 1
+#define FRAME_DELTA 2
+#define FRAME_KEYFRAME 3
+
+// Cell kinds carried in DELTA/KEYFRAME entries; snakes are CELL_SNAKE + player
+#define CELL_EMPTY 0
+#define CELL_FOOD 2
+#define CELL_SNAKE 3
+
+#define FRAME_HEADER 3
+#define CELL_ENTRY 5
+
+// The u16 length counts the type byte and the payload
+#define FRAME_MAX_LENGTH 65535
+
+inline void netPut16(unsigned char *p, unsigned int v) { p[0] = v >> 8; p[1] = v; }
+inline void netPut32(unsigned char *p, unsigned int v) { p[0] = v >> 24; p[1] = v >> 16; p[2] = v >> 8; p[3] = v; }
+inline unsigned int netGet16(const unsigned char *p) { return (p[0] << 8) | p[1]; }
+inline unsigned int netGet32(const unsigned char *p) {
+    return (static_cast<unsigned int>(p[0]) << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+}
+
+#endif
@@ -0,0 +1,193 @@
+#include <unistd.h>
+#include <fcntl.h>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include "./libs/common.hpp"
+#include "./libs/wire.hpp"
+
+// Load generator for tsnake-server: thousands of bot clients on a few epoll threads
+
+struct BotStats {
+    std::atomic<int> connected;
+    std::atomic<int> failed;
+    std::atomic<int> closed;
+    std::atomic<unsigned long> frames;
+    std::atomic<unsigned long> keyframes;
+    std::atomic<unsigned long> bytes;
+
+    BotStats() : connected(0), failed(0), closed(0), frames(0), keyframes(0), bytes(0) {}
+};
+
+struct Bot {
+    int fd;
+    int used;
+    std::vector<unsigned char> in;  // grows to the largest frame seen, 2 + 65535 at most
+};
+
+std::atomic<bool> running(true);
+BotStats stats;
+
+void stopFunction(int /* sig */) {
+    running = false;
+}
+
+// Consumes complete frames; returns false on a malformed stream
+bool parseFrames(Bot &bot, std::mt19937 &rng) {
+    int offset = 0;
+    while (bot.used - offset >= FRAME_HEADER) {
+        int length = static_cast<int>(netGet16(&bot.in[offset]));
+        if (length < 1) return false;
+        if (bot.used - offset < length + 2) {
+            if (length + 2 > static_cast<int>(bot.in.size())) bot.in.resize(length + 2);
+            break;
+        }
+
+        int type = bot.in[offset + FRAME_HEADER - 1];
+        stats.frames.fetch_add(1, std::memory_order_relaxed);
+        if (type == FRAME_KEYFRAME) stats.keyframes.fetch_add(1, std::memory_order_relaxed);
+
+        // Turn now and then, like a player would
+        if (type == FRAME_DELTA && rng() % 8 == 0) {
+            unsigned char direction = static_cast<unsigned char>(2 + rng() % 4);
+            if (send(bot.fd, &direction, 1, MSG_NOSIGNAL) < 0 && errno != EAGAIN) return false;
+        }
+        offset += length + 2;
+    }
+    std::memmove(&bot.in[0], &bot.in[offset], bot.used - offset);
+    bot.used -= offset;
+    return true;
+}
+
+void runBots(const sockaddr_in &server, int count, int seed) {
+    int epfd = epoll_create1(0);
+    std::vector<Bot> bots(count);
+    std::mt19937 rng(seed);
+
+    for (int i = 0; i < count && running; i++) {
+        Bot &bot = bots[i];
+        bot.used = 0;
+        bot.in.resize(4096);
+        bot.fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (bot.fd < 0 || connect(bot.fd, reinterpret_cast<const sockaddr *>(&server), sizeof(server)) != 0) {
+            if (bot.fd >= 0) close(bot.fd);
+            bot.fd = -1;
+            stats.failed.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        fcntl(bot.fd, F_SETFL, fcntl(bot.fd, F_GETFL, 0) | O_NONBLOCK);
+
+        epoll_event ev;
+        std::memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN;
+        ev.data.u32 = static_cast<unsigned int>(i);
+        epoll_ctl(epfd, EPOLL_CTL_ADD, bot.fd, &ev);
+        stats.connected.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    epoll_event events[256];
+    while (running) {
+        int n = epoll_wait(epfd, events, 256, 100);
+        for (int e = 0; e < n; e++) {
+            Bot &bot = bots[events[e].data.u32];
+            if (bot.fd < 0) continue;
+
+            ssize_t got = recv(bot.fd, &bot.in[bot.used], bot.in.size() - bot.used, 0);
+            if (got > 0) {
+                bot.used += static_cast<int>(got);
+                stats.bytes.fetch_add(got, std::memory_order_relaxed);
+                if (parseFrames(bot, rng)) continue;
+            } else if (got < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                continue;
+            }
+            close(bot.fd);
+            bot.fd = -1;
+            stats.closed.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    for (int i = 0; i < count; i++) {
+        if (bots[i].fd >= 0) close(bots[i].fd);
+    }
+    close(epfd);
+}
+
+void usage(const char *name) {
+    printf("Usage: %s [--host=127.0.0.1] [--port=7878] [--clients=10000] [--threads=N] [--seconds=10]\n", name);
+}
+
+int main(int argc, char **argv) {
+
+    const char *host = "127.0.0.1";
+    int port = 7878;
+    int clients = 10000;
+    int threads = static_cast<int>(std::thread::hardware_concurrency());
+    int seconds = 10;
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        if (std::strncmp(arg, "--host=", 7) == 0) host = arg + 7;
+        else if (std::strncmp(arg, "--port=", 7) == 0) port = std::atoi(arg + 7);
+        else if (std::strncmp(arg, "--clients=", 10) == 0) clients = std::atoi(arg + 10);
+        else if (std::strncmp(arg, "--threads=", 10) == 0) threads = std::atoi(arg + 10);
+        else if (std::strncmp(arg, "--seconds=", 10) == 0) seconds = std::atoi(arg + 10);
+        else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (threads < 1) threads = 1;
+
+    sockaddr_in server;
+    std::memset(&server, 0, sizeof(server));
+    server.sin_family = AF_INET;
+    server.sin_port = htons(static_cast<unsigned short>(port));
+    if (inet_pton(AF_INET, host, &server.sin_addr) != 1) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+    signal(SIGINT, stopFunction);
+    signal(SIGPIPE, SIG_IGN);
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        int share = clients / threads + (t < clients % threads ? 1 : 0);
+        workers.push_back(std::thread(runBots, server, share, 1000 + t));
+    }
+
+    for (int s = 0; s < seconds * 10 && running; s++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    running = false;
+    for (size_t t = 0; t < workers.size(); t++) {
+        workers[t].join();
+    }
+
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    unsigned long frames = stats.frames.load();
+    printf("clients: %d connected, %d failed, %d closed by server\n",
+           stats.connected.load(), stats.failed.load(), stats.closed.load());
+    printf("frames: %lu (%lu keyframes), %.0f frames/s, %.1f KB/s, %.1f bytes/frame\n",
+           frames, stats.keyframes.load(), frames / elapsed, stats.bytes.load() / 1024.0 / elapsed,
+           frames ? static_cast<double>(stats.bytes.load()) / frames : 0.0);
+    return 0;
+}
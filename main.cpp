@@ -1,13 +1,26 @@
 #include <csignal>
-#include "./libs/terminal.hpp"
+#include <cstring>
+#include "./libs/backend.hpp"
 #include <iostream>
 #include "./libs/game.hpp"
+#include "./libs/multigame.hpp"
+#include "./libs/netgame.hpp"
+#if BACKEND_FRAME_HOOKS
+#include "./libs/broadcast.hpp"
+#include "./libs/recorder.hpp"
+#endif
 #include "./libs/menu.hpp"
 #include "./libs/highscore.hpp"
+#include "./libs/trace.hpp"
+#include "./libs/perfcounters.hpp"
+#include "./libs/allocstats.hpp"
+#include "./libs/tickstats.hpp"
+#include "./libs/flightrecorder.hpp"
+#include "./libs/log.hpp"
+#include "./libs/inputlatency.hpp"
 
 void setupGame() {
-    initscr();              // Initialize terminal
-    start_color();          // Start color support
+    Backend::start();       // Initialize terminal and colors
     cbreak();               // Line buffering disabled
     use_default_colors();   // Use default terminal colors
     curs_set(0);            // Hide cursor
@@ -23,12 +36,16 @@ void interruptFunction(int /* sig */) {
     endwin();           // exit NCurses
 }
 
-bool runGame(int level) {
+// One round per call; the Game and everything it owns live in `arena`
+bool runGame(int level, GameArena &arena, const TickConfig &tick) {
 
     char ch;
-    Game *g = new Game(level);
+    GameArena::Mark start = arena.mark();
+    Game *g = arena.make<Game>(level, arena, tick);
     
-    while(!interruptFlag && !g->isGameOver());
+    while(!interruptFlag && !g->isGameOver()) {
+        g->waitForTick();
+    }
     
     bool playAgain = false;
     
@@ -44,17 +61,183 @@ bool runGame(int level) {
         if (ch == 'Y' || ch == '\n'){
             playAgain = true;
             // Clean terminal completely before next game
-            full_clear_screen();
+            Backend::fullClear();
         }
     }
     
+    arena.rewind(start);
+    return playAgain;
+}
+
+// Stores a finished game as DIR/tsnake-<time>-<seed>.tsr
+void saveReplay(const Replay &replay, const std::string &dir) {
+    char name[64];
+    snprintf(name, sizeof(name), "/tsnake-%ld-%u.tsr", static_cast<long>(time(nullptr)), replay.getSeed());
+    replay.save((dir + name).c_str());
+}
+
+bool runMultiplayer(int players, int level, const std::string &replayDir, const TickConfig &tick) {
+
+    char ch;
+    MultiGame *g = new MultiGame(players, level, std::random_device()(), tick);
+
+    while(!interruptFlag && !g->isGameOver()) {
+        g->waitForTick();
+    }
+
+    if (!interruptFlag && !replayDir.empty()) {
+        saveReplay(g->getReplay(), replayDir);
+    }
+
+    bool playAgain = false;
+
+    if (!interruptFlag) {
+
+        do{
+
+            ch = getch();
+            ch = toupper(ch);
+
+        } while (ch != 'Y' && ch != 'N' && ch != '\n' && !interruptFlag);
+
+        if (ch == 'Y' || ch == '\n'){
+            playAgain = true;
+            Backend::fullClear();
+        }
+    }
+
     delete g;
     return playAgain;
 }
 
-void showMenu() {
+// Command line options
+struct Options {
+    bool host;
+    bool join;
+    int port;
+    std::string peer;
+    std::string spectate;
+    std::string record;
+    std::string replayDir;
+    std::string trace;
+    bool perfCounters;
+    bool tickStats;
+    std::string tickStatsFile;
+    bool inputLatency;
+    std::string flightLog;
+    std::string log;
+    TickConfig tick;
+    int level;
+
+    Options() : host(false), join(false), port(NET_DEFAULT_PORT), perfCounters(false), tickStats(false), inputLatency(false),
+                level(2) {}
+};
+
+bool parseOptions(int argc, char **argv, Options &options) {
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        if (std::strcmp(arg, "--host") == 0) {
+            options.host = true;
+        } else if (std::strncmp(arg, "--host=", 7) == 0) {
+            options.host = true;
+            options.port = std::atoi(arg + 7);
+        } else if (std::strncmp(arg, "--connect=", 10) == 0) {
+            options.join = true;
+            options.peer = arg + 10;
+            size_t colon = options.peer.find(':');
+            if (colon != std::string::npos) {
+                options.port = std::atoi(options.peer.c_str() + colon + 1);
+                options.peer = options.peer.substr(0, colon);
+            }
+#if BACKEND_FRAME_HOOKS
+        } else if (std::strncmp(arg, "--spectate=", 11) == 0) {
+            options.spectate = arg + 11;
+        } else if (std::strncmp(arg, "--record=", 9) == 0) {
+            options.record = arg + 9;
+#endif
+        } else if (std::strncmp(arg, "--save-replays=", 15) == 0) {
+            options.replayDir = arg + 15;
+        } else if (std::strncmp(arg, "--trace=", 8) == 0) {
+            options.trace = arg + 8;
+        } else if (std::strcmp(arg, "--perf-counters") == 0) {
+            options.perfCounters = true;
+        } else if (std::strcmp(arg, "--tick-stats") == 0) {
+            options.tickStats = true;
+        } else if (std::strncmp(arg, "--tick-stats=", 13) == 0) {
+            options.tickStats = true;
+            options.tickStatsFile = arg + 13;
+        } else if (std::strcmp(arg, "--input-latency") == 0) {
+            options.inputLatency = true;
+        } else if (std::strncmp(arg, "--flight-log=", 13) == 0) {
+            options.flightLog = arg + 13;
+        } else if (std::strncmp(arg, "--log=", 6) == 0) {
+            options.log = arg + 6;
+        } else if (std::strncmp(arg, "--tick-rate=", 12) == 0) {
+            options.tick.rate = std::atof(arg + 12);
+            if (options.tick.rate < TickScheduler::MIN_HZ || options.tick.rate > TickScheduler::MAX_HZ) return false;
+        } else if (std::strncmp(arg, "--speedup=", 10) == 0) {
+            options.tick.speedup = std::atof(arg + 10);
+        } else if (std::strncmp(arg, "--tick-spin=", 12) == 0) {
+            options.tick.spinNs = std::atol(arg + 12) * 1000LL;
+        } else if (std::strcmp(arg, "--tick-policy=catch-up") == 0) {
+            options.tick.policy = TICK_CATCH_UP;
+        } else if (std::strcmp(arg, "--tick-policy=drop") == 0) {
+            options.tick.policy = TICK_DROP;
+        } else if (std::strncmp(arg, "--level=", 8) == 0) {
+            options.level = std::atoi(arg + 8);
+        } else {
+            return false;
+        }
+    }
+    return !(options.host && options.join) && options.level > 0 && options.port > 0;
+}
+
+void usage(const char *name) {
+    std::cerr << "Usage: " << name << " [--host[=PORT] | --connect=HOST[:PORT]] [--level=N]"
+#if BACKEND_FRAME_HOOKS
+              << " [--spectate=tcp:PORT|unix:PATH] [--record=FILE.cast]"
+#endif
+              << " [--save-replays=DIR] [--trace=FILE.json] [--perf-counters] [--tick-stats[=FILE]] [--input-latency]"
+              << " [--tick-rate=5..1000] [--speedup=PCT] [--tick-spin=US] [--tick-policy=catch-up|drop]"
+              << " [--flight-log=FILE] [--log=FILE]" << std::endl;
+}
+
+void runNetplay(const Options &options) {
+    NetLink link;
+    NetConfig config;
+    config.rows = LINES - 1;
+    config.cols = COLS;
+    config.level = options.level;
+    config.seed = std::random_device()();
+
+    attron(COLOR_PAIR(COLOR_SCORE) | A_BOLD);
+    if (options.host) {
+        mvprintw(LINES / 2, COLS / 2 - 18, "Waiting for opponent on port %d...", options.port);
+    } else {
+        mvprintw(LINES / 2, COLS / 2 - 18, "Connecting to %s:%d...", options.peer.c_str(), options.port);
+    }
+    attroff(COLOR_PAIR(COLOR_SCORE) | A_BOLD);
+    refresh();
+
+    bool ready = options.host
+        ? link.listen(options.port) && netHostHandshake(link, config, interruptFlag)
+        : link.connect(options.peer.c_str(), options.port) && netJoinHandshake(link, config, interruptFlag);
+    if (!ready) return;
+
+    Backend::fullClear();
+    NetGame game(link, options.host ? 0 : 1, config);
+
+    while (!interruptFlag && !game.isGameOver());
+
+    while (!interruptFlag && getch() == ERR) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+}
+
+void showMenu(const Options &options) {
     Menu menu;
     Highscore highscore;
+    GameArena arena(Game::arenaBytes(LINES, COLS));
     
     nodelay(stdscr, FALSE);  // Enable blocking for menu navigation
     
@@ -64,10 +247,10 @@ void showMenu() {
         
         switch (choice) {
             case 0: // Start Game
-                full_clear_screen();       // Restart terminal for game
+                Backend::fullClear();       // Restart terminal for game
                 nodelay(stdscr, TRUE);     // Disable blocking for game
                 
-                while (runGame(menu.getDifficultyLevel())) {
+                while (runGame(menu.getDifficultyLevel(), arena, options.tick)) {
                     // Reload highscore for next game
                     highscore = Highscore();
                 }
@@ -77,13 +260,23 @@ void showMenu() {
                 highscore = Highscore();
                 break;
                 
-            case 1: // Settings
+            case 1: // Multiplayer
+                Backend::fullClear();
+                nodelay(stdscr, TRUE);
+
+                while (runMultiplayer(menu.getPlayerCount(), menu.getDifficultyLevel(), options.replayDir, options.tick)) {
+                }
+
+                nodelay(stdscr, FALSE);
+                break;
+
+            case 2: // Settings
                 while (!menu.showSettings() && !interruptFlag) {
                     // Stay in settings until user presses 'q'
                 }
                 break;
                 
-            case 2: // Exit
+            case 3: // Exit
                 running = false;
                 break;
                 
@@ -94,13 +287,129 @@ void showMenu() {
     }
 }
 
-int main()
+int main(int argc, char **argv)
 {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    if (!options.trace.empty()) {
+        trace_start();
+        trace_set_thread_name("game");
+    }
+
+    // Counters follow the thread that opens them: the game thread
+    PerfCounters counters;
+    if (options.perfCounters && counters.open()) {
+        g_perf_counters = &counters;
+    }
+
+    // Key-to-screen stages, reported on exit
+    InputLatency inputLatency;
+    if (options.inputLatency) {
+        g_input_latency = &inputLatency;
+    }
+
+    // Written by a background thread: the terminal stays the game's
+    Logger logger;
+    if (!options.log.empty()) {
+        if (!logger.open(options.log.c_str())) {
+            std::cerr << "Cannot open log " << options.log << std::endl;
+            return 1;
+        }
+        g_logger = &logger;
+    }
+
+    // Reports go to stdout at exit; kill -USR1 appends one to FILE, or to
+    // stderr when it is redirected, never to the terminal the game draws on
+    TickStats tickStats;
+    FILE *tickStatsFile = nullptr;
+    if (options.tickStats) {
+        if (!options.tickStatsFile.empty()) {
+            tickStatsFile = fopen(options.tickStatsFile.c_str(), "ae");
+            if (tickStatsFile == nullptr) {
+                std::cerr << "Cannot open tick stats file " << options.tickStatsFile << std::endl;
+                return 1;
+            }
+            g_tick_stats_out = tickStatsFile;
+        } else if (!isatty(STDERR_FILENO)) {
+            g_tick_stats_out = stderr;
+        }
+        g_tick_stats = &tickStats;
+        signal(SIGUSR1, tick_stats_request);
+    }
+
+#if BACKEND_FRAME_HOOKS
+    // Spectators watch everything this process draws
+    Broadcaster spectators;
+    if (!options.spectate.empty() && !(spectators.open(options.spectate.c_str()) && spectators.attach())) {
+        std::cerr << "Cannot open spectator socket " << options.spectate << std::endl;
+        return 1;
+    }
+#endif
+
     setupGame();
     signal(SIGINT, interruptFunction);
 
-    showMenu();
+    // The last ticks are always kept; SIGUSR2, a crash or an odd death writes them out
+    static FlightRecorder flight;
+    bool freshFlightLog = options.flightLog.empty();
+    if (freshFlightLog) options.flightLog = flight_default_path();
+    flight_install(&flight, options.flightLog.c_str(), &Backend::emergencyStop, freshFlightLog);
 
-    endwin();
+#if BACKEND_FRAME_HOOKS
+    // The cast header needs the terminal size, so this comes after setup
+    Recorder recorder;
+    if (!options.record.empty() && !(recorder.open(options.record.c_str(), COLS, LINES) && recorder.attach())) {
+        endwin();
+        std::cerr << "Cannot record to " << options.record << std::endl;
+        return 1;
+    }
+#endif
+
+    if (options.host || options.join) {
+        runNetplay(options);
+    } else {
+        showMenu(options);
+    }
+
+#if BACKEND_FRAME_HOOKS
+    recorder.stop();
+    spectators.stop();
+#endif
+    Backend::stop();
+
+    if (!options.log.empty()) {
+        LOG_INFO("log_close", "interrupted", interruptFlag);
+        g_logger = nullptr;
+        logger.stop();
+    }
+    if (options.perfCounters) {
+        g_perf_counters = nullptr;
+        counters.report(stdout);
+    }
+    if (options.tickStats) {
+        g_tick_stats = nullptr;
+        g_tick_stats_out = nullptr;
+        if (tickStatsFile != nullptr) fclose(tickStatsFile);
+        tickStats.report(stdout);
+    }
+    if (options.inputLatency) {
+        g_input_latency = nullptr;
+        inputLatency.report(stdout);
+    }
+#ifdef TSNAKE_ALLOC_STATS
+    alloc_report(stdout);
+#endif
+
+    if (!options.trace.empty()) {
+        trace_stop();
+        if (!trace_write(options.trace.c_str())) {
+            std::cerr << "Cannot write trace to " << options.trace << std::endl;
+            return 1;
+        }
+    }
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,130 @@
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <sys/resource.h>
+#include "./libs/terminal.hpp"
+#include "./libs/server.hpp"
+
+// Headless match server: one epoll shard per core, each hosting its own matches
+
+std::atomic<bool> running(true);
+
+void stopFunction(int /* sig */) {
+    running = false;
+}
+
+void usage(const char *name) {
+    printf("Usage: %s [--port=7878] [--shards=N] [--matches=N] [--clients=N]\n", name);
+    printf("          [--seats=2] [--rows=24] [--cols=80] [--level=2] [--tick=%d]\n", DELAY);
+}
+
+void raiseFileLimit() {
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+
+void report(std::vector<Shard *> &shards, double seconds) {
+    for (size_t i = 0; i < shards.size(); i++) {
+        ShardStats &s = shards[i]->stats;
+        printf("shard %2d: clients %6d matches %6d ticks %7lu missed %5lu late %5lu max-tick %7.2fms out %8.1fKB/s dropped %lu\n",
+               shards[i]->getId(), s.clients.load(), s.matches.load(), s.ticks.load(),
+               s.missedTicks.load(), s.lateTicks.load(), s.maxTickUs.load() / 1000.0,
+               s.bytesOut.exchange(0) / 1024.0 / seconds, s.dropped.load());
+    }
+    fflush(stdout);
+}
+
+int main(int argc, char **argv) {
+
+    ServerConfig config;
+    config.shards = static_cast<int>(std::thread::hardware_concurrency());
+    int clients = 0;
+    int matches = 0;
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        if (std::strncmp(arg, "--port=", 7) == 0) config.port = std::atoi(arg + 7);
+        else if (std::strncmp(arg, "--shards=", 9) == 0) config.shards = std::atoi(arg + 9);
+        else if (std::strncmp(arg, "--matches=", 10) == 0) matches = std::atoi(arg + 10);
+        else if (std::strncmp(arg, "--clients=", 10) == 0) clients = std::atoi(arg + 10);
+        else if (std::strncmp(arg, "--seats=", 8) == 0) config.seats = std::atoi(arg + 8);
+        else if (std::strncmp(arg, "--rows=", 7) == 0) config.rows = std::atoi(arg + 7);
+        else if (std::strncmp(arg, "--cols=", 7) == 0) config.cols = std::atoi(arg + 7);
+        else if (std::strncmp(arg, "--level=", 8) == 0) config.level = std::atoi(arg + 8);
+        else if (std::strncmp(arg, "--tick=", 7) == 0) config.tickMs = std::atoi(arg + 7);
+        else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (config.shards < 1) config.shards = 1;
+    if (config.seats < 1 || config.seats > 4 || config.rows < 8 || config.cols < 16 || config.tickMs < 1) {
+        usage(argv[0]);
+        return 1;
+    }
+    if (!boardFitsFrames(config.rows, config.cols)) {
+        fprintf(stderr, "%dx%d boards are too large: a keyframe would not fit a %d byte frame\n",
+                config.rows, config.cols, FRAME_MAX_LENGTH);
+        return 1;
+    }
+
+    // Pools are sized per shard from the totals
+    if (clients > 0) config.clientsPerShard = (clients + config.shards - 1) / config.shards;
+    else config.clientsPerShard = 16384 / config.shards;
+    config.matchesPerShard = matches > 0 ? (matches + config.shards - 1) / config.shards
+                                         : (config.clientsPerShard + config.seats - 1) / config.seats;
+
+    raiseFileLimit();
+    signal(SIGINT, stopFunction);
+    signal(SIGTERM, stopFunction);
+    signal(SIGPIPE, SIG_IGN);
+
+    std::vector<Shard *> shards;
+    for (int i = 0; i < config.shards; i++) {
+        Shard *shard = new Shard(config, i);
+        if (!shard->open()) {
+            fprintf(stderr, "shard %d: cannot listen on port %d: %s\n", i, config.port, strerror(errno));
+            return 1;
+        }
+        shards.push_back(shard);
+    }
+
+    printf("tsnake-server: port %d, %d shards, %d clients and %d matches per shard, %dx%d boards, %dms ticks\n",
+           config.port, config.shards, config.clientsPerShard, config.matchesPerShard,
+           config.rows, config.cols, config.tickMs);
+    fflush(stdout);
+
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < shards.size(); i++) {
+        threads.push_back(std::thread(&Shard::run, shards[i], std::cref(running)));
+    }
+
+    std::chrono::steady_clock::time_point last = std::chrono::steady_clock::now();
+    while (running) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        if (now - last >= std::chrono::seconds(5)) {
+            report(shards, std::chrono::duration<double>(now - last).count());
+            last = now;
+        }
+    }
+
+    for (size_t i = 0; i < threads.size(); i++) {
+        threads[i].join();
+    }
+    report(shards, std::chrono::duration<double>(std::chrono::steady_clock::now() - last).count());
+
+    for (size_t i = 0; i < shards.size(); i++) {
+        delete shards[i];
+    }
+    return 0;
+}
@@ -0,0 +1,203 @@
+#include "../libs/terminal.hpp"
+#include "../libs/common.hpp"
+#include "../libs/point.hpp"
+#include "../libs/food.hpp"
+#include "../libs/body.hpp"
+#include "../libs/board.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+// Renderer microbenchmarks: ns/op per operation, as text and JSON
+
+using namespace std::chrono;
+
+#define BENCH_LINES 40
+#define BENCH_COLS 120
+
+struct Result {
+    std::string name;
+    double median;      // ns/op
+    double min;
+    double stddevPct;   // of the repetitions, relative to the mean
+    unsigned long iterations;
+};
+
+// Keeps results alive so the compiler cannot drop the work
+static volatile unsigned long g_sink_value;
+
+/**
+ * Runs `op(i)` in batches: first grows the batch until it takes at least
+ * `minMs` (which doubles as warmup), then times `repetitions` batches of
+ * that size and keeps the median.
+ */
+template <typename Op>
+Result measure(const char *name, Op op, int repetitions, double minMs) {
+    unsigned long batch = 1;
+    for (;;) {
+        steady_clock::time_point start = steady_clock::now();
+        for (unsigned long i = 0; i < batch; i++) op(i);
+        double ms = duration<double, std::milli>(steady_clock::now() - start).count();
+        if (ms >= minMs || batch >= (1ul << 30)) break;
+        batch *= 2;
+    }
+
+    std::vector<double> samples;
+    for (int r = 0; r < repetitions; r++) {
+        steady_clock::time_point start = steady_clock::now();
+        for (unsigned long i = 0; i < batch; i++) op(i);
+        samples.push_back(duration<double, std::nano>(steady_clock::now() - start).count() / batch);
+    }
+    std::sort(samples.begin(), samples.end());
+
+    double mean = 0;
+    for (size_t i = 0; i < samples.size(); i++) mean += samples[i];
+    mean /= samples.size();
+    double variance = 0;
+    for (size_t i = 0; i < samples.size(); i++) variance += (samples[i] - mean) * (samples[i] - mean);
+
+    Result result;
+    result.name = name;
+    result.median = samples[samples.size() / 2];
+    result.min = samples[0];
+    result.stddevPct = mean > 0 ? 100.0 * std::sqrt(variance / samples.size()) / mean : 0;
+    result.iterations = batch * repetitions;
+    return result;
+}
+
+// Marks `count` cells as changed, spread over the screen
+static void touchCells(unsigned long i, int count) {
+    for (int c = 0; c < count; c++) {
+        int cell = static_cast<int>((i * 7919 + c * 104729) % (BENCH_LINES * BENCH_COLS));
+        mvaddch(cell / BENCH_COLS, cell % BENCH_COLS, (i + c) % 2 ? 'o' : 'O');
+    }
+}
+
+std::vector<Result> runAll(int repetitions, double minMs, const std::string &filter) {
+    std::vector<Result> results;
+    NullSink null;
+    set_render_sink(&null);
+    initscr(BENCH_LINES, BENCH_COLS);
+
+#define BENCH(name, body) \
+    if (filter.empty() || std::strstr(name, filter.c_str()) != nullptr) \
+        results.push_back(measure(name, [&](unsigned long i) { (void)i; body; }, repetitions, minMs))
+
+    BENCH("refresh_diff/idle", refresh_diff());
+    BENCH("refresh_diff/few", touchCells(i, 5); refresh_diff());
+    BENCH("refresh_diff/full", touchCells(i, BENCH_LINES * BENCH_COLS); refresh_diff());
+    BENCH("mvprintw/score", mvprintw(0, 2, " SCORE %d ", static_cast<int>(i)));
+    BENCH("apply_ansi_color", apply_ansi_color(static_cast<int>(i % 8), -1, (i & 1) ? A_BOLD : 0));
+    BENCH("clear", clear());
+    BENCH("full_clear_screen", full_clear_screen());
+
+    {
+        Board board;
+        Body body;
+        board.setPrintSnake(body);
+        Point probe(5, 7);
+        BENCH("Board::getChar", g_sink_value = g_sink_value + board.getChar(probe));
+
+        // Constant length: one head in, one tail out
+        BENCH("Body::push_pop", body.setHead(Point(5, static_cast<int>(i % 100))); body.removeTail());
+
+        Food food;
+        BENCH("Food::getFood", food.getFood(); g_sink_value = g_sink_value + food.getX());
+    }
+
+#undef BENCH
+
+    cleanup_screen();
+    set_render_sink(nullptr);
+    return results;
+}
+
+void writeJson(const std::vector<Result> &results, const char *path) {
+    std::ofstream out(path);
+    out << "{\n  \"lines\": " << BENCH_LINES << ", \"cols\": " << BENCH_COLS << ",\n  \"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        char line[256];
+        snprintf(line, sizeof(line),
+                 "    {\"name\": \"%s\", \"ns_per_op\": %.2f, \"min_ns\": %.2f, \"stddev_pct\": %.2f, \"iterations\": %lu}%s\n",
+                 results[i].name.c_str(), results[i].median, results[i].min, results[i].stddevPct,
+                 results[i].iterations, i + 1 < results.size() ? "," : "");
+        out << line;
+    }
+    out << "  ]\n}\n";
+}
+
+// Reads back the "name" and "ns_per_op" of a file written by writeJson()
+std::map<std::string, double> readJson(const char *path) {
+    std::map<std::string, double> values;
+    std::ifstream in(path);
+    std::string line;
+    while (std::getline(in, line)) {
+        char name[128];
+        double ns;
+        const char *entry = std::strstr(line.c_str(), "{\"name\": \"");
+        if (entry != nullptr && sscanf(entry, "{\"name\": \"%127[^\"]\", \"ns_per_op\": %lf", name, &ns) == 2) {
+            values[name] = ns;
+        }
+    }
+    return values;
+}
+
+void usage(const char *name) {
+    printf("Usage: %s [--filter=TEXT] [--repetitions=15] [--min-ms=20] [--json=FILE]\n", name);
+    printf("          [--baseline=FILE] [--threshold=PERCENT]\n");
+}
+
+int main(int argc, char **argv) {
+
+    int repetitions = 15;
+    double minMs = 20;
+    double threshold = 10;
+    std::string filter;
+    const char *json = nullptr;
+    const char *baseline = nullptr;
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        if (std::strncmp(arg, "--filter=", 9) == 0) filter = arg + 9;
+        else if (std::strncmp(arg, "--repetitions=", 14) == 0) repetitions = std::atoi(arg + 14);
+        else if (std::strncmp(arg, "--min-ms=", 9) == 0) minMs = std::atof(arg + 9);
+        else if (std::strncmp(arg, "--json=", 7) == 0) json = arg + 7;
+        else if (std::strncmp(arg, "--baseline=", 11) == 0) baseline = arg + 11;
+        else if (std::strncmp(arg, "--threshold=", 12) == 0) threshold = std::atof(arg + 12);
+        else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (repetitions < 1) repetitions = 1;
+
+    std::vector<Result> results = runAll(repetitions, minMs, filter);
+
+    std::map<std::string, double> base;
+    if (baseline != nullptr) base = readJson(baseline);
+
+    int slower = 0;
+    printf("%-20s %12s %12s %8s %12s\n", "benchmark", "ns/op", "min", "+-%", "vs baseline");
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result &r = results[i];
+        printf("%-20s %12.2f %12.2f %7.1f%%", r.name.c_str(), r.median, r.min, r.stddevPct);
+        std::map<std::string, double>::const_iterator it = base.find(r.name);
+        if (it != base.end() && it->second > 0) {
+            double change = 100.0 * (r.median - it->second) / it->second;
+            printf(" %+11.1f%%%s", change, change > threshold ? " slower" : "");
+            if (change > threshold) slower++;
+        }
+        printf("\n");
+    }
+
+    if (json != nullptr) writeJson(results, json);
+    if (slower > 0) printf("%d benchmark(s) more than %.0f%% slower than %s\n", slower, threshold, baseline);
+    return slower > 0 ? 1 : 0;
+}
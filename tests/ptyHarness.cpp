@@ -0,0 +1,334 @@
+#include <pty.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// End-to-end harness: runs tsnake under a pseudo-terminal with scripted keys
+
+using namespace std::chrono;
+
+typedef steady_clock::time_point Time;
+
+struct Options {
+    const char *binary;
+    int rows;
+    int cols;
+    int turns;
+    int turnMs;
+    int idleMs;
+    double maxCpu;
+
+    Options() : binary("../bin/tsnake"), rows(30), cols(100), turns(12), turnMs(400), idleMs(1000), maxCpu(0) {}
+};
+
+// Output, CPU and timing seen during one scripted phase
+struct Phase {
+    const char *name;
+    double seconds;
+    double cpuSeconds;
+    size_t bytes;
+    size_t reads;
+};
+
+class Child {
+
+    pid_t pid;
+    int master;
+    Time started;
+
+public:
+
+    Child() : pid(-1), master(-1) {}
+
+    bool start(const Options &options) {
+        struct winsize size;
+        std::memset(&size, 0, sizeof(size));
+        size.ws_row = static_cast<unsigned short>(options.rows);
+        size.ws_col = static_cast<unsigned short>(options.cols);
+
+        started = steady_clock::now();
+        pid = forkpty(&master, nullptr, nullptr, &size);
+        if (pid < 0) return false;
+        if (pid == 0) {
+            setenv("TERM", "xterm-256color", 1);
+            execl(options.binary, options.binary, static_cast<char *>(nullptr));
+            _exit(127);
+        }
+        return true;
+    }
+
+    void send(const char *keys) {
+        ssize_t written = write(master, keys, std::strlen(keys));
+        (void)written;
+    }
+
+    /**
+     * @brief Reads output until `deadline`, handing each chunk to `onChunk`
+     */
+    template <typename Handler>
+    size_t pump(Time deadline, Handler onChunk, size_t *reads = nullptr) {
+        size_t total = 0;
+        char buffer[65536];
+        for (;;) {
+            Time now = steady_clock::now();
+            if (now >= deadline) break;
+            struct pollfd fd = { master, POLLIN, 0 };
+            int wait = static_cast<int>(duration_cast<milliseconds>(deadline - now).count()) + 1;
+            if (poll(&fd, 1, wait) <= 0) continue;
+            ssize_t n = read(master, buffer, sizeof(buffer));
+            if (n <= 0) break;  // the child is gone
+            total += static_cast<size_t>(n);
+            if (reads) (*reads)++;
+            onChunk(steady_clock::now(), buffer, static_cast<size_t>(n));
+        }
+        return total;
+    }
+
+    // utime + stime of the running child, from /proc
+    double cpuSeconds() const {
+        char path[64];
+        snprintf(path, sizeof(path), "/proc/%d/stat", static_cast<int>(pid));
+        FILE *file = fopen(path, "r");
+        if (file == nullptr) return 0;
+        char line[1024];
+        size_t length = fread(line, 1, sizeof(line) - 1, file);
+        fclose(file);
+        line[length] = '\0';
+
+        // Fields after the ")" closing the command name: state is field 3
+        const char *p = std::strrchr(line, ')');
+        if (p == nullptr) return 0;
+        unsigned long utime = 0, stime = 0;
+        if (sscanf(p + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu", &utime, &stime) != 2) return 0;
+        return static_cast<double>(utime + stime) / sysconf(_SC_CLK_TCK);
+    }
+
+    /**
+     * @brief Waits for the child to exit, killing it after `graceMs`
+     */
+    bool finish(int graceMs, struct rusage &usage) {
+        int status = 0;
+        Time deadline = steady_clock::now() + milliseconds(graceMs);
+        char buffer[4096];
+        while (steady_clock::now() < deadline) {
+            if (wait4(pid, &status, WNOHANG, &usage) == pid) {
+                close(master);
+                return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+            }
+            // Keep draining so the child never blocks on a full pty
+            struct pollfd fd = { master, POLLIN, 0 };
+            if (poll(&fd, 1, 10) > 0 && read(master, buffer, sizeof(buffer)) <= 0) usleep(10000);
+        }
+        kill(pid, SIGKILL);
+        wait4(pid, &status, 0, &usage);
+        close(master);
+        return false;
+    }
+
+    Time getStarted() const { return started; }
+};
+
+/**
+ * Finds the snake heads drawn in a chunk of output: a cursor move followed
+ * (after any SGR sequences) by an 'O'. Rows and columns are 0-based.
+ */
+void findHeads(const char *bytes, size_t length, std::vector<std::pair<int, int> > &heads) {
+    for (size_t i = 0; i + 2 < length; i++) {
+        if (bytes[i] != '\x1b' || bytes[i + 1] != '[') continue;
+        int row = 0, col = 0;
+        size_t j = i + 2;
+        while (j < length && bytes[j] >= '0' && bytes[j] <= '9') row = row * 10 + (bytes[j++] - '0');
+        if (j >= length || bytes[j] != ';') continue;
+        j++;
+        while (j < length && bytes[j] >= '0' && bytes[j] <= '9') col = col * 10 + (bytes[j++] - '0');
+        if (j >= length || bytes[j] != 'H') continue;
+        j++;
+
+        // Skip "\x1b[...m" sequences
+        while (j + 1 < length && bytes[j] == '\x1b' && bytes[j + 1] == '[') {
+            j += 2;
+            while (j < length && bytes[j] != 'm') j++;
+            j++;
+        }
+        if (j < length && bytes[j] == 'O') heads.push_back(std::make_pair(row - 1, col - 1));
+        i = j > i ? j - 1 : i;
+    }
+}
+
+struct Stats {
+    double mean;
+    double stddev;
+    double p50;
+    double p99;
+    double max;
+};
+
+Stats summarize(std::vector<double> values) {
+    Stats stats = { 0, 0, 0, 0, 0 };
+    if (values.empty()) return stats;
+    std::sort(values.begin(), values.end());
+    double sum = 0;
+    for (size_t i = 0; i < values.size(); i++) sum += values[i];
+    stats.mean = sum / values.size();
+    for (size_t i = 0; i < values.size(); i++) stats.stddev += (values[i] - stats.mean) * (values[i] - stats.mean);
+    stats.stddev = std::sqrt(stats.stddev / values.size());
+    stats.p50 = values[values.size() / 2];
+    stats.p99 = values[std::min(values.size() - 1, values.size() * 99 / 100)];
+    stats.max = values.back();
+    return stats;
+}
+
+double millis(Time from, Time to) {
+    return duration<double, std::milli>(to - from).count();
+}
+
+void usage(const char *name) {
+    printf("Usage: %s [--rows=30] [--cols=100] [--turns=12] [--turn-ms=400] [--idle-ms=1000]\n", name);
+    printf("          [--max-cpu=PERCENT] [BINARY]\n");
+}
+
+int main(int argc, char **argv) {
+
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        if (std::strncmp(arg, "--rows=", 7) == 0) options.rows = std::atoi(arg + 7);
+        else if (std::strncmp(arg, "--cols=", 7) == 0) options.cols = std::atoi(arg + 7);
+        else if (std::strncmp(arg, "--turns=", 8) == 0) options.turns = std::atoi(arg + 8);
+        else if (std::strncmp(arg, "--turn-ms=", 10) == 0) options.turnMs = std::atoi(arg + 10);
+        else if (std::strncmp(arg, "--idle-ms=", 10) == 0) options.idleMs = std::atoi(arg + 10);
+        else if (std::strncmp(arg, "--max-cpu=", 10) == 0) options.maxCpu = std::atof(arg + 10);
+        else if (arg[0] != '-') options.binary = arg;
+        else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (access(options.binary, X_OK) != 0) {
+        fprintf(stderr, "cannot run %s (build it with make first)\n", options.binary);
+        return 1;
+    }
+
+    Child child;
+    if (!child.start(options)) {
+        perror("forkpty");
+        return 1;
+    }
+
+    std::vector<Phase> phases;
+    Time firstOutput;
+    bool sawOutput = false;
+    auto ignore = [](Time, const char *, size_t) {};
+
+    // Startup: time to the first byte, then the menu left alone
+    {
+        Phase phase = { "menu idle", 0, 0, 0, 0 };
+        Time deadline = steady_clock::now() + milliseconds(options.idleMs);
+        double cpu = child.cpuSeconds();
+        Time start = steady_clock::now();
+        phase.bytes = child.pump(deadline, [&](Time now, const char *, size_t) {
+            if (!sawOutput) {
+                firstOutput = now;
+                sawOutput = true;
+            }
+        }, &phase.reads);
+        phase.seconds = millis(start, steady_clock::now()) / 1000.0;
+        phase.cpuSeconds = child.cpuSeconds() - cpu;
+        phases.push_back(phase);
+    }
+
+    // Start a game and turn in a square: down, left, up, right, ...
+    static const char *keys[4] = { "\x1b[B", "\x1b[D", "\x1b[A", "\x1b[C" };
+    static const int deltas[4][2] = { { 1, 0 }, { 0, -1 }, { -1, 0 }, { 0, 1 } };
+
+    std::vector<double> latencies;
+    std::vector<double> intervals;
+    std::pair<int, int> head(-1, -1);
+    Time lastFrame;
+    bool haveFrame = false;
+    int pending = -1;      // turn waiting to show up on screen
+    Time pressed;
+
+    auto onGameChunk = [&](Time now, const char *bytes, size_t length) {
+        std::vector<std::pair<int, int> > heads;
+        findHeads(bytes, length, heads);
+        for (size_t i = 0; i < heads.size(); i++) {
+            if (haveFrame) intervals.push_back(millis(lastFrame, now));
+            lastFrame = now;
+            haveFrame = true;
+
+            if (pending >= 0 && head.first >= 0 &&
+                heads[i].first == head.first + deltas[pending][0] &&
+                heads[i].second == head.second + deltas[pending][1]) {
+                latencies.push_back(millis(pressed, now));
+                pending = -1;
+            }
+            head = heads[i];
+        }
+    };
+
+    {
+        Phase phase = { "game", 0, 0, 0, 0 };
+        double cpu = child.cpuSeconds();
+        Time start = steady_clock::now();
+        child.send("\r");
+        phase.bytes += child.pump(start + milliseconds(options.turnMs), onGameChunk, &phase.reads);
+
+        for (int turn = 0; turn < options.turns; turn++) {
+            pending = turn % 4;
+            pressed = steady_clock::now();
+            child.send(keys[pending]);
+            phase.bytes += child.pump(pressed + milliseconds(options.turnMs), onGameChunk, &phase.reads);
+        }
+        phase.seconds = millis(start, steady_clock::now()) / 1000.0;
+        phase.cpuSeconds = child.cpuSeconds() - cpu;
+        phases.push_back(phase);
+    }
+
+    // Ctrl+C goes through the pty line discipline as SIGINT
+    child.send("\x03");
+    Time quit = steady_clock::now();
+    child.pump(quit + milliseconds(200), ignore);
+    struct rusage usage;
+    std::memset(&usage, 0, sizeof(usage));
+    bool clean = child.finish(2000, usage);
+    double quitMs = millis(quit, steady_clock::now());
+
+    printf("tsnake under a %dx%d pty: %s\n", options.cols, options.rows, options.binary);
+    if (sawOutput) printf("startup: first output after %.1f ms\n", millis(child.getStarted(), firstOutput));
+    else printf("startup: no output\n");
+
+    bool busy = false;
+    for (size_t i = 0; i < phases.size(); i++) {
+        const Phase &phase = phases[i];
+        double cpu = phase.seconds > 0 ? 100.0 * phase.cpuSeconds / phase.seconds : 0;
+        printf("%-10s %.2fs, %.1f KB/s in %zu reads, child CPU %.0f%%\n", phase.name, phase.seconds,
+               phase.seconds > 0 ? phase.bytes / 1024.0 / phase.seconds : 0.0, phase.reads, cpu);
+        if (options.maxCpu > 0 && cpu > options.maxCpu) busy = true;
+    }
+
+    Stats latency = summarize(latencies);
+    Stats interval = summarize(intervals);
+    printf("keypress to screen: %zu/%d turns seen, mean %.1f ms, p50 %.1f, p99 %.1f, max %.1f\n",
+           latencies.size(), options.turns, latency.mean, latency.p50, latency.p99, latency.max);
+    printf("frame interval: %zu frames, mean %.1f ms, jitter (stddev) %.2f ms, p99 %.1f, max %.1f\n",
+           intervals.size() + (haveFrame ? 1 : 0), interval.mean, interval.stddev, interval.p99, interval.max);
+    printf("child total: %.2fs user, %.2fs system, max RSS %ld KB\n",
+           usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6,
+           usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6, usage.ru_maxrss);
+    printf("exit: %s after %.0f ms\n", clean ? "clean" : "killed or failed", quitMs);
+
+    if (busy) printf("FAIL: child CPU above %.0f%%, busy loop suspected\n", options.maxCpu);
+    if (static_cast<int>(latencies.size()) < options.turns) printf("FAIL: some turns never reached the screen\n");
+    return busy || !clean || static_cast<int>(latencies.size()) < options.turns ? 1 : 0;
+}
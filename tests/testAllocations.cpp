@@ -0,0 +1,223 @@
+#define CATCH_CONFIG_MAIN
+#define TSNAKE_ALLOC_STATS
+#include "catch.hpp"
+#include "../libs/terminal.hpp"
+#include "../libs/allocstats.hpp"
+#include "../libs/game.hpp"
+#include "../libs/gamearena.hpp"
+#include "../libs/menu.hpp"
+#include "../libs/matchview.hpp"
+
+// Steady-state gameplay must not touch the heap: every case warms up
+// first (buffers reach their working size), then counts.
+
+static void stdinAtEndOfFile() {
+    int fds[2];
+    REQUIRE(pipe(fds) == 0);
+    close(fds[1]);
+    dup2(fds[0], STDIN_FILENO);
+    close(fds[0]);
+}
+
+struct Screen {
+    NullSink sink;
+
+    Screen(int lines, int cols) {
+        set_render_sink(&sink);
+        initscr(lines, cols);
+    }
+
+    ~Screen() {
+        cleanup_screen();
+        set_render_sink(nullptr);
+    }
+};
+
+TEST_CASE("Allocations and their bytes are counted", "[alloc]") {
+    AllocCount before = alloc_count();
+    int *value = new int(7);
+    std::vector<char> bytes(1000);
+    AllocCount after = alloc_count();
+    delete value;
+
+    REQUIRE(after.allocations - before.allocations == 2);
+    REQUIRE(after.bytes - before.bytes >= sizeof(int) + 1000);
+}
+
+TEST_CASE("Scopes charge allocations to their phase", "[alloc]") {
+    alloc_reset_phases();
+    {
+        AllocScope scope(ALLOC_TICK);
+        std::string text(100, 'x');
+    }
+    {
+        AllocScope scope(ALLOC_TICK);
+    }
+    REQUIRE(alloc_phase(ALLOC_TICK).runs == 2);
+    REQUIRE(alloc_phase(ALLOC_TICK).allocations == 1);
+    REQUIRE(alloc_phase(ALLOC_TICK).worstRun == 1);
+    REQUIRE(alloc_phase(ALLOC_TICK).bytes >= 101);
+}
+
+TEST_CASE("Game ticks do not allocate", "[alloc]") {
+    Screen screen(25, 80);
+    stdinAtEndOfFile();
+    Game game(1);
+
+    // Two ticks to warm up, then ten counted ones heading right along row 5
+    alloc_reset_phases();
+    bool over = false;
+    while (alloc_phase(ALLOC_TICK).runs < 2 && !over) over = game.isGameOver();
+    alloc_reset_phases();
+    while (alloc_phase(ALLOC_TICK).runs < 10 && !over) over = game.isGameOver();
+
+    REQUIRE_FALSE(over);
+    REQUIRE(alloc_phase(ALLOC_TICK).allocations == 0);
+    REQUIRE(alloc_phase(ALLOC_REFRESH).allocations == 0);
+}
+
+TEST_CASE("Moving snakes do not allocate", "[alloc]") {
+    Body body(Point(10, 10), RIGHT, 5);
+    for (int i = 0; i < 16; i++) {
+        body.setHead(Point(10, 11 + i));
+        body.removeTail();
+    }
+
+    AllocCount before = alloc_count();
+    for (int i = 0; i < 10000; i++) {
+        body.setHead(Point(10, i % 50));
+        body.removeTail();
+    }
+    unsigned long allocations = alloc_count().allocations - before.allocations;
+    REQUIRE(allocations == 0);
+    REQUIRE(body.getSize() == 5);
+}
+
+TEST_CASE("Growing snakes only allocate when doubling", "[alloc]") {
+    Body body(Point(10, 10), RIGHT, 3);
+    AllocCount before = alloc_count();
+    for (int i = 0; i < 1000; i++) {
+        body.setHead(Point(10, i));
+    }
+    unsigned long allocations = alloc_count().allocations - before.allocations;
+
+    // 16 -> 32 -> ... -> 1024
+    REQUIRE(allocations == 6);
+    REQUIRE(body.getSize() == 1003);
+    REQUIRE(body.getTail().getY() == 8);
+}
+
+TEST_CASE("Match steps and redraws do not allocate", "[alloc]") {
+    Screen screen(25, 80);
+    Match match(24, 80, 1, 2, 7);
+    MatchView view(match);
+    view.drawBoard();
+    refresh();
+
+    // An 8x8 square, far from the walls; the first lap warms up
+    const int turns[4] = { DOWN, LEFT, UP, RIGHT };
+    AllocCount before = alloc_count();
+    for (int t = 0; t < 200; t++) {
+        if (t == 32) before = alloc_count();
+        if (t % 8 == 7) match.setDirection(0, turns[(t / 8) % 4]);
+        match.step();
+        view.drawDirty();
+        refresh();
+    }
+    unsigned long allocations = alloc_count().allocations - before.allocations;
+
+    REQUIRE_FALSE(match.isOver());
+    REQUIRE(allocations == 0);
+}
+
+TEST_CASE("Game over and menu frames do not allocate", "[alloc]") {
+    Screen screen(30, 80);
+    stdinAtEndOfFile();
+
+    Board board;
+    board.printGameOver();
+    board.update();
+    AllocCount before = alloc_count();
+    board.printGameOver();
+    board.update();
+    unsigned long allocations = alloc_count().allocations - before.allocations;
+    REQUIRE(allocations == 0);
+
+    Menu menu;
+    menu.showMainMenu(0);
+    menu.showMainMenu(0);
+    alloc_reset_phases();
+    for (int i = 0; i < 20; i++) menu.showMainMenu(42);
+    REQUIRE(alloc_phase(ALLOC_MENU).runs == 20);
+    REQUIRE(alloc_phase(ALLOC_MENU).allocations == 0);
+}
+
+// ============================================================================
+// GAME ARENA
+// ============================================================================
+
+static std::vector<int> g_destroyed;
+
+struct Tracked {
+    int id;
+    explicit Tracked(int id) : id(id) {}
+    ~Tracked() { g_destroyed.push_back(id); }
+};
+
+TEST_CASE("Arena rewinds destroy newest first and reuse the space", "[arena]") {
+    GameArena arena(1024);
+    g_destroyed.clear();
+
+    arena.make<Tracked>(1);
+    GameArena::Mark mark = arena.mark();
+    Tracked *second = arena.make<Tracked>(2);
+    double *aligned = arena.makeArray<double>(3);
+    arena.make<Tracked>(3);
+    size_t used = arena.getUsed();
+
+    REQUIRE(reinterpret_cast<size_t>(aligned) % alignof(double) == 0);
+    arena.rewind(mark);
+    REQUIRE(g_destroyed == std::vector<int>({ 3, 2 }));
+    REQUIRE(arena.getUsed() == mark.used);
+
+    // Same objects again land in the same place
+    REQUIRE(arena.make<Tracked>(4) == second);
+    arena.makeArray<double>(3);
+    arena.make<Tracked>(5);
+    REQUIRE(arena.getUsed() == used);
+
+    arena.rewind(GameArena::Mark());
+    REQUIRE(g_destroyed == std::vector<int>({ 3, 2, 5, 4, 1 }));
+    REQUIRE(arena.getUsed() == 0);
+}
+
+TEST_CASE("A full arena throws bad_alloc", "[arena]") {
+    GameArena arena(64);
+    arena.makeArray<char>(40);
+    REQUIRE_THROWS_AS(arena.makeArray<char>(40), const std::bad_alloc &);
+    REQUIRE(arena.getUsed() == 40);
+}
+
+TEST_CASE("Game restarts come from the arena without the heap", "[arena]") {
+    Screen screen(25, 80);
+    stdinAtEndOfFile();
+    GameArena arena(Game::arenaBytes(25, 80));
+
+    // What runGame() does per round, the first one warming up
+    GameArena::Mark start = arena.mark();
+    arena.make<Game>(1, arena);
+    size_t used = arena.getUsed();
+    arena.rewind(start);
+
+    AllocCount before = alloc_count();
+    for (int round = 0; round < 5; round++) {
+        Game *game = arena.make<Game>(1, arena);
+        game->reset();
+        arena.rewind(start);
+    }
+    unsigned long allocations = alloc_count().allocations - before.allocations;
+
+    REQUIRE(allocations == 0);
+    REQUIRE(used <= arena.getCapacity());
+    REQUIRE(arena.getUsed() == 0);
+}
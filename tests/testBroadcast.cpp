@@ -0,0 +1,174 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+#include "../libs/terminal.hpp"
+#include "../libs/broadcast.hpp"
+#include <chrono>
+#include <string>
+#include <thread>
+
+static std::string socketSpec() {
+    return "unix:/tmp/tsnake-test-" + std::to_string(getpid()) + ".sock";
+}
+
+static int connectViewer(const std::string &spec) {
+    sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    std::strcpy(addr.sun_path, spec.c_str() + 5);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    REQUIRE(connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) == 0);
+    return fd;
+}
+
+static bool waitFor(bool (*done)(const Broadcaster &), const Broadcaster &b) {
+    for (int i = 0; i < 500 && !done(b); i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    return done(b);
+}
+
+static bool keyframeWanted(const Broadcaster &b) { return b.isKeyframeWanted(); }
+
+// Reads until `size` bytes arrived or nothing comes for a while
+static std::string readBytes(int fd, size_t size) {
+    std::string data;
+    timeval wait = { 1, 0 };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &wait, sizeof(wait));
+    char buffer[4096];
+    while (data.size() < size) {
+        ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+        if (n <= 0) break;
+        data.append(buffer, n);
+    }
+    return data;
+}
+
+TEST_CASE("Broadcaster starts viewers with a keyframe, then deltas", "[broadcast]") {
+    MemorySink screen;
+    set_render_sink(&screen);
+    initscr(24, 80);
+    mvaddch(1, 1, 'X');
+    refresh();
+
+    Broadcaster b;
+    std::string spec = socketSpec();
+    REQUIRE(b.open(spec.c_str()));
+
+    // Deltas sent before anyone watches are not queued
+    b.frame("early", 5);
+
+    int viewer = connectViewer(spec);
+    REQUIRE(waitFor(keyframeWanted, b));
+
+    std::string keyframe;
+    encode_keyframe(keyframe);
+    b.frame("skipped", 7);
+    b.keyframe();
+    b.frame("delta-1", 7);
+    b.frame("delta-2", 7);
+
+    std::string received = readBytes(viewer, keyframe.size() + 14);
+    REQUIRE(received == keyframe + "delta-1delta-2");
+    REQUIRE(received.compare(0, 4, ANSI_CLEAR_SCREEN) == 0);
+    REQUIRE(received.find("X") != std::string::npos);
+
+    close(viewer);
+    b.stop();
+    cleanup_screen();
+    set_render_sink(nullptr);
+}
+
+TEST_CASE("Broadcaster sends a new viewer's keyframe to that viewer only", "[broadcast]") {
+    MemorySink screen;
+    set_render_sink(&screen);
+    initscr(24, 80);
+    mvaddch(1, 1, 'X');
+    refresh();
+
+    Broadcaster b;
+    std::string spec = socketSpec();
+    REQUIRE(b.open(spec.c_str()));
+
+    int early = connectViewer(spec);
+    REQUIRE(waitFor(keyframeWanted, b));
+    std::string first;
+    encode_keyframe(first);
+    b.keyframe();
+    b.frame("delta-1", 7);
+
+    int late = connectViewer(spec);
+    REQUIRE(waitFor(keyframeWanted, b));
+    mvaddch(2, 2, 'Y');
+    refresh();
+    std::string second;
+    encode_keyframe(second);
+    b.keyframe();
+    b.frame("delta-2", 7);
+
+    REQUIRE(readBytes(early, first.size() + 14) == first + "delta-1delta-2");
+    REQUIRE(readBytes(late, second.size() + 7) == second + "delta-2");
+
+    close(early);
+    close(late);
+    b.stop();
+    cleanup_screen();
+    set_render_sink(nullptr);
+}
+
+TEST_CASE("Broadcaster fans one frame out to many viewers", "[broadcast]") {
+    Broadcaster b;
+    std::string spec = socketSpec();
+    REQUIRE(b.open(spec.c_str()));
+
+    const int viewerCount = 100;
+    std::vector<int> viewers;
+    for (int i = 0; i < viewerCount; i++) {
+        viewers.push_back(connectViewer(spec));
+    }
+    for (int i = 0; i < 500 && b.getViewers() < viewerCount; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    REQUIRE(b.getViewers() == viewerCount);
+
+    std::string expected;
+    encode_keyframe(expected);
+    b.keyframe();
+    for (int f = 0; f < 50; f++) {
+        std::string frame = "frame " + std::to_string(f) + ";";
+        b.frame(frame.data(), frame.size());
+        expected += frame;
+    }
+
+    for (int i = 0; i < viewerCount; i++) {
+        std::string received = readBytes(viewers[i], expected.size());
+        REQUIRE(received == expected);
+        close(viewers[i]);
+    }
+}
+
+TEST_CASE("Broadcaster drops a stalled viewer back to keyframes", "[broadcast]") {
+    Broadcaster b;
+    std::string spec = socketSpec();
+    REQUIRE(b.open(spec.c_str()));
+
+    int slow = connectViewer(spec);
+    REQUIRE(waitFor(keyframeWanted, b));
+    b.keyframe();
+
+    // The viewer never reads, so the socket and then its queue fill up
+    std::string big(32 * 1024, '.');
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int f = 0; f < 200 && b.getDrops() == 0; f++) {
+        b.frame(big.data(), big.size());
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    REQUIRE(b.getDrops() > 0);
+    REQUIRE(b.isKeyframeWanted());
+    REQUIRE(b.getViewers() == 1);
+    REQUIRE(seconds < 2.0);
+
+    close(slow);
+}
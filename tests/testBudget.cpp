@@ -0,0 +1,254 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+#include "../libs/terminal.hpp"
+#include "../libs/matchview.hpp"
+#include "../libs/menu.hpp"
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+
+// Output byte budgets of scripted scenarios, kept in budgets.txt.
+// After an intended change, TSNAKE_UPDATE_BUDGETS=1 ./test_budget stores
+// the new numbers instead of checking them.
+
+#define BUDGET_FILE "budgets.txt"
+#define BUDGET_MARGIN 0.10
+
+struct Usage {
+    size_t frames;
+    size_t bytes;
+    size_t writes;          // write() calls reaching the sink, ~ syscalls
+    size_t maxFrameBytes;
+    size_t maxFrameWrites;
+
+    Usage() : frames(0), bytes(0), writes(0), maxFrameBytes(0), maxFrameWrites(0) {}
+};
+
+class CountingSink : public RenderSink {
+public:
+    size_t bytes;
+    size_t writes;
+
+    CountingSink() : bytes(0), writes(0) {}
+
+    void write(const char *, size_t length) {
+        bytes += length;
+        writes++;
+    }
+};
+
+// Everything written since the previous frame() counts toward that frame
+struct BudgetScreen {
+    CountingSink sink;
+    Usage usage;
+    size_t lastBytes;
+    size_t lastWrites;
+
+    BudgetScreen(int lines, int cols) : lastBytes(0), lastWrites(0) {
+        set_render_sink(&sink);
+        initscr(lines, cols);
+        lastBytes = sink.bytes;
+        lastWrites = sink.writes;
+    }
+
+    ~BudgetScreen() {
+        cleanup_screen();
+        set_render_sink(nullptr);
+    }
+
+    void frame() {
+        size_t bytes = sink.bytes - lastBytes;
+        size_t writes = sink.writes - lastWrites;
+        lastBytes = sink.bytes;
+        lastWrites = sink.writes;
+
+        usage.frames++;
+        usage.bytes += bytes;
+        usage.writes += writes;
+        if (bytes > usage.maxFrameBytes) usage.maxFrameBytes = bytes;
+        if (writes > usage.maxFrameWrites) usage.maxFrameWrites = writes;
+    }
+
+    void refreshFrame() {
+        refresh();
+        frame();
+    }
+};
+
+static std::map<std::string, Usage> loadBudgets() {
+    std::map<std::string, Usage> budgets;
+    std::ifstream file(BUDGET_FILE);
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream fields(line);
+        std::string name;
+        Usage usage;
+        if (fields >> name >> usage.frames >> usage.bytes >> usage.writes >> usage.maxFrameBytes >> usage.maxFrameWrites) {
+            budgets[name] = usage;
+        }
+    }
+    return budgets;
+}
+
+static void saveBudgets(const std::map<std::string, Usage> &budgets) {
+    std::ofstream file(BUDGET_FILE);
+    file << "# scenario frames bytes writes max-frame-bytes max-frame-writes\n";
+    for (std::map<std::string, Usage>::const_iterator it = budgets.begin(); it != budgets.end(); ++it) {
+        const Usage &u = it->second;
+        file << it->first << ' ' << u.frames << ' ' << u.bytes << ' ' << u.writes << ' '
+             << u.maxFrameBytes << ' ' << u.maxFrameWrites << '\n';
+    }
+}
+
+static bool withinBudget(size_t measured, size_t budget) {
+    return measured <= budget + static_cast<size_t>(budget * BUDGET_MARGIN);
+}
+
+static void checkBudget(const std::string &name, const Usage &usage) {
+    std::map<std::string, Usage> budgets = loadBudgets();
+    const char *update = std::getenv("TSNAKE_UPDATE_BUDGETS");
+    if (update != nullptr && *update && *update != '0') {
+        budgets[name] = usage;
+        saveBudgets(budgets);
+        return;
+    }
+
+    INFO("scenario " << name << ": " << usage.frames << " frames, " << usage.bytes << " bytes, "
+         << usage.writes << " writes, max " << usage.maxFrameBytes << " bytes / "
+         << usage.maxFrameWrites << " writes per frame");
+    REQUIRE(budgets.count(name) == 1);
+    const Usage &budget = budgets[name];
+    REQUIRE(usage.frames == budget.frames);
+    REQUIRE(withinBudget(usage.bytes, budget.bytes));
+    REQUIRE(withinBudget(usage.writes, budget.writes));
+    REQUIRE(withinBudget(usage.maxFrameBytes, budget.maxFrameBytes));
+    REQUIRE(withinBudget(usage.maxFrameWrites, budget.maxFrameWrites));
+}
+
+// Menu input comes from a pipe holding `keys`, then end of file
+static void feedStdin(const std::string &keys) {
+    int fds[2];
+    REQUIRE(pipe(fds) == 0);
+    REQUIRE(write(fds[1], keys.data(), keys.size()) == static_cast<ssize_t>(keys.size()));
+    close(fds[1]);
+    dup2(fds[0], STDIN_FILENO);
+    close(fds[0]);
+}
+
+// Next direction toward the closest food, never reversing
+static int towardFood(const Match &match, int player) {
+    Point head = match.getSnake(player).getHead();
+    const std::vector<Point> &foods = match.getFoods();
+    if (foods.empty()) return ERR;
+    Point target = foods[0];
+    int best = -1;
+    for (size_t i = 0; i < foods.size(); i++) {
+        int distance = std::abs(foods[i].getX() - head.getX()) + std::abs(foods[i].getY() - head.getY());
+        if (best < 0 || distance < best) {
+            best = distance;
+            target = foods[i];
+        }
+    }
+    int current = match.getSnake(player).getDirection();
+    if (target.getX() < head.getX() && current != DOWN) return UP;
+    if (target.getX() > head.getX() && current != UP) return DOWN;
+    if (target.getY() < head.getY() && current != RIGHT) return LEFT;
+    if (target.getY() > head.getY() && current != LEFT) return RIGHT;
+    return current == UP || current == DOWN ? RIGHT : DOWN;
+}
+
+TEST_CASE("Steady movement stays within its byte budget", "[budget]") {
+    BudgetScreen screen(25, 80);
+    Match match(24, 80, 1, 2, 7);
+    MatchView view(match);
+    view.drawBoard();
+    screen.refreshFrame();
+    screen.usage = Usage();  // only the moves count
+
+    // An 8x8 square, far from the walls
+    const int turns[4] = { DOWN, LEFT, UP, RIGHT };
+    for (int t = 0; t < 200 && !match.isOver(); t++) {
+        if (t % 8 == 7) match.setDirection(0, turns[(t / 8) % 4]);
+        match.step();
+        view.drawDirty();
+        screen.refreshFrame();
+    }
+    REQUIRE_FALSE(match.isOver());
+    checkBudget("steady", screen.usage);
+}
+
+TEST_CASE("Eating stays within its byte budget", "[budget]") {
+    BudgetScreen screen(25, 80);
+    Match match(24, 80, 1, 2, 11);
+    MatchView view(match);
+    view.drawBoard();
+    screen.refreshFrame();
+    screen.usage = Usage();
+
+    for (int t = 0; t < 300 && !match.isOver(); t++) {
+        match.setDirection(0, towardFood(match, 0));
+        match.step();
+        view.drawDirty();
+        screen.refreshFrame();
+    }
+    REQUIRE(match.getScore(0) > 0);
+    checkBudget("eating", screen.usage);
+}
+
+TEST_CASE("Game over overlays stay within their byte budget", "[budget]") {
+    BudgetScreen screen(25, 80);
+    Match match(24, 80, 2, 2, 5);
+    MatchView view(match);
+    view.drawBoard();
+    screen.refreshFrame();
+
+    // Both snakes run into the side walls
+    while (!match.isOver()) {
+        match.step();
+        view.drawDirty();
+        screen.refreshFrame();
+    }
+    view.printGameOver("Play again? (y/n)");
+    screen.refreshFrame();
+
+    // The single player overlay on top of a fresh board
+    Board board;
+    screen.refreshFrame();
+    board.printGameOver();
+    screen.refreshFrame();
+    checkBudget("gameover", screen.usage);
+}
+
+TEST_CASE("Menu animation stays within its byte budget", "[budget]") {
+    BudgetScreen screen(30, 80);
+    Menu menu;
+
+    // A few moves, then frames with no key at all
+    feedStdin("\x1b[B\x1b[B\x1b[A");
+    for (int i = 0; i < 20; i++) {
+        menu.showMainMenu(42);
+        screen.frame();
+    }
+    checkBudget("menu", screen.usage);
+}
+
+TEST_CASE("Full clears stay within their byte budget", "[budget]") {
+    BudgetScreen screen(25, 80);
+    Match match(24, 80, 2, 1, 3);
+    MatchView view(match);
+
+    for (int i = 0; i < 5; i++) {
+        // What a new game does: wipe the terminal and redraw everything
+        full_clear_screen();
+        view.drawBoard();
+        screen.refreshFrame();
+
+        full_clear_screen();
+        Board board;
+        screen.refreshFrame();
+    }
+    checkBudget("fullclear", screen.usage);
+}
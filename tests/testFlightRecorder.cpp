@@ -0,0 +1,282 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+#include "../libs/terminal.hpp"
+#include "../libs/game.hpp"
+#include "../libs/flightrecorder.hpp"
+#include <sys/wait.h>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+static std::string logPath(const char *name) {
+    return "/tmp/tsnake-flight-" + std::string(name) + "-" + std::to_string(getpid()) + ".log";
+}
+
+static std::string readFile(const std::string &path) {
+    std::ifstream file(path.c_str());
+    std::stringstream text;
+    text << file.rdbuf();
+    return text.str();
+}
+
+static int countLines(const std::string &text, const char *prefix) {
+    int count = 0;
+    std::istringstream lines(text);
+    std::string line;
+    while (std::getline(lines, line)) {
+        if (line.compare(0, std::strlen(prefix), prefix) == 0) count++;
+    }
+    return count;
+}
+
+// No key waiting: getch() reads end of file
+static void stdinAtEndOfFile() {
+    int fds[2];
+    REQUIRE(pipe(fds) == 0);
+    close(fds[1]);
+    dup2(fds[0], STDIN_FILENO);
+    close(fds[0]);
+}
+
+TEST_CASE("The ring keeps the newest ticks, oldest first", "[flight]") {
+    static FlightRecorder recorder;
+    recorder.clear();
+    for (unsigned int i = 0; i < FlightRecorder::CAPACITY + 476; i++) {
+        recorder.slot().tick = i;
+        recorder.commit();
+    }
+
+    REQUIRE(recorder.getCount() == FlightRecorder::CAPACITY + 476);
+    REQUIRE(recorder.size() == FlightRecorder::CAPACITY);
+    REQUIRE(recorder.at(0).tick == 476);
+    REQUIRE(recorder.at(FlightRecorder::CAPACITY - 1).tick == FlightRecorder::CAPACITY + 475);
+}
+
+TEST_CASE("Dumps are text with one line per tick", "[flight]") {
+    static FlightRecorder recorder;
+    recorder.clear();
+    FlightRecord &r = recorder.slot();
+    r.tick = 7;
+    r.key = -1;
+    r.direction = LEFT;
+    r.event = FLIGHT_EAT;
+    r.headX = 5;
+    r.headY = 12;
+    r.foodX = 5;
+    r.foodY = 12;
+    r.score = 40;
+    r.length = 9;
+    r.lateUs = 120;
+    r.tickUs = 35;
+    r.bytes = 211;
+    r.startNs = -9000000000LL;
+    recorder.commit();
+
+    std::string path = logPath("format");
+    std::remove(path.c_str());
+    REQUIRE(recorder.dump(path.c_str(), "first"));
+    REQUIRE(recorder.dump(path.c_str(), "second"));
+
+    std::string text = readFile(path);
+    REQUIRE(countLines(text, "# tsnake flight recorder: ") == 2);
+    REQUIRE(text.find("# tsnake flight recorder: first\n# last 1 of 1 ticks") == 0);
+    REQUIRE(text.find("\n7 -1 L eat 5,12 5,12 40 9 120 35 211 -9000000000\n") != std::string::npos);
+    std::remove(path.c_str());
+}
+
+TEST_CASE("Dumps refuse symbolic links and fresh paths that already exist", "[flight]") {
+    FlightRecorder recorder;
+    recorder.clear();
+    recorder.slot().tick = 1;
+    recorder.commit();
+
+    std::string target = logPath("target");
+    std::string link = logPath("link");
+    std::remove(link.c_str());
+    { std::ofstream file(target.c_str()); file << "keep\n"; }
+    REQUIRE(symlink(target.c_str(), link.c_str()) == 0);
+    REQUIRE_FALSE(recorder.dump(link.c_str(), "planted"));
+    REQUIRE(readFile(target) == "keep\n");
+
+    // A fresh path is only ever created, never appended to
+    REQUIRE_FALSE(recorder.dump(target.c_str(), "fresh", true));
+    REQUIRE(readFile(target) == "keep\n");
+    std::remove(target.c_str());
+    REQUIRE(recorder.dump(target.c_str(), "fresh", true));
+    struct stat info;
+    REQUIRE(stat(target.c_str(), &info) == 0);
+    REQUIRE((info.st_mode & 0777) == 0600);
+
+    std::remove(link.c_str());
+    std::remove(target.c_str());
+}
+
+TEST_CASE("The default dump file is under the player's state directory", "[flight]") {
+    std::string state = "/tmp/tsnake-state-" + std::to_string(getpid());
+    setenv("XDG_STATE_HOME", state.c_str(), 1);
+    std::string path = flight_default_path();
+    REQUIRE(path == state + "/tsnake/flight-" + std::to_string(getpid()) + ".log");
+
+    struct stat info;
+    REQUIRE(stat((state + "/tsnake").c_str(), &info) == 0);
+    REQUIRE(S_ISDIR(info.st_mode));
+    REQUIRE((info.st_mode & 0777) == 0700);
+
+    // Relative or missing: fall back to $HOME
+    const char *home = std::getenv("HOME");
+    std::string savedHome = home != nullptr ? home : "";
+    setenv("XDG_STATE_HOME", "relative", 1);
+    setenv("HOME", state.c_str(), 1);
+    REQUIRE(flight_default_path() == state + "/.local/state/tsnake/flight-" + std::to_string(getpid()) + ".log");
+    unsetenv("XDG_STATE_HOME");
+    if (home != nullptr) setenv("HOME", savedHome.c_str(), 1);
+    else unsetenv("HOME");
+
+    rmdir((state + "/.local/state/tsnake").c_str());
+    rmdir((state + "/.local/state").c_str());
+    rmdir((state + "/.local").c_str());
+    rmdir((state + "/tsnake").c_str());
+    rmdir(state.c_str());
+}
+
+TEST_CASE("Every game tick fills one record", "[flight]") {
+    MemorySink sink;
+    set_render_sink(&sink);
+    initscr(25, 80);
+    stdinAtEndOfFile();
+
+    static FlightRecorder recorder;
+    recorder.clear();
+    g_flight_recorder = &recorder;
+    {
+        GameArena arena(Game::arenaBytes(25, 80));
+        TickConfig config;
+        config.rate = 500;
+        Game *game = arena.make<Game>(1, arena, config);
+        while (game->getScheduler().getTicks() < 3) {
+            game->waitForTick();
+            REQUIRE_FALSE(game->isGameOver());
+        }
+        arena.rewind(GameArena::Mark());
+    }
+    g_flight_recorder = nullptr;
+
+    REQUIRE(recorder.size() == 3);
+    for (unsigned long i = 0; i < 3; i++) {
+        const FlightRecord &r = recorder.at(i);
+        REQUIRE(r.tick == i + 1);
+        REQUIRE(r.direction == RIGHT);
+        REQUIRE(r.headX == 5);
+        REQUIRE(r.headY == static_cast<short>(8 + i));
+        REQUIRE(r.lateUs >= 0);
+        REQUIRE(r.bytes > 0);
+    }
+    REQUIRE(recorder.at(2).startNs > recorder.at(0).startNs);
+
+    cleanup_screen();
+    set_render_sink(nullptr);
+}
+
+TEST_CASE("Only unexplained deaths are dumped", "[flight]") {
+    MemorySink sink;
+    set_render_sink(&sink);
+    initscr(25, 80);
+    stdinAtEndOfFile();
+
+    std::string path = logPath("death");
+    std::remove(path.c_str());
+    static FlightRecorder recorder;
+    recorder.clear();
+    flight_install(&recorder, path.c_str(), nullptr);
+
+    GameArena arena(Game::arenaBytes(25, 80));
+    TickConfig config;
+    config.rate = 1000;
+
+    SECTION("running into the wall is a normal game over") {
+        Game *game = arena.make<Game>(1, arena, config);
+        bool over = false;
+        while (!over) {
+            game->waitForTick();
+            over = game->isGameOver();
+        }
+        REQUIRE(recorder.at(recorder.size() - 1).event == FLIGHT_DEATH);
+        REQUIRE(recorder.at(recorder.size() - 1).headY == 79);
+        REQUIRE(readFile(path).empty());
+    }
+
+    SECTION("a snake cell the snake does not have is reported") {
+        Game *game = arena.make<Game>(1, arena, config);
+        mvaddch(5, 12, 'O');
+        bool over = false;
+        while (!over) {
+            game->waitForTick();
+            over = game->isGameOver();
+        }
+        std::string text = readFile(path);
+        REQUIRE(text.find("abnormal game over: '@' at 5,12") != std::string::npos);
+        REQUIRE(text.find(" death 5,12 ") != std::string::npos);
+    }
+
+    arena.rewind(GameArena::Mark());
+    g_flight_recorder = nullptr;
+    signal(SIGUSR2, SIG_DFL);
+    std::remove(path.c_str());
+
+    cleanup_screen();
+    set_render_sink(nullptr);
+}
+
+static void markRestored() {
+    int fd = ::open(g_flight_path, O_WRONLY | O_CREAT | O_APPEND, 0644);
+    ssize_t written = ::write(fd, "restored\n", 9);
+    (void)written;
+    ::close(fd);
+}
+
+TEST_CASE("A fatal signal restores the terminal, dumps and still kills", "[flight]") {
+    std::string path = logPath("fatal");
+    std::remove(path.c_str());
+
+    pid_t child = fork();
+    REQUIRE(child >= 0);
+    if (child == 0) {
+        static FlightRecorder recorder;
+        recorder.slot().tick = 99;
+        recorder.commit();
+        flight_install(&recorder, path.c_str(), markRestored);
+        int devnull = ::open("/dev/null", O_WRONLY);
+        dup2(devnull, STDERR_FILENO);
+        raise(SIGSEGV);
+        _exit(0);
+    }
+
+    int status = 0;
+    REQUIRE(waitpid(child, &status, 0) == child);
+    REQUIRE(WIFSIGNALED(status));
+    REQUIRE(WTERMSIG(status) == SIGSEGV);
+
+    std::string text = readFile(path);
+    REQUIRE(text.find("restored\n# tsnake flight recorder: SIGSEGV\n") == 0);
+    REQUIRE(text.find("\n99 ") != std::string::npos);
+    std::remove(path.c_str());
+}
+
+TEST_CASE("SIGUSR2 dumps and carries on", "[flight]") {
+    std::string path = logPath("usr2");
+    std::remove(path.c_str());
+    static FlightRecorder recorder;
+    recorder.clear();
+    recorder.slot().tick = 3;
+    recorder.commit();
+    flight_install(&recorder, path.c_str(), nullptr);
+
+    raise(SIGUSR2);
+    raise(SIGUSR2);
+
+    REQUIRE(countLines(readFile(path), "# tsnake flight recorder: SIGUSR2") == 2);
+    g_flight_recorder = nullptr;
+    signal(SIGUSR2, SIG_DFL);
+    std::remove(path.c_str());
+}
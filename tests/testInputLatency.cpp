@@ -0,0 +1,126 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+#include "../libs/terminal.hpp"
+#include "../libs/game.hpp"
+#include "../libs/inputlatency.hpp"
+#include <fcntl.h>
+#include <cstdio>
+#include <string>
+
+TEST_CASE("A key is timed stage by stage up to the flush", "[latency]") {
+    InputLatency latency;
+    latency.noKey(1000);
+    latency.keyRead(5000);
+    latency.turned(7000);
+    latency.rendered(9000);
+    latency.flushed(12000);
+
+    REQUIRE(latency.keys == 1);
+    REQUIRE(latency.turns == 1);
+    REQUIRE(latency.stages[LATENCY_QUEUED].getMax() == 4000);
+    REQUIRE(latency.stages[LATENCY_TURN].getMax() == 2000);
+    REQUIRE(latency.stages[LATENCY_RENDER].getMax() == 2000);
+    REQUIRE(latency.stages[LATENCY_FLUSH].getMax() == 3000);
+    REQUIRE(latency.stages[LATENCY_TOTAL].getMax() == 7000);
+}
+
+TEST_CASE("Keys that turn nothing are counted, not timed", "[latency]") {
+    InputLatency latency;
+
+    // A turn with no key behind it, e.g. a new snake
+    latency.turned(1000);
+    latency.rendered(2000);
+    latency.flushed(3000);
+
+    // A key the snake ignores
+    latency.keyRead(4000);
+    latency.rendered(5000);
+    latency.flushed(6000);
+
+    // A second key while one is followed waits for the next frame
+    latency.keyRead(7000);
+    latency.keyRead(7500);
+    latency.turned(8000);
+    latency.rendered(9000);
+    latency.flushed(10000);
+    latency.flushed(11000);
+
+    REQUIRE(latency.keys == 3);
+    REQUIRE(latency.turns == 1);
+    REQUIRE(latency.stages[LATENCY_TOTAL].getCount() == 1);
+    REQUIRE(latency.stages[LATENCY_TOTAL].getMax() == 3000);
+    REQUIRE(latency.stages[LATENCY_QUEUED].getCount() == 0);
+}
+
+TEST_CASE("The report lists every stage in microseconds", "[latency]") {
+    InputLatency latency;
+    latency.noKey(0);
+    latency.keyRead(1000000);
+    latency.turned(1002000);
+    latency.rendered(1003000);
+    latency.flushed(1004000);
+
+    FILE *out = tmpfile();
+    REQUIRE(out != nullptr);
+    latency.report(out);
+    rewind(out);
+    char text[2048];
+    size_t length = fread(text, 1, sizeof(text) - 1, out);
+    text[length] = '\0';
+    fclose(out);
+
+    std::string report(text);
+    REQUIRE(report.find("key us       count") == 0);
+    REQUIRE(report.find("\nqueued           0 ") != std::string::npos);
+    REQUIRE(report.find("\ntotal            1      4.000 ") != std::string::npos);
+    REQUIRE(report.find("\n1 keys read, 1 turned the snake\n") != std::string::npos);
+}
+
+TEST_CASE("An arrow key is followed from the read to the frame showing the turn", "[latency]") {
+    MemorySink sink;
+    set_render_sink(&sink);
+    initscr(25, 80);
+
+    // Nothing to read yet, and reads do not block
+    int fds[2];
+    REQUIRE(pipe(fds) == 0);
+    fcntl(fds[0], F_SETFL, O_NONBLOCK);
+    dup2(fds[0], STDIN_FILENO);
+    close(fds[0]);
+
+    InputLatency latency;
+    g_input_latency = &latency;
+    {
+        GameArena arena(Game::arenaBytes(25, 80));
+        TickConfig config;
+        config.rate = 200;
+        Game *game = arena.make<Game>(1, arena, config);
+        while (game->getScheduler().getTicks() < 1) {
+            game->waitForTick();
+            REQUIRE_FALSE(game->isGameOver());
+        }
+        REQUIRE(latency.keys == 0);
+
+        REQUIRE(write(fds[1], "\x1b[B", 3) == 3);
+        close(fds[1]);
+        while (game->getScheduler().getTicks() < 3) {
+            game->waitForTick();
+            REQUIRE_FALSE(game->isGameOver());
+        }
+        arena.rewind(GameArena::Mark());
+    }
+    g_input_latency = nullptr;
+
+    REQUIRE(latency.keys == 1);
+    REQUIRE(latency.turns == 1);
+    REQUIRE(latency.stages[LATENCY_QUEUED].getCount() == 1);
+    const LatencyHistogram &total = latency.stages[LATENCY_TOTAL];
+    REQUIRE(total.getCount() == 1);
+    REQUIRE(total.getMax() >= latency.stages[LATENCY_TURN].getMax());
+    REQUIRE(total.getMax() >= latency.stages[LATENCY_FLUSH].getMax());
+    // Within the tick that read it
+    REQUIRE(total.getMax() < 5000000);
+
+    cleanup_screen();
+    set_render_sink(nullptr);
+}
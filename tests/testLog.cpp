@@ -0,0 +1,157 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+#include "../libs/terminal.hpp"
+#include "../libs/game.hpp"
+#include "../libs/log.hpp"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+static std::string logPath(const char *name) {
+    return "/tmp/tsnake-log-" + std::string(name) + "-" + std::to_string(getpid()) + ".log";
+}
+
+static std::string readFile(const std::string &path) {
+    std::ifstream file(path.c_str());
+    std::stringstream text;
+    text << file.rdbuf();
+    return text.str();
+}
+
+// Everything after the timestamp of the line holding `event`
+static std::string entry(const std::string &text, const char *event) {
+    size_t at = text.find(std::string(" event=") + event);
+    if (at == std::string::npos) return "";
+    size_t start = text.rfind('\n', at);
+    start = start == std::string::npos ? 0 : start + 1;
+    size_t level = text.find(" level=", start);
+    return text.substr(level + 1, text.find('\n', at) - level - 1);
+}
+
+TEST_CASE("Entries become logfmt lines in order", "[log]") {
+    std::string path = logPath("format");
+    std::remove(path.c_str());
+
+    Logger logger;
+    REQUIRE(logger.open(path.c_str()));
+    g_logger = &logger;
+    LOG_INFO("first");
+    LOG_WARN("second", "score", 14, "length", 9);
+    LOG_ERROR("third", "a", -1, "b", 2LL, "c", 'x', "d", 3000000000LL);
+
+    // The writer thread gets there on its own
+    std::string text;
+    for (int i = 0; i < 100 && text.find("third") == std::string::npos; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        text = readFile(path);
+    }
+    g_logger = nullptr;
+    logger.stop();
+
+    REQUIRE(text.find("ts=0.") == 0);
+    REQUIRE(entry(text, "log_open").find("level=info event=log_open pid=") == 0);
+    REQUIRE(entry(text, "first") == "level=info event=first");
+    REQUIRE(entry(text, "second") == "level=warn event=second score=14 length=9");
+    REQUIRE(entry(text, "third") == "level=error event=third a=-1 b=2 c=120 d=3000000000");
+    REQUIRE(text.find("event=first") < text.find("event=second"));
+    REQUIRE(text.find("event=second") < text.find("event=third"));
+    std::remove(path.c_str());
+}
+
+TEST_CASE("Levels below TSNAKE_LOG_LEVEL are compiled out", "[log]") {
+    REQUIRE(TSNAKE_LOG_LEVEL == LOG_LEVEL_INFO);
+
+    std::string path = logPath("level");
+    std::remove(path.c_str());
+    Logger logger;
+    REQUIRE(logger.open(path.c_str()));
+    g_logger = &logger;
+
+    // Not even the arguments are evaluated
+    int evaluated = 0;
+    LOG_DEBUG("hidden", "n", ++evaluated);
+    LOG_INFO("shown", "n", ++evaluated);
+
+    g_logger = nullptr;
+    logger.stop();
+    REQUIRE(evaluated == 1);
+    std::string text = readFile(path);
+    REQUIRE(text.find("hidden") == std::string::npos);
+    REQUIRE(entry(text, "shown") == "level=info event=shown n=1");
+    std::remove(path.c_str());
+}
+
+TEST_CASE("A full ring drops entries and says how many", "[log]") {
+    std::string path = logPath("drops");
+    std::remove(path.c_str());
+
+    // No writer yet: nothing leaves the ring
+    Logger logger(16);
+    g_logger = &logger;
+    for (int i = 0; i < 20; i++) LOG_INFO("fill", "i", i);
+    REQUIRE(logger.getDrops() == 4);
+
+    REQUIRE(logger.open(path.c_str()));
+    g_logger = nullptr;
+    logger.stop();
+
+    std::string text = readFile(path);
+    REQUIRE(text.find("event=fill i=15\n") != std::string::npos);
+    REQUIRE(text.find("event=fill i=16\n") == std::string::npos);
+    REQUIRE(entry(text, "log_dropped") == "level=warn event=log_dropped count=4");
+    std::remove(path.c_str());
+}
+
+TEST_CASE("No log open costs a pointer test and writes nothing", "[log]") {
+    REQUIRE(g_logger == nullptr);
+    LOG_ERROR("nowhere", "n", 1);
+    Logger logger(16);
+    REQUIRE(logger.getDrops() == 0);
+}
+
+TEST_CASE("A game logs its start and end to the file only", "[log]") {
+    MemorySink sink;
+    set_render_sink(&sink);
+    initscr(25, 80);
+
+    // No key waiting: getch() reads end of file
+    int fds[2];
+    REQUIRE(pipe(fds) == 0);
+    close(fds[1]);
+    dup2(fds[0], STDIN_FILENO);
+    close(fds[0]);
+
+    std::string path = logPath("game");
+    std::remove(path.c_str());
+    Logger logger;
+    REQUIRE(logger.open(path.c_str()));
+    g_logger = &logger;
+    {
+        GameArena arena(Game::arenaBytes(25, 80));
+        TickConfig config;
+        config.rate = 1000;
+        Game *game = arena.make<Game>(1, arena, config);
+        bool over = false;
+        while (!over) {
+            game->waitForTick();
+            over = game->isGameOver();
+        }
+        arena.rewind(GameArena::Mark());
+    }
+    g_logger = nullptr;
+    logger.stop();
+
+    std::string text = readFile(path);
+    REQUIRE(entry(text, "game_start") == "level=info event=game_start difficulty=1 rate_mhz=1000000 rows=25 cols=80");
+    // Right from (5,7) into the wall at column 79
+    REQUIRE(entry(text, "game_over").find("level=info event=game_over score=") == 0);
+    REQUIRE(entry(text, "game_over").find(" length=3 ticks=72 ") != std::string::npos);
+    REQUIRE(sink.getData().find("game_") == std::string::npos);
+    std::remove(path.c_str());
+
+    cleanup_screen();
+    set_render_sink(nullptr);
+}
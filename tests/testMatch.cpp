@@ -0,0 +1,284 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+#include "../libs/terminal.hpp"
+#include "../libs/match.hpp"
+#include "../libs/arena.hpp"
+
+static int countOwner(const Grid &grid, unsigned short owner) {
+    int count = 0;
+    const std::vector<unsigned short> &cells = grid.getCells();
+    for (size_t i = 0; i < cells.size(); i++) {
+        if (cells[i] == owner) count++;
+    }
+    return count;
+}
+
+// ============================================================================
+// GRID TESTS
+// ============================================================================
+
+TEST_CASE("Grid border is wall and interior is empty", "[grid]") {
+    Grid grid(10, 20);
+
+    REQUIRE(grid.get(Point(0, 0)) == Grid::WALL);
+    REQUIRE(grid.get(Point(9, 19)) == Grid::WALL);
+    REQUIRE(grid.get(Point(0, 7)) == Grid::WALL);
+    REQUIRE(grid.get(Point(5, 0)) == Grid::WALL);
+    REQUIRE(grid.get(Point(5, 5)) == Grid::EMPTY);
+    REQUIRE(countOwner(grid, Grid::EMPTY) == 8 * 18);
+}
+
+TEST_CASE("Grid treats cells outside the board as wall", "[grid]") {
+    Grid grid(10, 20);
+
+    REQUIRE(grid.get(Point(-1, 5)) == Grid::WALL);
+    REQUIRE(grid.get(Point(5, 20)) == Grid::WALL);
+    REQUIRE(grid.get(Point(10, 5)) == Grid::WALL);
+}
+
+TEST_CASE("Grid stores owner ids", "[grid]") {
+    Grid grid(10, 20);
+    grid.set(Point(3, 4), 7);
+
+    REQUIRE(grid.get(Point(3, 4)) == 7);
+    REQUIRE(Grid::isSnake(grid.get(Point(3, 4))));
+    REQUIRE_FALSE(Grid::isSnake(Grid::EMPTY));
+    REQUIRE_FALSE(Grid::isSnake(Grid::FOOD));
+    REQUIRE_FALSE(Grid::isSnake(Grid::WALL));
+}
+
+// ============================================================================
+// BODY TESTS
+// ============================================================================
+
+TEST_CASE("Body lays segments behind the head", "[body]") {
+    Body b(Point(5, 10), LEFT, 4);
+
+    REQUIRE(b.getSize() == 4);
+    REQUIRE(b.getHead().getX() == 5);
+    REQUIRE(b.getHead().getY() == 10);
+    REQUIRE(b.getTail().getY() == 13);
+    REQUIRE(b.getDirection() == LEFT);
+    REQUIRE(b.getDisableDirection() == RIGHT);
+}
+
+TEST_CASE("Body copies are independent", "[body]") {
+    Body a(Point(5, 5), RIGHT, 3);
+    Body b(a);
+    b.setHead(Point(5, 6));
+
+    REQUIRE(a.getSize() == 3);
+    REQUIRE(b.getSize() == 4);
+}
+
+TEST_CASE("Body in outside storage copies into a ring of its own", "[body]") {
+    Point storage[16];
+    Body a(storage, 16);
+    a.setHead(Point(5, 8));
+    Body b(a);
+    b.setHead(Point(5, 9));
+    b.removeTail();
+
+    REQUIRE(a.getSize() == 4);
+    REQUIRE(a.getHead().getY() == 8);
+    REQUIRE(a.getTail().getY() == 5);
+    REQUIRE(b.getHead().getY() == 9);
+    REQUIRE(b.getTail().getY() == 6);
+}
+
+// ============================================================================
+// MATCH TESTS
+// ============================================================================
+
+TEST_CASE("Match places every snake on the grid", "[match]") {
+    Match match(20, 40, 4, 1, 7);
+
+    for (int i = 0; i < 4; i++) {
+        REQUIRE(match.isAlive(i));
+        REQUIRE(countOwner(match.getGrid(), static_cast<unsigned short>(i + 1)) == 3);
+    }
+    REQUIRE(match.getFoods().size() == 1);
+    REQUIRE(countOwner(match.getGrid(), Grid::FOOD) == 1);
+}
+
+TEST_CASE("Match kills a snake that runs into the wall", "[match]") {
+    Match match(10, 12, 1, 1, 3);
+
+    for (int i = 0; i < 6; i++) {
+        match.step();
+        REQUIRE(match.isAlive(0));
+    }
+
+    match.step();
+    REQUIRE_FALSE(match.isAlive(0));
+    REQUIRE(match.isOver());
+    REQUIRE(countOwner(match.getGrid(), 1) == 0);
+}
+
+TEST_CASE("Match resolves head-to-head collisions for both snakes", "[match]") {
+    // Both snakes spawn on row 2 facing each other
+    Match match(5, 13, 2, 1, 11);
+
+    match.step();
+    REQUIRE(match.getAlive() == 2);
+
+    match.step();
+    REQUIRE(match.getAlive() == 0);
+    REQUIRE(match.isOver());
+    REQUIRE(countOwner(match.getGrid(), 1) == 0);
+    REQUIRE(countOwner(match.getGrid(), 2) == 0);
+}
+
+TEST_CASE("Match only applies the latest queued turn", "[match]") {
+    Match match(20, 40, 1, 1, 5);
+    Point head = match.getSnake(0).getHead();
+
+    // LEFT would reverse into the body and is ignored, UP is overwritten
+    match.setDirection(0, UP);
+    match.setDirection(0, LEFT);
+    match.step();
+
+    REQUIRE(match.isAlive(0));
+    REQUIRE(match.getSnake(0).getHead().getX() == head.getX());
+    REQUIRE(match.getSnake(0).getHead().getY() == head.getY() + 1);
+}
+
+TEST_CASE("Match keeps grid, size and score consistent", "[match]") {
+    Match match(30, 60, 1, 2, 99);
+    const int turns[4] = { DOWN, RIGHT, UP, LEFT };
+
+    for (int t = 0; t < 2000 && match.isAlive(0); t++) {
+        if (t % 10 == 0) match.setDirection(0, turns[(t / 10) % 4]);
+        match.step();
+
+        if (!match.isAlive(0)) break;
+        REQUIRE(countOwner(match.getGrid(), 1) == match.getSnake(0).getSize());
+        REQUIRE(match.getScore(0) == (match.getSnake(0).getSize() - 3) * 2);
+        REQUIRE(countOwner(match.getGrid(), Grid::FOOD) == 1);
+    }
+}
+
+TEST_CASE("Match is deterministic for a given seed", "[match]") {
+    Match a(24, 80, 3, 1, 1234);
+    Match b(24, 80, 3, 1, 1234);
+    const int turns[4] = { UP, LEFT, DOWN, RIGHT };
+
+    for (int t = 0; t < 300 && !a.isOver(); t++) {
+        if (t % 7 == 0) {
+            a.setDirection(t % 3, turns[t % 4]);
+            b.setDirection(t % 3, turns[t % 4]);
+        }
+        a.step();
+        b.step();
+        REQUIRE(a.getGrid().getCells() == b.getGrid().getCells());
+    }
+}
+
+TEST_CASE("Match reset reuses the match as if freshly built", "[match]") {
+    Match fresh(24, 80, 2, 1, 99);
+    Match reused(24, 80, 2, 1, 5);
+
+    for (int t = 0; t < 40; t++) {
+        reused.setDirection(0, t % 2 ? UP : RIGHT);
+        reused.step();
+    }
+    reused.reset(99);
+
+    REQUIRE(reused.getTick() == 0);
+    REQUIRE(reused.checksum() == fresh.checksum());
+    REQUIRE(reused.getGrid().getCells() == fresh.getGrid().getCells());
+    REQUIRE(reused.getFoodIndex().size() == fresh.getFoodIndex().size());
+}
+
+TEST_CASE("Match grow keeps the tail for that many moves", "[match]") {
+    Match match(24, 80, 1, 1, 3, 0);
+    match.grow(0, 5);
+
+    for (int t = 0; t < 5; t++) {
+        match.step();
+        REQUIRE(match.getSnake(0).getSize() == 4 + t);
+    }
+    match.step();
+    REQUIRE(match.getSnake(0).getSize() == 8);
+    REQUIRE(match.getScore(0) == 0);
+}
+
+// ============================================================================
+// FOOD INDEX TESTS
+// ============================================================================
+
+TEST_CASE("FoodIndex nearest matches a linear scan", "[spatial]") {
+    FoodIndex index(200, 300);
+    std::vector<Point> foods;
+    std::mt19937 rng(17);
+    std::uniform_int_distribution<int> xValue(1, 198);
+    std::uniform_int_distribution<int> yValue(1, 298);
+
+    for (int i = 0; i < 150; i++) {
+        Point p(xValue(rng), yValue(rng));
+        index.insert(p);
+        foods.push_back(p);
+    }
+
+    for (int q = 0; q < 500; q++) {
+        Point from(xValue(rng), yValue(rng));
+        int best = 0x7FFFFFFF;
+        for (size_t i = 0; i < foods.size(); i++) {
+            int d = std::abs(foods[i].getX() - from.getX()) + std::abs(foods[i].getY() - from.getY());
+            if (d < best) best = d;
+        }
+
+        Point found;
+        REQUIRE(index.nearest(from, found));
+        REQUIRE(std::abs(found.getX() - from.getX()) + std::abs(found.getY() - from.getY()) == best);
+    }
+}
+
+TEST_CASE("FoodIndex remove and empty queries", "[spatial]") {
+    FoodIndex index(50, 50);
+    Point found;
+
+    REQUIRE_FALSE(index.nearest(Point(10, 10), found));
+
+    index.insert(Point(40, 40));
+    index.insert(Point(12, 12));
+    REQUIRE(index.nearest(Point(10, 10), found));
+    REQUIRE(found.getX() == 12);
+
+    REQUIRE(index.remove(Point(12, 12)));
+    REQUIRE_FALSE(index.remove(Point(12, 12)));
+    REQUIRE(index.nearest(Point(10, 10), found));
+    REQUIRE(found.getX() == 40);
+    REQUIRE(index.size() == 1);
+}
+
+// ============================================================================
+// ARENA TESTS
+// ============================================================================
+
+TEST_CASE("Arena outcome does not depend on the thread count", "[arena]") {
+    Arena single(80, 160, 200, 60, 5, 1);
+    Arena parallel(80, 160, 200, 60, 5, 4);
+
+    for (int t = 0; t < 100; t++) {
+        single.tick();
+        parallel.tick();
+    }
+
+    REQUIRE(single.getMatch().getGrid().getCells() == parallel.getMatch().getGrid().getCells());
+    for (int i = 0; i < 200; i++) {
+        REQUIRE(single.getMatch().getScore(i) == parallel.getMatch().getScore(i));
+    }
+}
+
+TEST_CASE("Arena keeps the bot population alive", "[arena]") {
+    Arena arena(60, 120, 100, 40, 9, 2);
+
+    for (int t = 0; t < 50; t++) {
+        arena.tick();
+    }
+
+    REQUIRE(arena.getMatch().getAlive() == 100);
+    REQUIRE(arena.getMatch().getFoods().size() == 40);
+    REQUIRE(arena.getMatch().getFoodIndex().size() == 40);
+}
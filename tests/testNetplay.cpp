@@ -0,0 +1,148 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+#include "../libs/terminal.hpp"
+#include "../libs/netplay.hpp"
+#include <thread>
+
+static volatile sig_atomic_t noCancel = 0;
+
+// Connects two sessions over loopback UDP
+struct LoopbackPair {
+    NetLink hostLink;
+    NetLink guestLink;
+    NetConfig hostConfig;
+    NetConfig guestConfig;
+
+    LoopbackPair() {
+        hostConfig.rows = 22;
+        hostConfig.cols = 60;
+        hostConfig.level = 2;
+        hostConfig.seed = 4242;
+        guestConfig.rows = 30;
+        guestConfig.cols = 50;
+
+        hostLink.listen(0);
+        guestLink.connect("127.0.0.1", hostLink.getPort());
+
+        bool hostReady = false;
+        std::thread host([&] { hostReady = netHostHandshake(hostLink, hostConfig, noCancel); });
+        bool guestReady = netJoinHandshake(guestLink, guestConfig, noCancel);
+        host.join();
+
+        REQUIRE(hostReady);
+        REQUIRE(guestReady);
+    }
+};
+
+static void settle(NetSession &a, NetSession &b) {
+    for (int i = 0; i < 20; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        a.poll();
+        b.poll();
+    }
+}
+
+TEST_CASE("Handshake agrees on seed and the smaller board", "[netplay]") {
+    LoopbackPair pair;
+
+    REQUIRE(pair.guestConfig.seed == 4242);
+    REQUIRE(pair.guestConfig.level == 2);
+    REQUIRE(pair.guestConfig.rows == 22);
+    REQUIRE(pair.guestConfig.cols == 50);
+    REQUIRE(pair.hostConfig.cols == 50);
+}
+
+TEST_CASE("Peers stay in sync when inputs arrive on time", "[netplay]") {
+    LoopbackPair pair;
+    NetSession host(pair.hostLink, 0, pair.hostConfig);
+    NetSession guest(pair.guestLink, 1, pair.guestConfig);
+
+    const int hostTurns[4] = { DOWN, RIGHT, UP, RIGHT };
+    const int guestTurns[4] = { UP, LEFT, DOWN, LEFT };
+
+    for (int t = 0; t < 120 && !host.getMatch().isOver(); t++) {
+        host.advance(t % 9 == 0 ? hostTurns[(t / 9) % 4] : ERR);
+        guest.advance(t % 11 == 0 ? guestTurns[(t / 11) % 4] : ERR);
+        settle(host, guest);
+    }
+    settle(host, guest);
+
+    REQUIRE(host.getTick() == guest.getTick());
+    REQUIRE(host.getMatch().checksum() == guest.getMatch().checksum());
+    REQUIRE(host.getVerifiedChecksums() > 0);
+    REQUIRE(guest.getVerifiedChecksums() > 0);
+    REQUIRE(host.getDesyncs() == 0);
+    REQUIRE(guest.getDesyncs() == 0);
+}
+
+TEST_CASE("Late remote input rolls back and converges", "[netplay]") {
+    LoopbackPair pair;
+    NetSession host(pair.hostLink, 0, pair.hostConfig);
+    NetSession guest(pair.guestLink, 1, pair.guestConfig);
+
+    // The guest runs 10 ticks without hearing from the host, which turns on tick 0
+    for (int t = 0; t < 10; t++) {
+        host.advance(t == 0 ? DOWN : ERR);
+        guest.advance(ERR);
+    }
+    settle(host, guest);
+
+    REQUIRE(guest.getRollbacks() >= 1);
+    REQUIRE(guest.getMaxRollback() == 10);
+    REQUIRE(guest.getMaxResimMs() < DELAY / 4.0);
+    REQUIRE(host.getMatch().checksum() == guest.getMatch().checksum());
+    REQUIRE(host.getDesyncs() == 0);
+    REQUIRE(guest.getDesyncs() == 0);
+}
+
+TEST_CASE("A session stalls instead of running too far ahead", "[netplay]") {
+    LoopbackPair pair;
+    NetSession host(pair.hostLink, 0, pair.hostConfig);
+
+    int advanced = 0;
+    for (int t = 0; t < 40; t++) {
+        if (host.advance(ERR)) advanced++;
+    }
+
+    REQUIRE(advanced == NetSession::MAX_AHEAD);
+}
+
+TEST_CASE("A BYE after the match ended is not an opponent leaving", "[netplay]") {
+    LoopbackPair pair;
+    NetSession guest(pair.guestLink, 1, pair.guestConfig);
+    {
+        NetSession host(pair.hostLink, 0, pair.hostConfig);
+        for (int t = 0; t < 200 && !host.isOver(); t++) {
+            host.advance(ERR);
+            guest.advance(ERR);
+            settle(host, guest);
+        }
+        REQUIRE(host.isOver());
+    }
+    // The host's BYE arrives once the game is over
+    settle(guest, guest);
+
+    REQUIRE(guest.isPeerGone());
+    REQUIRE(guest.isOver());
+    REQUIRE_FALSE(guest.hasPeerLeft());
+}
+
+TEST_CASE("A BYE in the middle of a match is an opponent leaving", "[netplay]") {
+    LoopbackPair pair;
+    NetSession guest(pair.guestLink, 1, pair.guestConfig);
+    {
+        NetSession host(pair.hostLink, 0, pair.hostConfig);
+        for (int t = 0; t < 3; t++) {
+            host.advance(ERR);
+            guest.advance(ERR);
+            settle(host, guest);
+        }
+    }
+    settle(guest, guest);
+    REQUIRE(guest.isPeerGone());
+    REQUIRE_FALSE(guest.isOver());
+
+    // The host's inputs for the ticks already played are in, nothing after that
+    REQUIRE(guest.advance(ERR));
+    REQUIRE(guest.hasPeerLeft());
+}
@@ -0,0 +1,123 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+#include "../libs/terminal.hpp"
+#include "../libs/game.hpp"
+#include "../libs/perfcounters.hpp"
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+
+// Hosts without a PMU (most VMs, containers) only have the task clock, and
+// perf_event_paranoid 3 allows nothing: every case holds either way.
+
+static std::string reportText(const PerfCounters &counters) {
+    char *buffer = nullptr;
+    size_t size = 0;
+    FILE *out = open_memstream(&buffer, &size);
+    counters.report(out);
+    fclose(out);
+    std::string text(buffer, size);
+    free(buffer);
+    return text;
+}
+
+static volatile unsigned long g_work;
+
+static void busyWork() {
+    for (unsigned long i = 0; i < 2000000; i++) g_work = g_work + i;
+}
+
+TEST_CASE("A phase sums counter deltas over its runs", "[perf]") {
+    PerfPhase phase;
+    PerfSample a, b, c;
+    for (int i = 0; i < PERF_COUNTERS; i++) {
+        a.values[i] = 100;
+        b.values[i] = 150 + i;
+        c.values[i] = 300;
+    }
+    phase.add(a, b);
+    phase.add(b, c);
+
+    REQUIRE(phase.runs == 2);
+    REQUIRE(phase.totals[PERF_CYCLES] == 200);
+    REQUIRE(phase.totals[PERF_TASK_CLOCK] == 200);
+}
+
+TEST_CASE("Counters that cannot be opened are reported, not fatal", "[perf]") {
+    PerfCounters counters;
+    bool opened = counters.open();
+    std::string text = reportText(counters);
+
+    if (!opened) {
+        REQUIRE_FALSE(counters.getError().empty());
+        REQUIRE(text.find("perf counters unavailable") != std::string::npos);
+    } else {
+        bool all = true;
+        for (int i = 0; i < PERF_COUNTERS; i++) all = all && counters.has(i);
+        REQUIRE(all == counters.getError().empty());
+        REQUIRE(text.find("phase") != std::string::npos);
+    }
+}
+
+TEST_CASE("Scopes count nothing without open counters", "[perf]") {
+    g_perf_counters = nullptr;
+    {
+        PerfScope scope(PERF_TICK);
+        busyWork();
+    }
+    PerfCounters counters;
+    REQUIRE(counters.phases[PERF_TICK].runs == 0);
+}
+
+TEST_CASE("Scopes measure the work inside them", "[perf]") {
+    PerfCounters counters;
+    if (!counters.open()) {
+        WARN("perf counters unavailable: " << counters.getError());
+        return;
+    }
+    g_perf_counters = &counters;
+    for (int i = 0; i < 3; i++) {
+        PerfScope scope(PERF_TICK);
+        busyWork();
+    }
+    {
+        PerfScope scope(PERF_REFRESH);
+    }
+    g_perf_counters = nullptr;
+
+    const PerfPhase &tick = counters.phases[PERF_TICK];
+    const PerfPhase &refresh = counters.phases[PERF_REFRESH];
+    REQUIRE(tick.runs == 3);
+    REQUIRE(refresh.runs == 1);
+    if (counters.has(PERF_INSTRUCTIONS)) REQUIRE(tick.totals[PERF_INSTRUCTIONS] > 3 * 2000000ull);
+    if (counters.has(PERF_TASK_CLOCK)) REQUIRE(tick.totals[PERF_TASK_CLOCK] > refresh.totals[PERF_TASK_CLOCK]);
+    REQUIRE(reportText(counters).find("tick") != std::string::npos);
+}
+
+TEST_CASE("A game tick samples the tick and refresh phases", "[perf]") {
+    MemorySink sink;
+    set_render_sink(&sink);
+    initscr(25, 80);
+
+    int fds[2];
+    REQUIRE(pipe(fds) == 0);
+    close(fds[1]);
+    dup2(fds[0], STDIN_FILENO);
+    close(fds[0]);
+
+    PerfCounters counters;
+    if (counters.open()) {
+        g_perf_counters = &counters;
+        Game game(1);
+        std::this_thread::sleep_for(std::chrono::milliseconds(DELAY + 5));
+        REQUIRE_FALSE(game.isGameOver());
+        g_perf_counters = nullptr;
+
+        REQUIRE(counters.phases[PERF_TICK].runs == 1);
+        REQUIRE(counters.phases[PERF_REFRESH].runs == 1);
+    }
+
+    cleanup_screen();
+    set_render_sink(nullptr);
+}
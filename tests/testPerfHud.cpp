@@ -0,0 +1,131 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+#include "../libs/terminal.hpp"
+#include "../libs/game.hpp"
+#include "../libs/perfhud.hpp"
+#include <string>
+
+static const long long MS = 1000000;
+
+// Characters of the status bar from `column` on
+static std::string statusText(int column) {
+    std::string text;
+    for (int x = column; x < COLS; x++) text += static_cast<char>(mvinch(0, x) & A_CHARTEXT);
+    return text;
+}
+
+// `keys` are waiting, then getch() reads end of file
+static void stdinWith(const char *keys) {
+    int fds[2];
+    REQUIRE(pipe(fds) == 0);
+    REQUIRE(write(fds[1], keys, std::strlen(keys)) == static_cast<ssize_t>(std::strlen(keys)));
+    close(fds[1]);
+    dup2(fds[0], STDIN_FILENO);
+    close(fds[0]);
+}
+
+TEST_CASE("The HUD shows nothing until toggled, then updates a few times a second", "[hud]") {
+    MemorySink sink;
+    set_render_sink(&sink);
+    initscr(25, 80);
+
+    Board board(42);
+    PerfHud hud;
+    std::string highscore = statusText(Board::HUD_COLUMN);
+    REQUIRE_FALSE(hud.draw(board, 1000 * MS));
+
+    hud.toggle(board, 1000 * MS);
+    REQUIRE(hud.isVisible());
+    for (int i = 0; i < 10; i++) hud.record(120000, 45000, 211, 9);
+
+    REQUIRE_FALSE(hud.draw(board, 1100 * MS));
+    REQUIRE(statusText(Board::HUD_COLUMN) == highscore);
+    REQUIRE(hud.draw(board, 1250 * MS));
+    REQUIRE(std::string(hud.getText()).find("40Hz tick 120/120/120us draw 45us 211B/9c cpu ") == 0);
+    REQUIRE(statusText(Board::HUD_COLUMN).find(hud.getText()) == 0);
+
+    REQUIRE_FALSE(hud.draw(board, 1400 * MS));
+    REQUIRE(hud.draw(board, 1500 * MS));
+    REQUIRE(hud.getUpdates() == 2);
+
+    cleanup_screen();
+    set_render_sink(nullptr);
+}
+
+TEST_CASE("An update only sends the characters that changed", "[hud]") {
+    MemorySink sink;
+    set_render_sink(&sink);
+    initscr(25, 80);
+
+    Board board;
+    PerfHud hud;
+    hud.toggle(board, 0);
+    hud.record(120000, 45000, 211, 9);
+    REQUIRE(hud.draw(board, 250 * MS));
+    refresh();
+    REQUIRE(frame_cells() > 30);
+
+    // Same numbers: at most the CPU figure moves
+    hud.record(120000, 45000, 211, 9);
+    REQUIRE(hud.draw(board, 500 * MS));
+    refresh();
+    REQUIRE(frame_cells() < 4);
+
+    cleanup_screen();
+    set_render_sink(nullptr);
+}
+
+TEST_CASE("Hiding the HUD brings the highscore back", "[hud]") {
+    MemorySink sink;
+    set_render_sink(&sink);
+    initscr(25, 80);
+
+    Board board(42);
+    PerfHud hud;
+    std::string highscore = statusText(Board::HUD_COLUMN);
+    REQUIRE(highscore.find("HIGHSCORE") != std::string::npos);
+
+    hud.toggle(board, 0);
+    hud.record(120000, 45000, 211, 9);
+    REQUIRE(hud.draw(board, 250 * MS));
+    REQUIRE(statusText(Board::HUD_COLUMN).find("HIGHSCORE") == std::string::npos);
+
+    hud.toggle(board, 300 * MS);
+    REQUIRE_FALSE(hud.isVisible());
+    REQUIRE(statusText(Board::HUD_COLUMN) == highscore);
+    // Hidden, nothing is kept
+    hud.record(120000, 45000, 211, 9);
+    REQUIRE_FALSE(hud.draw(board, 1000 * MS));
+
+    cleanup_screen();
+    set_render_sink(nullptr);
+}
+
+TEST_CASE("The h key shows the HUD in a game", "[hud]") {
+    MemorySink sink;
+    set_render_sink(&sink);
+    initscr(25, 80);
+    stdinWith("h");
+
+    GameArena arena(Game::arenaBytes(25, 80));
+    TickConfig config;
+    config.rate = 200;
+    Game *game = arena.make<Game>(1, arena, config);
+    std::string before = statusText(Board::HUD_COLUMN);
+
+    // Up to 60 ticks (300 ms): the first HUD text comes 250 ms after the key
+    std::string status = before;
+    while (status == before && game->getScheduler().getTicks() < 60) {
+        game->waitForTick();
+        REQUIRE_FALSE(game->isGameOver());
+        status = statusText(Board::HUD_COLUMN);
+    }
+
+    REQUIRE(status.find("Hz tick ") != std::string::npos);
+    REQUIRE(status.find("us draw ") != std::string::npos);
+    REQUIRE(status.find("% ") != std::string::npos);
+    arena.rewind(GameArena::Mark());
+
+    cleanup_screen();
+    set_render_sink(nullptr);
+}
@@ -186,6 +186,19 @@ TEST_CASE("Clock consecutive getTimestamp calls", "[clock]") {
     REQUIRE(second >= first);
 }
 
+TEST_CASE("Clock keeps sub-millisecond precision", "[clock]") {
+    Clock clock;
+
+    std::this_thread::sleep_for(std::chrono::microseconds(1500));
+
+    double timestamp = clock.getTimestamp();
+    long long ns = clock.getNanoseconds();
+    REQUIRE(timestamp >= 1.5);
+    REQUIRE(ns >= 1500000);
+    // Both describe the same instant
+    REQUIRE(timestamp == Approx(ns / 1e6));
+}
+
 // ============================================================================
 // COMMON TESTS
 // ============================================================================
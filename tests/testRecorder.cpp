@@ -0,0 +1,108 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+#include "../libs/terminal.hpp"
+#include "../libs/recorder.hpp"
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+static std::string castPath() {
+    return "/tmp/tsnake-test-" + std::to_string(getpid()) + ".cast";
+}
+
+static std::vector<std::string> readLines(const std::string &path) {
+    std::ifstream file(path.c_str());
+    std::vector<std::string> lines;
+    std::string line;
+    while (std::getline(file, line)) {
+        lines.push_back(line);
+    }
+    return lines;
+}
+
+TEST_CASE("Cast events escape control characters and quotes", "[recorder]") {
+    std::string line;
+    const char bytes[] = "\x1b[2;3Ha\"b\\c\n";
+    appendCastEvent(line, 1.5, "o", bytes, sizeof(bytes) - 1);
+    REQUIRE(line == "[1.500000, \"o\", \"\\u001b[2;3Ha\\\"b\\\\c\\u000a\"]\n");
+}
+
+TEST_CASE("Recorder writes a header, every frame and a trailer", "[recorder]") {
+    std::string path = castPath();
+    Recorder recorder;
+    REQUIRE(recorder.open(path.c_str(), 100, 30));
+
+    recorder.frame("\x1b[1;1Hfirst", 11);
+    recorder.frame("second", 6);
+    recorder.frame("third", 5);
+    recorder.stop();
+
+    std::vector<std::string> lines = readLines(path);
+    REQUIRE(lines.size() == 5);
+    REQUIRE(lines[0].find("\"version\": 2") != std::string::npos);
+    REQUIRE(lines[0].find("\"width\": 100") != std::string::npos);
+    REQUIRE(lines[0].find("\"height\": 30") != std::string::npos);
+    REQUIRE(lines[1].find("\"\\u001b[1;1Hfirst\"]") != std::string::npos);
+    REQUIRE(lines[2].find("\"second\"]") != std::string::npos);
+    REQUIRE(lines[3].find("\"third\"]") != std::string::npos);
+    REQUIRE(lines[4].find("\\u001b[?25h") != std::string::npos);
+
+    // Timestamps never go backwards
+    double last = 0;
+    for (size_t i = 1; i < lines.size(); i++) {
+        double t = std::atof(lines[i].c_str() + 1);
+        REQUIRE(t >= last);
+        last = t;
+    }
+
+    REQUIRE(recorder.getFrames() == 3);
+    REQUIRE(recorder.getDrops() == 0);
+    unlink(path.c_str());
+}
+
+TEST_CASE("Recorder flushes while the game is still running", "[recorder]") {
+    std::string path = castPath();
+    Recorder recorder;
+    REQUIRE(recorder.open(path.c_str(), 80, 24));
+
+    recorder.frame("live", 4);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    // Without stop(): what is on disk is already a valid recording
+    std::vector<std::string> lines = readLines(path);
+    REQUIRE(lines.size() == 2);
+    REQUIRE(lines[1].find("\"live\"]") != std::string::npos);
+
+    recorder.stop();
+    unlink(path.c_str());
+}
+
+TEST_CASE("Recorder drops frames instead of blocking and resyncs", "[recorder]") {
+    std::string path = castPath();
+    Recorder recorder(1024);
+    REQUIRE(recorder.open(path.c_str(), 80, 24));
+
+    // Far more than the ring holds before the writer wakes up
+    std::string big(300, 'x');
+    for (int i = 0; i < 20; i++) {
+        recorder.frame(big.data(), big.size());
+    }
+    REQUIRE(recorder.getDrops() > 0);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    unsigned long bytes = recorder.getBytes();
+    recorder.frame("after", 5);
+    recorder.stop();
+
+    // Counted as the redraw that was written
+    std::string full;
+    encode_keyframe(full);
+    REQUIRE(recorder.getBytes() - bytes == full.size());
+
+    // The frame after the drop is replaced by a full redraw
+    std::vector<std::string> lines = readLines(path);
+    REQUIRE(lines.size() >= 3);
+    REQUIRE(lines[lines.size() - 2].find("\\u001b[2J") != std::string::npos);
+    unlink(path.c_str());
+}
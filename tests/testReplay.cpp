@@ -0,0 +1,136 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+#include "../libs/terminal.hpp"
+#include "../libs/replay.hpp"
+#include <string>
+
+static std::string replayPath() {
+    return "/tmp/tsnake-test-" + std::to_string(getpid()) + ".tsr";
+}
+
+// Plays a match with scripted turns, noting them in `replay`
+static unsigned int playScripted(Replay &replay) {
+    Match match(replay.getRows(), replay.getCols(), replay.getPlayers(), replay.getLevel(), replay.getSeed());
+    const int turns[4] = { UP, LEFT, DOWN, RIGHT };
+
+    for (int t = 0; t < 200 && !match.isOver(); t++) {
+        if (t % 5 == 0) {
+            int player = t % replay.getPlayers();
+            match.setDirection(player, turns[(t / 5) % 4]);
+            replay.record(match.getTick(), player, turns[(t / 5) % 4]);
+        }
+        match.step();
+    }
+    replay.finish(match.getTick());
+    return match.checksum();
+}
+
+TEST_CASE("Replay survives a save and load", "[replay]") {
+    Replay replay(20, 40, 3, 2, 777);
+    playScripted(replay);
+
+    std::string path = replayPath();
+    REQUIRE(replay.save(path.c_str()));
+
+    Replay loaded;
+    REQUIRE(loaded.load(path.c_str()));
+    REQUIRE(loaded.getRows() == 20);
+    REQUIRE(loaded.getCols() == 40);
+    REQUIRE(loaded.getPlayers() == 3);
+    REQUIRE(loaded.getLevel() == 2);
+    REQUIRE(loaded.getSeed() == 777u);
+    REQUIRE(loaded.getTicks() == replay.getTicks());
+    REQUIRE(loaded.getInputs().size() == replay.getInputs().size());
+    for (size_t i = 0; i < loaded.getInputs().size(); i++) {
+        REQUIRE(loaded.getInputs()[i].tick == replay.getInputs()[i].tick);
+        REQUIRE(loaded.getInputs()[i].player == replay.getInputs()[i].player);
+        REQUIRE(loaded.getInputs()[i].direction == replay.getInputs()[i].direction);
+    }
+    unlink(path.c_str());
+}
+
+TEST_CASE("Replay rejects files that are not replays", "[replay]") {
+    std::string path = replayPath();
+    FILE *file = fopen(path.c_str(), "wb");
+    fputs("not a replay at all, just some text", file);
+    fclose(file);
+
+    Replay replay;
+    REQUIRE_FALSE(replay.load(path.c_str()));
+    REQUIRE_FALSE(replay.load("/nonexistent/replay.tsr"));
+    unlink(path.c_str());
+}
+
+TEST_CASE("Replay rejects input counts and players the file cannot back", "[replay]") {
+    Replay replay(20, 40, 2, 2, 777);
+    playScripted(replay);
+    REQUIRE(replay.getInputs().size() > 1);
+    std::string path = replayPath();
+    REQUIRE(replay.save(path.c_str()));
+
+    FILE *file = fopen(path.c_str(), "rb");
+    std::string saved(REPLAY_HEADER + replay.getInputs().size() * REPLAY_INPUT, '\0');
+    REQUIRE(fread(&saved[0], 1, saved.size(), file) == saved.size());
+    fclose(file);
+
+    // 0x2AAAAAAB inputs of 6 bytes wrap around to 2 bytes in 32 bits
+    const unsigned int counts[3] = { 0x2AAAAAABu, 0xFFFFFFFFu, static_cast<unsigned int>(replay.getInputs().size() + 1) };
+    for (int i = 0; i < 4; i++) {
+        std::string bad = saved;
+        if (i < 3) netPut32(reinterpret_cast<unsigned char *>(&bad[19]), counts[i]);
+        else bad[REPLAY_HEADER + REPLAY_INPUT + 4] = 2;   // a third player in a two-player match
+        file = fopen(path.c_str(), "wb");
+        REQUIRE(fwrite(bad.data(), 1, bad.size(), file) == bad.size());
+        fclose(file);
+
+        Replay loaded;
+        REQUIRE_FALSE(loaded.load(path.c_str()));
+    }
+    unlink(path.c_str());
+}
+
+TEST_CASE("Replay rejects boards and player counts no game records", "[replay]") {
+    Replay replay(20, 40, 2, 2, 777);
+    std::string path = replayPath();
+    REQUIRE(replay.save(path.c_str()));
+
+    FILE *file = fopen(path.c_str(), "rb");
+    std::string saved(REPLAY_HEADER, '\0');
+    REQUIRE(fread(&saved[0], 1, saved.size(), file) == saved.size());
+    fclose(file);
+
+    // rows, cols and players as stored in the header
+    const int setups[5][3] = {
+        { REPLAY_MAX_ROWS, REPLAY_MAX_COLS, REPLAY_MAX_PLAYERS },
+        { REPLAY_MAX_ROWS + 1, 40, 2 },
+        { 20, 0xFFFF, 2 },
+        { 20, 40, REPLAY_MAX_PLAYERS + 1 },
+        { 20, 40, 0 },
+    };
+    for (int i = 0; i < 5; i++) {
+        std::string patched = saved;
+        unsigned char *header = reinterpret_cast<unsigned char *>(&patched[0]);
+        netPut16(header + 5, setups[i][0]);
+        netPut16(header + 7, setups[i][1]);
+        header[9] = static_cast<unsigned char>(setups[i][2]);
+        file = fopen(path.c_str(), "wb");
+        REQUIRE(fwrite(patched.data(), 1, patched.size(), file) == patched.size());
+        fclose(file);
+
+        Replay loaded;
+        REQUIRE(loaded.load(path.c_str()) == (i == 0));
+    }
+    unlink(path.c_str());
+}
+
+TEST_CASE("ReplayPlayer rebuilds the recorded match", "[replay]") {
+    Replay replay(24, 60, 2, 1, 31337);
+    unsigned int expected = playScripted(replay);
+
+    ReplayPlayer player(replay);
+    while (!player.isDone()) {
+        player.step();
+    }
+    REQUIRE(player.getMatch().getTick() == replay.getTicks());
+    REQUIRE(player.getMatch().checksum() == expected);
+}
@@ -0,0 +1,185 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+#include "../libs/terminal.hpp"
+#include "../libs/game.hpp"
+#include "../libs/scheduler.hpp"
+#include <chrono>
+#include <thread>
+
+static void sleepNs(long long ns) {
+    std::this_thread::sleep_for(std::chrono::nanoseconds(ns));
+}
+
+// Deadline tests step this clock by hand instead of sleeping
+static long long fakeNs = 0;
+
+static long long fakeClock() {
+    return fakeNs;
+}
+
+TEST_CASE("Rates are clamped to 5..1000 Hz", "[scheduler]") {
+    TickScheduler schedule(2);
+    REQUIRE(schedule.getRate() == Approx(5));
+    REQUIRE(schedule.getPeriod() == 200000000);
+
+    schedule.setRate(5000);
+    REQUIRE(schedule.getRate() == Approx(1000));
+    REQUIRE(schedule.getPeriod() == 1000000);
+
+    TickScheduler standard;
+    REQUIRE(standard.getPeriod() == DELAY * 1000000LL);
+}
+
+TEST_CASE("Difficulty levels speed the ticks up", "[scheduler]") {
+    REQUIRE(tick_rate_for_level(1) == Approx(1000.0 / DELAY));
+    REQUIRE(tick_rate_for_level(2) > tick_rate_for_level(1));
+    REQUIRE(tick_rate_for_level(5) > tick_rate_for_level(3));
+}
+
+TEST_CASE("Ticks fire at absolute deadlines without drift", "[scheduler]") {
+    TickScheduler schedule(1000);
+    long long first = schedule.getDeadline();
+    REQUIRE_FALSE(schedule.poll());
+
+    long long worst = 0;
+    for (int i = 0; i < 200; i++) {
+        long long lateness;
+        do {
+            schedule.wait();
+        } while (!schedule.poll(lateness));
+        if (lateness > worst) worst = lateness;
+        // Work that eats part of the period does not move later deadlines
+        if (i % 10 == 0) sleepNs(300000);
+    }
+
+    // Every deadline on the grid was either run or dropped after a stall
+    long long steps = 200 + static_cast<long long>(schedule.getDropped());
+    REQUIRE(schedule.getTicks() == 200);
+    REQUIRE(schedule.getDeadline() == first + steps * schedule.getPeriod());
+    REQUIRE(TickScheduler::now() >= first + (steps - 1) * schedule.getPeriod());
+    WARN("worst lateness at 1000 Hz: " << worst / 1000 << " us, missed " << schedule.getMissed());
+}
+
+TEST_CASE("Missed deadlines are caught up back to back", "[scheduler]") {
+    fakeNs = 1000000000LL;
+    TickScheduler schedule(100, fakeClock);
+    long long first = schedule.getDeadline();
+    REQUIRE(first == fakeNs + 10000000);
+    fakeNs = first + 3 * schedule.getPeriod() + schedule.getPeriod() / 2;
+
+    // Deadlines 0..3 have passed: one tick is late, three were missed
+    int due = 0;
+    long long lateness;
+    while (schedule.poll(lateness)) {
+        REQUIRE(lateness == (3 - due) * schedule.getPeriod() + schedule.getPeriod() / 2);
+        due++;
+    }
+
+    REQUIRE(due == 4);
+    REQUIRE(schedule.getMissed() == 3);
+    REQUIRE(schedule.getDropped() == 0);
+    REQUIRE(schedule.getDeadline() == first + 4 * schedule.getPeriod());
+}
+
+TEST_CASE("Missed deadlines can be dropped instead", "[scheduler]") {
+    fakeNs = 1000000000LL;
+    TickScheduler schedule(100, fakeClock);
+    schedule.setPolicy(TICK_DROP);
+    long long first = schedule.getDeadline();
+    fakeNs = first + 3 * schedule.getPeriod() + schedule.getPeriod() / 2;
+
+    int due = 0;
+    while (schedule.poll()) due++;
+
+    REQUIRE(due == 1);
+    REQUIRE(schedule.getMissed() == 3);
+    REQUIRE(schedule.getDropped() == 3);
+    // Still on the same grid
+    REQUIRE(schedule.getDeadline() == first + 4 * schedule.getPeriod());
+}
+
+TEST_CASE("A long stall is dropped even when catching up", "[scheduler]") {
+    fakeNs = 1000000000LL;
+    TickScheduler schedule(100, fakeClock);
+    long long first = schedule.getDeadline();
+    fakeNs = first + 20 * schedule.getPeriod() + schedule.getPeriod() / 2;
+
+    int due = 0;
+    while (schedule.poll()) due++;
+
+    REQUIRE(due == 1);
+    REQUIRE(schedule.getMissed() == 20);
+    REQUIRE(schedule.getDropped() == 20);
+    REQUIRE(schedule.getDeadline() == first + 21 * schedule.getPeriod());
+
+    // MAX_CATCH_UP missed deadlines are still run
+    fakeNs = schedule.getDeadline() + TickScheduler::MAX_CATCH_UP * schedule.getPeriod();
+    due = 0;
+    while (schedule.poll()) due++;
+    REQUIRE(due == TickScheduler::MAX_CATCH_UP + 1);
+    REQUIRE(schedule.getDropped() == 20);
+}
+
+TEST_CASE("Nothing is due before the deadline, and wait() leaves a fake clock alone", "[scheduler]") {
+    fakeNs = 5000;
+    TickScheduler schedule(1000, fakeClock);
+    schedule.wait();
+    REQUIRE_FALSE(schedule.poll());
+
+    fakeNs = schedule.getDeadline() - 1;
+    REQUIRE_FALSE(schedule.poll());
+    fakeNs++;
+    long long lateness = -1;
+    REQUIRE(schedule.poll(lateness));
+    REQUIRE(lateness == 0);
+    REQUIRE(schedule.getMissed() == 0);
+    REQUIRE(schedule.getDeadline() == fakeNs + schedule.getPeriod());
+}
+
+TEST_CASE("A new rate applies from the pending deadline", "[scheduler]") {
+    TickScheduler schedule(10, fakeClock);
+    long long first = schedule.getDeadline();
+    schedule.setRate(20);
+    REQUIRE(schedule.getDeadline() == first - 50000000);
+}
+
+TEST_CASE("A game runs at its configured rate", "[scheduler]") {
+    MemorySink sink;
+    set_render_sink(&sink);
+    initscr(25, 80);
+
+    // No key waiting: getch() reads end of file
+    int fds[2];
+    REQUIRE(pipe(fds) == 0);
+    close(fds[1]);
+    dup2(fds[0], STDIN_FILENO);
+    close(fds[0]);
+
+    {
+        Game standard(1);
+        REQUIRE(standard.getScheduler().getPeriod() == DELAY * 1000000LL);
+    }
+
+    GameArena arena(Game::arenaBytes(25, 80));
+    TickConfig config;
+    config.rate = 200;
+    Game *game = arena.make<Game>(1, arena, config);
+    REQUIRE(game->getScheduler().getRate() == Approx(200));
+
+    // Ten ticks at 200 Hz: the snake moves right from (5,8) and stays alive
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    int ticks = 0;
+    while (ticks < 10) {
+        game->waitForTick();
+        REQUIRE_FALSE(game->isGameOver());
+        ticks = static_cast<int>(game->getScheduler().getTicks());
+    }
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    // Loose bounds: the deadline logic itself is tested on a fake clock
+    REQUIRE(ms >= 45);
+    REQUIRE(ms < 2000);
+    arena.rewind(GameArena::Mark());
+
+    cleanup_screen();
+    set_render_sink(nullptr);
+}
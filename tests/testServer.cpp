@@ -0,0 +1,146 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+#include "../libs/terminal.hpp"
+#include "../libs/server.hpp"
+#include <sys/time.h>
+#include <map>
+#include <string>
+#include <thread>
+
+struct Frame {
+    int type;
+    std::string payload;
+};
+
+static int connectClient(int port) {
+    sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<unsigned short>(port));
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    REQUIRE(connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) == 0);
+    timeval wait = { 2, 0 };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &wait, sizeof(wait));
+    return fd;
+}
+
+static bool readExactly(int fd, unsigned char *data, size_t size) {
+    size_t done = 0;
+    while (done < size) {
+        ssize_t n = recv(fd, data + done, size - done, 0);
+        if (n <= 0) return false;
+        done += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+static Frame readFrame(int fd) {
+    unsigned char header[FRAME_HEADER];
+    REQUIRE(readExactly(fd, header, sizeof(header)));
+    Frame frame;
+    frame.type = header[2];
+    std::string payload(netGet16(header) - 1, '\0');
+    REQUIRE(readExactly(fd, reinterpret_cast<unsigned char *>(&payload[0]), payload.size()));
+    frame.payload = payload;
+    return frame;
+}
+
+static unsigned long frameTick(const Frame &frame) {
+    return netGet32(reinterpret_cast<const unsigned char *>(frame.payload.data()));
+}
+
+// Applies a DELTA or KEYFRAME payload to `cells`, keyed row * 65536 + col
+static void applyCells(std::map<int, int> &cells, const Frame &frame, int rows, int cols) {
+    const unsigned char *p = reinterpret_cast<const unsigned char *>(frame.payload.data());
+    int count = static_cast<int>(netGet16(p + 4));
+    REQUIRE(frame.payload.size() == static_cast<size_t>(6 + count * CELL_ENTRY));
+    for (int i = 0; i < count; i++) {
+        const unsigned char *cell = p + 6 + i * CELL_ENTRY;
+        int row = static_cast<int>(netGet16(cell));
+        int col = static_cast<int>(netGet16(cell + 2));
+        REQUIRE(row >= 1);
+        REQUIRE(row < rows - 1);
+        REQUIRE(col >= 1);
+        REQUIRE(col < cols - 1);
+        if (cell[4] == CELL_EMPTY) cells.erase(row * 65536 + col);
+        else cells[row * 65536 + col] = cell[4];
+    }
+}
+
+TEST_CASE("A client joining a running match gets a welcome and a keyframe of it", "[server]") {
+    ServerConfig config;
+    config.port = 0;
+    config.matchesPerShard = 1;
+    config.clientsPerShard = 4;
+    config.tickMs = 20;
+
+    Shard shard(config, 0);
+    REQUIRE(shard.open());
+    std::atomic<bool> running(true);
+    std::thread loop(&Shard::run, &shard, std::cref(running));
+
+    // The first player starts the match and follows it for a few ticks
+    int first = connectClient(shard.getPort());
+    Frame welcome = readFrame(first);
+    REQUIRE(welcome.type == FRAME_WELCOME);
+    REQUIRE(welcome.payload[0] == 0);
+
+    std::map<int, int> seen;
+    Frame frame = readFrame(first);
+    REQUIRE(frame.type == FRAME_KEYFRAME);
+    applyCells(seen, frame, config.rows, config.cols);
+    for (int i = 0; i < 3; i++) {
+        frame = readFrame(first);
+        REQUIRE(frame.type == FRAME_DELTA);
+        applyCells(seen, frame, config.rows, config.cols);
+    }
+
+    // The second is seated in the same match, several ticks in
+    int second = connectClient(shard.getPort());
+    welcome = readFrame(second);
+    REQUIRE(welcome.type == FRAME_WELCOME);
+    REQUIRE(welcome.payload.size() == 9);
+    const unsigned char *w = reinterpret_cast<const unsigned char *>(welcome.payload.data());
+    REQUIRE(w[0] == 1);
+    REQUIRE(netGet16(w + 1) == static_cast<unsigned int>(config.rows));
+    REQUIRE(netGet16(w + 3) == static_cast<unsigned int>(config.cols));
+    REQUIRE(netGet32(w + 5) == 0);
+
+    Frame keyframe = readFrame(second);
+    REQUIRE(keyframe.type == FRAME_KEYFRAME);
+    unsigned long tick = frameTick(keyframe);
+    REQUIRE(tick >= 3);
+    std::map<int, int> joined;
+    applyCells(joined, keyframe, config.rows, config.cols);
+
+    // It shows what the first player has after the deltas up to the same tick
+    while (frameTick(frame) < tick) {
+        frame = readFrame(first);
+        REQUIRE(frame.type == FRAME_DELTA);
+        applyCells(seen, frame, config.rows, config.cols);
+    }
+    REQUIRE(frameTick(frame) == tick);
+    REQUIRE(joined == seen);
+    int snakeCells = 0;
+    for (std::map<int, int>::const_iterator it = joined.begin(); it != joined.end(); ++it) {
+        if (it->second == CELL_SNAKE) snakeCells++;
+    }
+    REQUIRE(snakeCells >= 3);
+    REQUIRE(shard.stats.dropped.load() == 0);
+
+    running = false;
+    loop.join();
+    close(first);
+    close(second);
+}
+
+TEST_CASE("Boards whose keyframe could overflow the frame length are refused", "[server]") {
+    REQUIRE(keyframeBound(24, 80) == FRAME_HEADER + 6 + 22 * 78 * CELL_ENTRY);
+    REQUIRE(boardFitsFrames(24, 80));
+    REQUIRE(boardFitsFrames(8, 2186));
+    REQUIRE_FALSE(boardFitsFrames(8, 2187));
+    REQUIRE_FALSE(boardFitsFrames(200, 200));
+    REQUIRE_FALSE(boardFitsFrames(100000, 100000));
+}
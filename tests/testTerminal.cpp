@@ -461,3 +461,59 @@ TEST_CASE("Key constants are distinct for each direction", "[terminal][key_disti
         }
     }
 }
+
+// ============================================================================
+// RENDER SINK TESTS
+// ============================================================================
+
+TEST_CASE("MemorySink captures the exact bytes of a refresh", "[terminal][sink]") {
+    MemorySink sink;
+    set_render_sink(&sink);
+    initscr(10, 20);
+    REQUIRE(LINES == 10);
+    REQUIRE(COLS == 20);
+    REQUIRE(sink.getData() == ANSI_CLEAR_SCREEN ANSI_CURSOR_HOME ANSI_RESET);
+
+    // First refresh paints every cell, later ones only what changed
+    refresh();
+    sink.clear();
+
+    attron(COLOR_PAIR(2) | A_BOLD);
+    mvaddch(1, 2, 'X');
+    attroff(COLOR_PAIR(2) | A_BOLD);
+    REQUIRE(sink.getData().empty());
+
+    refresh();
+    REQUIRE(sink.getData() == "\x1b[2;3H\x1b[0m\x1b[32m\x1b[1mX\x1b[0m");
+
+    sink.clear();
+    refresh();
+    REQUIRE(sink.getData().empty());
+
+    cleanup_screen();
+    set_render_sink(nullptr);
+}
+
+TEST_CASE("TeeSink and NullSink", "[terminal][sink]") {
+    MemorySink a;
+    MemorySink b;
+    TeeSink tee(a, b);
+    NullSink null;
+
+    set_render_sink(&tee);
+    REQUIRE(get_render_sink() == &tee);
+    initscr(4, 8);
+    mvprintw(0, 0, "hi");
+    refresh();
+    REQUIRE(!a.getData().empty());
+    REQUIRE(a.getData() == b.getData());
+
+    set_render_sink(&null);
+    mvprintw(1, 0, "ignored");
+    refresh();
+    REQUIRE(a.getData() == b.getData());
+
+    set_render_sink(nullptr);
+    REQUIRE(get_render_sink() != &null);
+    cleanup_screen();
+}
@@ -0,0 +1,155 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+#include "../libs/terminal.hpp"
+#include "../libs/game.hpp"
+#include "../libs/tickstats.hpp"
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <string>
+#include <thread>
+
+static std::string reportText(const TickStats &stats) {
+    char *buffer = nullptr;
+    size_t size = 0;
+    FILE *out = open_memstream(&buffer, &size);
+    stats.report(out);
+    fclose(out);
+    std::string text(buffer, size);
+    free(buffer);
+    return text;
+}
+
+TEST_CASE("Small values are recorded exactly", "[tickstats]") {
+    LatencyHistogram h;
+    for (int i = 1; i <= 100; i++) h.record(i);
+
+    REQUIRE(h.getCount() == 100);
+    REQUIRE(h.getMin() == 1);
+    REQUIRE(h.getMax() == 100);
+    REQUIRE(h.getMean() == Approx(50.5));
+    REQUIRE(h.percentile(50) == 50);
+    REQUIRE(h.percentile(99) == 99);
+    REQUIRE(h.percentile(100) == 100);
+}
+
+TEST_CASE("Large values keep about two significant digits", "[tickstats]") {
+    LatencyHistogram h;
+    // 1 us .. 100 ms in 1 us steps
+    for (long long us = 1; us <= 100000; us++) h.record(us * 1000);
+
+    const double percents[] = { 1, 50, 90, 99, 99.9 };
+    for (size_t i = 0; i < sizeof(percents) / sizeof(percents[0]); i++) {
+        double exact = percents[i] * 1000.0 * 1000.0;
+        double reported = static_cast<double>(h.percentile(percents[i]));
+        REQUIRE(reported >= exact * 0.999);
+        REQUIRE(reported <= exact * 1.016);
+    }
+    REQUIRE(h.percentile(100) == 100000000);
+}
+
+TEST_CASE("Out of range values are clamped, not lost", "[tickstats]") {
+    LatencyHistogram h;
+    h.record(-5);
+    h.record(1LL << 50);
+
+    REQUIRE(h.getCount() == 2);
+    REQUIRE(h.getMin() == 0);
+    REQUIRE(h.percentile(100) == (1LL << 40) - 1);
+
+    h.clear();
+    REQUIRE(h.getCount() == 0);
+    REQUIRE(h.percentile(99) == 0);
+}
+
+TEST_CASE("The report gives percentiles and the lateness verdict", "[tickstats]") {
+    TickStats stats;
+    for (int i = 0; i < 1000; i++) stats.metrics[TICK_LATENESS].record(i < 995 ? 20000 : 5000000);
+
+    std::string text = reportText(stats);
+    REQUIRE(text.find("p99.9") != std::string::npos);
+    REQUIRE(text.find("lateness") != std::string::npos);
+    REQUIRE(text.find("flush") != std::string::npos);
+    REQUIRE(text.find(": ok") != std::string::npos);
+
+    for (int i = 0; i < 20; i++) stats.metrics[TICK_LATENESS].record(5000000);
+    REQUIRE(reportText(stats).find(": over") != std::string::npos);
+}
+
+TEST_CASE("A game tick records every metric and answers SIGUSR1", "[tickstats]") {
+    MemorySink sink;
+    set_render_sink(&sink);
+    initscr(25, 80);
+
+    // No key waiting: getch() reads end of file
+    int fds[2];
+    REQUIRE(pipe(fds) == 0);
+    close(fds[1]);
+    dup2(fds[0], STDIN_FILENO);
+    close(fds[0]);
+
+    char *buffer = nullptr;
+    size_t size = 0;
+    FILE *dumps = open_memstream(&buffer, &size);
+
+    TickStats stats;
+    g_tick_stats = &stats;
+    g_tick_stats_out = dumps;
+    signal(SIGUSR1, tick_stats_request);
+    {
+        Game game(1);
+        stats.clear();
+        raise(SIGUSR1);
+        REQUIRE_FALSE(game.isGameOver());   // not due yet: nothing printed
+        fflush(dumps);
+        REQUIRE(size == 0);
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(DELAY + 5));
+        REQUIRE_FALSE(game.isGameOver());
+    }
+    // Frames outside a tick, like the menu's, are not timed
+    refresh();
+    g_tick_stats = nullptr;
+    g_tick_stats_out = nullptr;
+    signal(SIGUSR1, SIG_DFL);
+    fclose(dumps);
+    std::string dumped(buffer, size);
+    free(buffer);
+
+    for (int i = 0; i < TICK_METRICS; i++) REQUIRE(stats.metrics[i].getCount() == 1);
+    // The tick was polled for 5 ms after its deadline, and is late by that
+    REQUIRE(stats.metrics[TICK_LATENESS].getMax() >= 4000000);
+    REQUIRE(dumped.find("lateness") != std::string::npos);
+    REQUIRE(g_tick_stats_requested == 0);
+
+    cleanup_screen();
+    set_render_sink(nullptr);
+}
+
+TEST_CASE("A SIGUSR1 report with nowhere to go is dropped, not written to stderr", "[tickstats]") {
+    // stderr is the game's terminal here: catch anything written to it
+    int fds[2];
+    REQUIRE(pipe(fds) == 0);
+    int savedErr = dup(STDERR_FILENO);
+    dup2(fds[1], STDERR_FILENO);
+    close(fds[1]);
+
+    TickStats stats;
+    g_tick_stats = &stats;
+    g_tick_stats_out = nullptr;
+    signal(SIGUSR1, tick_stats_request);
+    raise(SIGUSR1);
+    REQUIRE(g_tick_stats_requested == 1);
+    stats.beginTick(0);
+    tick_stats_end_tick();
+    g_tick_stats = nullptr;
+    signal(SIGUSR1, SIG_DFL);
+
+    fflush(stderr);
+    dup2(savedErr, STDERR_FILENO);
+    close(savedErr);
+    char buffer[64];
+    REQUIRE(read(fds[0], buffer, sizeof(buffer)) == 0);   // end of file, nothing written
+    close(fds[0]);
+    REQUIRE(g_tick_stats_requested == 0);
+}
@@ -0,0 +1,177 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+#include "../libs/terminal.hpp"
+#include "../libs/game.hpp"
+#include "../libs/trace.hpp"
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct Span {
+    std::string name;
+    int tid;
+    double ts;
+    double dur;
+};
+
+// Reads back the complete spans of trace_json()
+static std::vector<Span> parseSpans(const std::string &json) {
+    std::vector<Span> spans;
+    std::istringstream lines(json);
+    std::string line;
+    while (std::getline(lines, line)) {
+        char name[64];
+        Span span;
+        if (sscanf(line.c_str(), "{\"name\": \"%63[^\"]\", \"ph\": \"X\", \"pid\": 1, \"tid\": %d, \"ts\": %lf, \"dur\": %lf}",
+                   name, &span.tid, &span.ts, &span.dur) == 4) {
+            span.name = name;
+            spans.push_back(span);
+        }
+    }
+    return spans;
+}
+
+static std::vector<Span> recordedSpans() {
+    std::string json;
+    trace_json(json);
+    return parseSpans(json);
+}
+
+static int countNamed(const std::vector<Span> &spans, const char *name) {
+    int count = 0;
+    for (size_t i = 0; i < spans.size(); i++) {
+        if (spans[i].name == name) count++;
+    }
+    return count;
+}
+
+TEST_CASE("Scopes record nothing until tracing starts", "[trace]") {
+    trace_stop();
+    trace_clear();
+    {
+        TRACE_SCOPE("ignored");
+    }
+    REQUIRE(recordedSpans().empty());
+}
+
+TEST_CASE("Nested scopes become nested complete events", "[trace]") {
+    trace_start();
+    trace_clear();
+    {
+        TRACE_SCOPE("outer");
+        {
+            TRACE_SCOPE("inner");
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+    }
+    trace_stop();
+
+    std::vector<Span> spans = recordedSpans();
+    REQUIRE(spans.size() == 2);
+    // Spans are stored as they end: inner first
+    REQUIRE(spans[0].name == "inner");
+    REQUIRE(spans[1].name == "outer");
+    REQUIRE(spans[0].dur >= 2000);
+    REQUIRE(spans[1].ts <= spans[0].ts);
+    REQUIRE(spans[1].ts + spans[1].dur >= spans[0].ts + spans[0].dur);
+}
+
+TEST_CASE("Every thread writes its own named ring", "[trace]") {
+    trace_start();
+    trace_clear();
+    trace_set_thread_name("main");
+    {
+        TRACE_SCOPE("on-main");
+    }
+    std::thread worker([]() {
+        trace_set_thread_name("worker");
+        for (int i = 0; i < 100; i++) {
+            TRACE_SCOPE("on-worker");
+        }
+    });
+    worker.join();
+    trace_stop();
+
+    std::string json;
+    trace_json(json);
+    REQUIRE(json.find("\"args\": {\"name\": \"main\"}") != std::string::npos);
+    REQUIRE(json.find("\"args\": {\"name\": \"worker\"}") != std::string::npos);
+
+    std::vector<Span> spans = parseSpans(json);
+    REQUIRE(countNamed(spans, "on-main") == 1);
+    REQUIRE(countNamed(spans, "on-worker") == 100);
+    int mainTid = -1;
+    for (size_t i = 0; i < spans.size(); i++) {
+        if (spans[i].name == "on-main") mainTid = spans[i].tid;
+    }
+    for (size_t i = 0; i < spans.size(); i++) {
+        if (spans[i].name == "on-worker") REQUIRE(spans[i].tid != mainTid);
+    }
+}
+
+TEST_CASE("A full ring keeps the newest spans", "[trace]") {
+    // Rings are sized when a thread first records, so use a fresh thread
+    trace_start(8);
+    trace_clear();
+    std::thread worker([]() {
+        static const char *names[20] = { "s0", "s1", "s2", "s3", "s4", "s5", "s6", "s7", "s8", "s9",
+                                         "s10", "s11", "s12", "s13", "s14", "s15", "s16", "s17", "s18", "s19" };
+        for (int i = 0; i < 20; i++) {
+            TRACE_SCOPE(names[i]);
+        }
+    });
+    worker.join();
+    trace_stop();
+
+    std::vector<Span> spans = recordedSpans();
+    REQUIRE(spans.size() == 8);
+    REQUIRE(spans.front().name == "s12");
+    REQUIRE(spans.back().name == "s19");
+    REQUIRE(trace_dropped() == 12);
+}
+
+TEST_CASE("A game tick records each of its phases", "[trace]") {
+    MemorySink sink;
+    set_render_sink(&sink);
+    initscr(25, 80);
+
+    // No key waiting: getch() reads end of file
+    int fds[2];
+    REQUIRE(pipe(fds) == 0);
+    close(fds[1]);
+    dup2(fds[0], STDIN_FILENO);
+    close(fds[0]);
+
+    trace_start();
+    trace_clear();
+    {
+        Game game(1);
+        REQUIRE_FALSE(game.isGameOver());
+        std::this_thread::sleep_for(std::chrono::milliseconds(DELAY + 5));
+        REQUIRE_FALSE(game.isGameOver());
+    }
+    trace_stop();
+
+    std::vector<Span> spans = recordedSpans();
+    REQUIRE(countNamed(spans, "tick") == 1);
+    REQUIRE(countNamed(spans, "input") == 1);
+    REQUIRE(countNamed(spans, "direction") == 1);
+    REQUIRE(countNamed(spans, "collision") == 1);
+    REQUIRE(countNamed(spans, "draw") == 1);
+    REQUIRE(countNamed(spans, "refresh") == 1);
+    REQUIRE(countNamed(spans, "food") >= 1);
+
+    std::string path = "/tmp/tsnake-test-" + std::to_string(getpid()) + ".json";
+    REQUIRE(trace_write(path.c_str()));
+    std::ifstream file(path.c_str());
+    std::string first;
+    std::getline(file, first);
+    REQUIRE(first.find("\"traceEvents\": [") != std::string::npos);
+    std::remove(path.c_str());
+
+    cleanup_screen();
+    set_render_sink(nullptr);
+}
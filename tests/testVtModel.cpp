@@ -0,0 +1,174 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+#include "../libs/terminal.hpp"
+#include "../libs/matchview.hpp"
+#include "../libs/menu.hpp"
+#include "vtmodel.hpp"
+#include <string>
+
+// Renders into a MemorySink and feeds every frame to a VtModel
+struct ModelScreen {
+    MemorySink sink;
+    VtModel model;
+
+    ModelScreen(int lines, int cols) : model(lines, cols) {
+        set_render_sink(&sink);
+        initscr(lines, cols);
+        flush();
+    }
+
+    ~ModelScreen() {
+        cleanup_screen();
+        set_render_sink(nullptr);
+    }
+
+    void flush() {
+        model.feed(sink.getData());
+        sink.clear();
+    }
+
+    // refresh() and check that the terminal now shows the screen buffer
+    VtStats refreshAndCheck() {
+        refresh();
+        flush();
+        std::string why;
+        bool same = model.matchesScreen(why);
+        INFO(why);
+        REQUIRE(same);
+        return model.takeFrame();
+    }
+};
+
+// Menu input comes from a pipe holding `keys`, then end of file
+static void feedStdin(const std::string &keys) {
+    int fds[2];
+    REQUIRE(pipe(fds) == 0);
+    REQUIRE(write(fds[1], keys.data(), keys.size()) == static_cast<ssize_t>(keys.size()));
+    close(fds[1]);
+    dup2(fds[0], STDIN_FILENO);
+    close(fds[0]);
+}
+
+TEST_CASE("VtModel follows moves, colors and erases", "[vtmodel]") {
+    VtModel model(4, 10);
+    model.feed("\x1b[2;3H\x1b[0m\x1b[32m\x1b[1mX\x1b[0mY");
+    REQUIRE(model.at(1, 2) == ColoredChar('X', COLOR_GREEN, -1, A_BOLD));
+    REQUIRE(model.at(1, 3) == ColoredChar('Y', -1, -1, 0));
+
+    model.feed("\x1b[44m\x1b[2K\x1b[0m");
+    REQUIRE(model.at(1, 2) == ColoredChar(' ', -1, COLOR_BLUE, 0));
+    REQUIRE(model.at(0, 0) == ColoredChar(' ', -1, -1, 0));
+
+    // Relative moves and the pending wrap at the right margin
+    model.feed("\x1b[1;10Hab\x1b[3;5H\x1b[2Cc\x1b[A\x1b[3Dd");
+    REQUIRE(model.at(0, 9).ch == 'a');
+    REQUIRE(model.at(1, 0).ch == 'b');
+    REQUIRE(model.at(2, 6).ch == 'c');
+    REQUIRE(model.at(1, 4).ch == 'd');
+
+    model.feed("\x1b[?25l\x1b[2J\x1b[H");
+    REQUIRE(model.at(2, 6).ch == ' ');
+
+    VtStats stats = model.getTotal();
+    REQUIRE(stats.unknown == 0);
+    REQUIRE(stats.moves == 7);
+    REQUIRE(stats.erases == 2);
+    REQUIRE(stats.printed == 6);
+}
+
+TEST_CASE("VtModel counts what it does not understand", "[vtmodel]") {
+    VtModel model(4, 10);
+    model.feed("\x1b" "7\x1b[5S\x01");
+    REQUIRE(model.getTotal().unknown == 3);
+}
+
+TEST_CASE("Every refresh of a match reproduces the screen buffer", "[vtmodel]") {
+    ModelScreen screen(25, 60);
+    Match match(24, 60, 3, 2, 2024);
+    MatchView view(match);
+    const int turns[4] = { UP, LEFT, DOWN, RIGHT };
+
+    view.drawBoard();
+    VtStats first = screen.refreshAndCheck();
+    REQUIRE(first.unknown == 0);
+
+    VtStats steady;
+    int steadyFrames = 0;
+    for (int t = 0; t < 400 && !match.isOver(); t++) {
+        if (t % 6 == 0) match.setDirection(t % 3, turns[(t / 6) % 4]);
+        match.step();
+        view.drawDirty();
+
+        VtStats frame = screen.refreshAndCheck();
+        REQUIRE(frame.unknown == 0);
+        // Only the touched cells go out: one move per printed cell
+        REQUIRE(frame.moves == frame.printed);
+        REQUIRE(frame.printed <= match.getDirty().size() + COLS);
+        steady.bytes += frame.bytes;
+        steadyFrames++;
+    }
+    REQUIRE(steadyFrames > 0);
+    REQUIRE(steady.bytes / steadyFrames < first.bytes / 10);
+
+    view.printGameOver("Play again? (y/n)");
+    screen.refreshAndCheck();
+
+    // Nothing changed, nothing sent
+    VtStats idle = screen.refreshAndCheck();
+    REQUIRE(idle.bytes == 0);
+    REQUIRE(idle.sequences == 0);
+}
+
+TEST_CASE("Full clears and keyframes rebuild the same screen", "[vtmodel]") {
+    ModelScreen screen(21, 40);
+    Match match(20, 40, 2, 1, 99);
+    MatchView view(match);
+
+    view.drawBoard();
+    screen.refreshAndCheck();
+    for (int t = 0; t < 20; t++) {
+        match.step();
+        view.drawDirty();
+        screen.refreshAndCheck();
+    }
+
+    // clear() forces every cell out again
+    clear();
+    view.drawBoard();
+    VtStats redraw = screen.refreshAndCheck();
+    REQUIRE(redraw.printed == static_cast<size_t>(LINES * COLS));
+
+    // full_clear_screen() wipes the terminal itself
+    full_clear_screen();
+    view.drawBoard();
+    VtStats wiped = screen.refreshAndCheck();
+    REQUIRE(wiped.erases == 1);
+
+    // A spectator joining late only gets the keyframe
+    std::string keyframe;
+    encode_keyframe(keyframe);
+    VtModel late(LINES, COLS);
+    late.feed(keyframe);
+    std::string why;
+    bool same = late.matchesScreen(why);
+    INFO(why);
+    REQUIRE(same);
+    REQUIRE(late.getTotal().unknown == 0);
+}
+
+TEST_CASE("Menu frames reproduce the screen buffer", "[vtmodel]") {
+    ModelScreen screen(30, 80);
+    Menu menu;
+
+    // Two moves down, then the menu only animates
+    feedStdin("\x1b[B\x1b[B");
+    for (int i = 0; i < 5; i++) {
+        REQUIRE(menu.showMainMenu(42) == -1);
+        screen.flush();
+        std::string why;
+        bool same = screen.model.matchesScreen(why);
+        INFO(why);
+        REQUIRE(same);
+        REQUIRE(screen.model.takeFrame().unknown == 0);
+    }
+}
@@ -0,0 +1,261 @@
+#ifndef VTMODEL_H_
+#define VTMODEL_H_
+
+#include <string>
+#include <vector>
+#include "../libs/terminal.hpp"
+
+/**
+ * Output counters of one frame (or of everything fed so far)
+ */
+struct VtStats {
+    size_t bytes;
+    size_t sequences;  // every escape sequence
+    size_t moves;      // absolute and relative cursor moves
+    size_t sgr;        // color and attribute changes
+    size_t erases;     // screen and line clears
+    size_t printed;    // characters drawn
+    size_t unknown;    // sequences the model does not understand
+
+    VtStats() : bytes(0), sequences(0), moves(0), sgr(0), erases(0), printed(0), unknown(0) {}
+};
+
+/**
+ * A small VT100/xterm screen model for the tests.
+ *
+ * It consumes the bytes the renderer writes and keeps the grid a real
+ * terminal would show, in the same ColoredChar form as g_screen_buffer, so
+ * a test can check after every refresh() that what was sent reproduces
+ * what was drawn. It understands what the renderer may emit: printable
+ * ASCII, CR/LF/BS, cursor positioning (CUP, CUU/CUD/CUF/CUB, CHA, VPA),
+ * SGR (reset, bold, blink, reverse, the 8 colors and defaults, 256 and
+ * RGB colors), ED/EL/ECH erases and private modes such as cursor
+ * visibility. Anything else is counted as unknown.
+ *
+ * Erases use the current background, as xterm does (bce).
+ */
+class VtModel {
+
+    enum State { GROUND, ESCAPE, CSI };
+
+    int rows;
+    int cols;
+    std::vector<ColoredChar> cells;
+
+    int y;
+    int x;
+    bool wrapPending;
+    ColoredChar pen;
+
+    State state;
+    bool privateMode;
+    std::string params;
+
+    VtStats frame;
+    VtStats total;
+
+    int param(size_t index, int fallback) const {
+        std::vector<int> values = paramList();
+        return index < values.size() && values[index] > 0 ? values[index] : fallback;
+    }
+
+    std::vector<int> paramList() const {
+        std::vector<int> values(1, 0);
+        for (size_t i = 0; i < params.size(); i++) {
+            if (params[i] == ';') values.push_back(0);
+            else values.back() = values.back() * 10 + (params[i] - '0');
+        }
+        return values;
+    }
+
+    void moveTo(int row, int col) {
+        y = row < 0 ? 0 : (row >= rows ? rows - 1 : row);
+        x = col < 0 ? 0 : (col >= cols ? cols - 1 : col);
+        wrapPending = false;
+        count(&VtStats::moves);
+    }
+
+    void count(size_t VtStats::*field) {
+        frame.*field += 1;
+        total.*field += 1;
+    }
+
+    void erase(int from, int to) {
+        ColoredChar blank(' ', -1, pen.bg, 0);
+        for (int i = from; i < to; i++) cells[i] = blank;
+        count(&VtStats::erases);
+    }
+
+    void print(char c) {
+        if (wrapPending) {
+            x = 0;
+            if (y < rows - 1) y++;
+            wrapPending = false;
+        }
+        cells[y * cols + x] = ColoredChar(c, pen.fg, pen.bg, pen.attr);
+        count(&VtStats::printed);
+        if (x == cols - 1) wrapPending = true;
+        else x++;
+    }
+
+    void selectGraphics() {
+        std::vector<int> values = paramList();
+        count(&VtStats::sgr);
+        for (size_t i = 0; i < values.size(); i++) {
+            int v = values[i];
+            if (v == 0) pen = ColoredChar(' ', -1, -1, 0);
+            else if (v == 1) pen.attr |= A_BOLD;
+            else if (v == 5) pen.attr |= A_BLINK;
+            else if (v == 7) pen.attr |= A_REVERSE;
+            else if (v == 22) pen.attr &= ~A_BOLD;
+            else if (v == 25) pen.attr &= ~A_BLINK;
+            else if (v == 27) pen.attr &= ~A_REVERSE;
+            else if (v >= 30 && v <= 37) pen.fg = v - 30;
+            else if (v == 39) pen.fg = -1;
+            else if (v >= 40 && v <= 47) pen.bg = v - 40;
+            else if (v == 49) pen.bg = -1;
+            else if (v == 38 || v == 48) {
+                // 38;5;N or 38;2;R;G;B, kept as the index (or -2 for RGB)
+                int color = -2;
+                if (i + 2 < values.size() && values[i + 1] == 5) {
+                    color = values[i + 2];
+                    i += 2;
+                } else if (i + 4 < values.size() && values[i + 1] == 2) {
+                    i += 4;
+                }
+                if (v == 38) pen.fg = color;
+                else pen.bg = color;
+            } else {
+                count(&VtStats::unknown);
+            }
+        }
+    }
+
+    void dispatch(char final) {
+        if (privateMode) {
+            // ?25l / ?25h and other modes do not change the grid
+            if (final != 'h' && final != 'l') count(&VtStats::unknown);
+            return;
+        }
+        int at = y * cols + x;
+        switch (final) {
+            case 'H':
+            case 'f': moveTo(param(0, 1) - 1, param(1, 1) - 1); break;
+            case 'A': moveTo(y - param(0, 1), x); break;
+            case 'B': moveTo(y + param(0, 1), x); break;
+            case 'C': moveTo(y, x + param(0, 1)); break;
+            case 'D': moveTo(y, x - param(0, 1)); break;
+            case 'G': moveTo(y, param(0, 1) - 1); break;
+            case 'd': moveTo(param(0, 1) - 1, x); break;
+            case 'm': selectGraphics(); break;
+            case 'J': {
+                int mode = paramList()[0];
+                if (mode == 0) erase(at, rows * cols);
+                else if (mode == 1) erase(0, at + 1);
+                else erase(0, rows * cols);
+                break;
+            }
+            case 'K': {
+                int mode = paramList()[0];
+                int start = y * cols;
+                if (mode == 0) erase(at, start + cols);
+                else if (mode == 1) erase(start, at + 1);
+                else erase(start, start + cols);
+                break;
+            }
+            case 'X': {
+                int end = at + param(0, 1);
+                erase(at, end > (y + 1) * cols ? (y + 1) * cols : end);
+                break;
+            }
+            default: count(&VtStats::unknown); break;
+        }
+    }
+
+public:
+
+    VtModel(int rows, int cols)
+        : rows(rows), cols(cols), cells(rows * cols), y(0), x(0), wrapPending(false),
+          state(GROUND), privateMode(false) {}
+
+    void feed(const char *bytes, size_t length) {
+        frame.bytes += length;
+        total.bytes += length;
+
+        for (size_t i = 0; i < length; i++) {
+            char c = bytes[i];
+            if (state == ESCAPE) {
+                if (c == '[') {
+                    state = CSI;
+                    privateMode = false;
+                    params.clear();
+                } else {
+                    // Two-byte sequences (ESC 7, ESC 8, ...) are not emitted
+                    count(&VtStats::unknown);
+                    state = GROUND;
+                }
+            } else if (state == CSI) {
+                if (c == '?') privateMode = true;
+                else if ((c >= '0' && c <= '9') || c == ';') params += c;
+                else {
+                    count(&VtStats::sequences);
+                    dispatch(c);
+                    state = GROUND;
+                }
+            } else if (c == '\x1b') {
+                state = ESCAPE;
+            } else if (c == '\r') {
+                moveTo(y, 0);
+            } else if (c == '\n') {
+                moveTo(y + 1, x);
+            } else if (c == '\b') {
+                moveTo(y, x - 1);
+            } else if (c >= ' ' && c <= '~') {
+                print(c);
+            } else {
+                count(&VtStats::unknown);
+            }
+        }
+    }
+
+    void feed(const std::string &bytes) { feed(bytes.data(), bytes.size()); }
+
+    /**
+     * @brief Returns the counters since the last call and starts a new frame
+     */
+    VtStats takeFrame() {
+        VtStats last = frame;
+        frame = VtStats();
+        return last;
+    }
+
+    const VtStats &getTotal() const { return total; }
+
+    const ColoredChar &at(int row, int col) const { return cells[row * cols + col]; }
+
+    /**
+     * @brief Compares the grid with g_screen_buffer, describing the first mismatch
+     */
+    bool matchesScreen(std::string &why) const {
+        if (rows != LINES || cols != COLS) {
+            why = "screen size differs";
+            return false;
+        }
+        for (int row = 0; row < rows; row++) {
+            for (int col = 0; col < cols; col++) {
+                const ColoredChar &shown = at(row, col);
+                const ColoredChar &drawn = g_screen_buffer[row][col];
+                if (shown != drawn) {
+                    char text[160];
+                    snprintf(text, sizeof(text), "(%d,%d): terminal shows '%c' fg %d bg %d attr %d, buffer has '%c' fg %d bg %d attr %d",
+                             row, col, shown.ch, shown.fg, shown.bg, shown.attr, drawn.ch, drawn.fg, drawn.bg, drawn.attr);
+                    why = text;
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+};
+
+#endif
@@ -0,0 +1,209 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <new>
+#include <string>
+#include <vector>
+#include "./libs/match.hpp"
+
+using namespace std::chrono;
+
+// Tick throughput of one headless game, without any rendering
+
+// Every operator new in this process goes through here. Kept out of line
+// so inlining never pairs a new expression with the free() below.
+static unsigned long g_allocations = 0;
+
+__attribute__((noinline)) void *operator new(size_t size) {
+    g_allocations++;
+    void *p = std::malloc(size ? size : 1);
+    if (p == nullptr) throw std::bad_alloc();
+    return p;
+}
+
+__attribute__((noinline)) void operator delete(void *p) noexcept {
+    std::free(p);
+}
+
+struct Size {
+    int cols;
+    int rows;
+};
+
+/**
+ * Direction to take in every cell so the snake follows a Hamiltonian cycle
+ * of the board's interior: along the top row, serpentine through the rest
+ * and back up the first column. A snake on it never dies, whatever its
+ * length, so long snakes can run for as many ticks as needed. `forward`
+ * picks which way round the cycle goes.
+ */
+std::vector<char> cycleDirections(int rows, int cols, bool forward) {
+    int height = rows - 2;
+    int width = cols - 2;
+    std::vector<int> order;
+    order.reserve(height * width);
+
+    for (int j = 0; j < width; j++) order.push_back(1 * cols + (j + 1));
+    for (int i = 1; i < height; i++) {
+        for (int k = 1; k < width; k++) {
+            int j = i % 2 == 1 ? width - k : k;
+            order.push_back((i + 1) * cols + (j + 1));
+        }
+    }
+    for (int i = height - 1; i >= 1; i--) order.push_back((i + 1) * cols + 1);
+
+    std::vector<char> directions(rows * cols, static_cast<char>(RIGHT));
+    int n = static_cast<int>(order.size());
+    for (int k = 0; k < n; k++) {
+        int from = order[k];
+        int to = order[forward ? (k + 1) % n : (k - 1 + n) % n];
+        int dx = to / cols - from / cols;
+        int dy = to % cols - from % cols;
+        directions[from] = static_cast<char>(dx > 0 ? DOWN : dx < 0 ? UP : dy > 0 ? RIGHT : LEFT);
+    }
+    return directions;
+}
+
+struct Run {
+    unsigned long ticks;
+    double seconds;
+    unsigned long allocations;
+    double length;  // average snake length while measured
+    unsigned long eaten;
+};
+
+/**
+ * @brief Times `ticks` steps of a single snake of about `length` cells
+ *
+ * The snake is grown to length along the cycle first (not timed). Eating
+ * still lengthens it; once it is 5% of the board longer than asked for,
+ * the game is set up again.
+ */
+Run measure(const Size &size, int length, unsigned long ticks, unsigned int seed) {
+    Match match(size.rows, size.cols, 1, 1, seed);
+
+    // The snake spawns heading right: pick the way round that agrees
+    int spawnRow = match.getSnake(0).getHead().getX() - 1;
+    std::vector<char> directions = cycleDirections(size.rows, size.cols, spawnRow % 2 == 0);
+    const Grid &grid = match.getGrid();
+    int cap = length + (size.rows - 2) * (size.cols - 2) / 20;
+
+    Run run = { 0, 0, 0, 0, 0 };
+    double lengthSum = 0;
+    bool setup = true;
+    while (run.ticks < ticks) {
+        if (setup) {
+            match.reset(seed++);
+            match.grow(0, length - match.getSnake(0).getSize());
+            while (match.getSnake(0).getSize() < length && !match.isOver()) {
+                match.setDirection(0, directions[grid.index(match.getSnake(0).getHead())]);
+                match.step();
+            }
+            setup = false;
+        }
+
+        int startScore = match.getScore(0);
+        unsigned long allocations = g_allocations;
+        unsigned long done = 0;
+        steady_clock::time_point start = steady_clock::now();
+        while (run.ticks + done < ticks) {
+            match.setDirection(0, directions[grid.index(match.getSnake(0).getHead())]);
+            match.step();
+            done++;
+            if (match.isOver() || match.getSnake(0).getSize() > cap) {
+                setup = true;
+                break;
+            }
+        }
+        run.seconds += duration<double>(steady_clock::now() - start).count();
+        run.allocations += g_allocations - allocations;
+        run.ticks += done;
+        run.eaten += match.getScore(0) - startScore;
+        lengthSum += static_cast<double>(match.getSnake(0).getSize()) * done;
+    }
+    run.length = lengthSum / run.ticks;
+    return run;
+}
+
+std::vector<Size> parseSizes(const char *text) {
+    std::vector<Size> sizes;
+    while (*text) {
+        Size size;
+        if (sscanf(text, "%dx%d", &size.cols, &size.rows) == 2) {
+            // The cycle needs an even number of interior rows
+            if (size.rows % 2 != 0) size.rows++;
+            sizes.push_back(size);
+        }
+        const char *comma = std::strchr(text, ',');
+        if (!comma) break;
+        text = comma + 1;
+    }
+    return sizes;
+}
+
+std::vector<int> parseList(const char *text) {
+    std::vector<int> values;
+    while (*text) {
+        values.push_back(std::atoi(text));
+        const char *comma = std::strchr(text, ',');
+        if (!comma) break;
+        text = comma + 1;
+    }
+    return values;
+}
+
+void usage(const char *name) {
+    printf("Usage: %s [--sizes=40x20,400x200,1000x500,4000x2000] [--fill=0,10,50,90]\n", name);
+    printf("          [--ticks=200000] [--seed=N]\n");
+}
+
+int main(int argc, char **argv) {
+
+    std::vector<Size> sizes = parseSizes("40x20,400x200,1000x500,4000x2000");
+    std::vector<int> fills = parseList("0,10,50,90");
+    unsigned long ticks = 200000;
+    unsigned int seed = 42;
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        if (std::strncmp(arg, "--sizes=", 8) == 0) sizes = parseSizes(arg + 8);
+        else if (std::strncmp(arg, "--fill=", 7) == 0) fills = parseList(arg + 7);
+        else if (std::strncmp(arg, "--ticks=", 8) == 0) ticks = std::strtoul(arg + 8, nullptr, 10);
+        else if (std::strncmp(arg, "--seed=", 7) == 0) seed = std::strtoul(arg + 7, nullptr, 10);
+        else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (ticks < 1) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    // Games per core: how many DELAY ms tick loops one core could drive
+    printf("Single snake tick, %lu ticks per run (fill = snake length / interior cells)\n", ticks);
+    printf("%11s %5s %10s %12s %10s %12s %10s %12s\n",
+           "board", "fill", "length", "ticks/s", "ns/tick", "allocs/tick", "eaten", "games/core");
+
+    for (size_t s = 0; s < sizes.size(); s++) {
+        const Size &size = sizes[s];
+        if (size.cols < 8 || size.rows < 8) continue;
+        int cells = (size.rows - 2) * (size.cols - 2);
+
+        for (size_t f = 0; f < fills.size(); f++) {
+            int length = static_cast<int>(static_cast<long long>(cells) * fills[f] / 100);
+            if (length < 3) length = 3;
+            if (length > cells - cells / 20 - 2) continue;  // leave room to eat
+
+            Run run = measure(size, length, ticks, seed);
+            double perSecond = run.ticks / run.seconds;
+            char board[32];
+            snprintf(board, sizeof(board), "%dx%d", size.cols, size.rows);
+            printf("%11s %4d%% %10.0f %12.0f %10.1f %12.2f %10lu %12.0f\n",
+                   board, fills[f], run.length, perSecond, run.seconds * 1e9 / run.ticks,
+                   static_cast<double>(run.allocations) / run.ticks, run.eaten, perSecond * DELAY / 1000.0);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,234 @@
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/wait.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include "./libs/terminal.hpp"
+#include "./libs/matchview.hpp"
+#include "./libs/replay.hpp"
+#include "./libs/recorder.hpp"
+
+// Offline transcoder: re-simulates saved replays and renders them headless
+
+struct Totals {
+    unsigned long replays;
+    unsigned long failed;
+    unsigned long ticks;
+    unsigned long frames;
+    unsigned long bytes;
+    double seconds;
+};
+
+/**
+ * Collects the rendered frames as an asciicast or a raw dump
+ */
+class FrameSink {
+
+    bool cast;
+    std::string out;
+
+public:
+
+    FrameSink(bool cast, int width, int height) : cast(cast) {
+        if (cast) appendCastHeader(out, width, height, 0);
+    }
+
+    // Raw dump record: u32 tick, u32 length, bytes
+    void frame(unsigned long tick, const std::string &bytes) {
+        if (cast) {
+            appendCastEvent(out, tick * DELAY / 1000.0, "o", bytes.data(), bytes.size());
+            return;
+        }
+        unsigned char header[8];
+        netPut32(header, static_cast<unsigned int>(tick));
+        netPut32(header + 4, static_cast<unsigned int>(bytes.size()));
+        out.append(reinterpret_cast<char *>(header), sizeof(header));
+        out += bytes;
+    }
+
+    bool save(const std::string &path) const {
+        FILE *file = fopen(path.c_str(), "wb");
+        if (file == nullptr) return false;
+        bool ok = fwrite(out.data(), 1, out.size(), file) == out.size();
+        return fclose(file) == 0 && ok;
+    }
+};
+
+bool transcode(const std::string &input, const std::string &output, bool cast, Totals &totals) {
+    Replay replay;
+    if (!replay.load(input.c_str())) return false;
+
+    // The status bar sits above the board, like in the game
+    MemorySink screen;
+    set_render_sink(&screen);
+    initscr(replay.getRows() + 1, replay.getCols());
+    screen.clear();
+
+    ReplayPlayer player(replay);
+    MatchView view(player.getMatch());
+    FrameSink sink(cast, COLS, LINES);
+
+    view.drawBoard();
+    refresh();
+    sink.frame(0, screen.getData());
+    totals.frames++;
+    totals.bytes += screen.getData().size();
+
+    while (!player.isDone()) {
+        player.step();
+        view.drawDirty();
+        if (player.isDone()) view.printGameOver("Replay finished");
+
+        screen.clear();
+        refresh();
+        sink.frame(player.getMatch().getTick(), screen.getData());
+        totals.frames++;
+        totals.bytes += screen.getData().size();
+    }
+    set_render_sink(nullptr);
+    totals.ticks += player.getMatch().getTick();
+    cleanup_screen();
+
+    return sink.save(output);
+}
+
+std::string baseName(const std::string &path) {
+    size_t slash = path.rfind('/');
+    std::string name = slash == std::string::npos ? path : path.substr(slash + 1);
+    size_t dot = name.rfind('.');
+    return dot == std::string::npos ? name : name.substr(0, dot);
+}
+
+// Worker `job` of `jobs` handles every jobs-th replay
+Totals runWorker(const std::vector<std::string> &files, int job, int jobs, const std::string &outDir, bool cast) {
+    Totals totals;
+    std::memset(&totals, 0, sizeof(totals));
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    for (size_t i = job; i < files.size(); i += jobs) {
+        std::string output = outDir + "/" + baseName(files[i]) + (cast ? ".cast" : ".frames");
+        if (transcode(files[i], output, cast, totals)) {
+            totals.replays++;
+        } else {
+            totals.failed++;
+            fprintf(stderr, "cannot transcode %s\n", files[i].c_str());
+        }
+    }
+
+    totals.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return totals;
+}
+
+void usage(const char *name) {
+    printf("Usage: %s [--format=cast|frames] [--jobs=N] [--out=DIR] REPLAY_DIR\n", name);
+}
+
+int main(int argc, char **argv) {
+
+    bool cast = true;
+    int jobs = static_cast<int>(std::thread::hardware_concurrency());
+    std::string inDir;
+    std::string outDir;
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        if (std::strcmp(arg, "--format=cast") == 0) cast = true;
+        else if (std::strcmp(arg, "--format=frames") == 0) cast = false;
+        else if (std::strncmp(arg, "--jobs=", 7) == 0) jobs = std::atoi(arg + 7);
+        else if (std::strncmp(arg, "--out=", 6) == 0) outDir = arg + 6;
+        else if (arg[0] != '-' && inDir.empty()) inDir = arg;
+        else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (inDir.empty()) {
+        usage(argv[0]);
+        return 1;
+    }
+    if (outDir.empty()) outDir = inDir;
+    if (jobs < 1) jobs = 1;
+
+    DIR *dir = opendir(inDir.c_str());
+    if (dir == nullptr) {
+        fprintf(stderr, "cannot open %s\n", inDir.c_str());
+        return 1;
+    }
+    std::vector<std::string> files;
+    for (dirent *entry = readdir(dir); entry != nullptr; entry = readdir(dir)) {
+        std::string name = entry->d_name;
+        if (name.size() > 4 && name.compare(name.size() - 4, 4, ".tsr") == 0) {
+            files.push_back(inDir + "/" + name);
+        }
+    }
+    closedir(dir);
+    std::sort(files.begin(), files.end());
+    if (static_cast<int>(files.size()) < jobs) jobs = files.empty() ? 1 : static_cast<int>(files.size());
+
+    // The renderer keeps its screen in globals, so workers are processes
+    std::vector<int> pipes;
+    std::vector<pid_t> workers;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int job = 0; job < jobs; job++) {
+        int fds[2];
+        if (pipe(fds) != 0) return 1;
+
+        pid_t pid = fork();
+        if (pid == 0) {
+            close(fds[0]);
+            Totals totals = runWorker(files, job, jobs, outDir, cast);
+            ssize_t written = write(fds[1], &totals, sizeof(totals));
+            _exit(written == sizeof(totals) ? 0 : 1);
+        }
+        close(fds[1]);
+        pipes.push_back(fds[0]);
+        workers.push_back(pid);
+    }
+
+    Totals sum;
+    std::memset(&sum, 0, sizeof(sum));
+    double busy = 0;
+    for (int job = 0; job < jobs; job++) {
+        Totals totals;
+        bool complete = read(pipes[job], &totals, sizeof(totals)) == sizeof(totals);
+        if (complete) {
+            sum.replays += totals.replays;
+            sum.failed += totals.failed;
+            sum.ticks += totals.ticks;
+            sum.frames += totals.frames;
+            sum.bytes += totals.bytes;
+            busy += totals.seconds;
+        }
+        close(pipes[job]);
+
+        // A worker that crashed took its replays with it: that is a failure too
+        int status = 0;
+        if (workers[job] < 0 || waitpid(workers[job], &status, 0) != workers[job] ||
+            !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            complete = false;
+        }
+        if (!complete) {
+            sum.failed++;
+            if (workers[job] > 0 && WIFSIGNALED(status)) {
+                fprintf(stderr, "worker %d killed by signal %d\n", job, WTERMSIG(status));
+            } else {
+                fprintf(stderr, "worker %d did not finish\n", job);
+            }
+        }
+    }
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // Game time covered per second of worker time
+    double gameSeconds = sum.ticks * DELAY / 1000.0;
+    printf("replays: %lu transcoded, %lu failed, %d jobs\n", sum.replays, sum.failed, jobs);
+    printf("frames: %lu (%lu ticks), %.1f KB\n", sum.frames, sum.ticks, sum.bytes / 1024.0);
+    printf("speed: %.0fx realtime per core, %.0fx realtime overall (%.2fs wall)\n",
+           busy > 0 ? gameSeconds / busy : 0.0, wall > 0 ? gameSeconds / wall : 0.0, wall);
+    return sum.failed == 0 ? 0 : 1;
+}